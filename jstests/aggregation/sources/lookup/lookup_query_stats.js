@@ -28,6 +28,19 @@ const kExecutionStats = "executionStats";
 const kAllPlansExecution = "allPlansExecution";
 const kQueryPlanner = "queryPlanner";
 
+// The expected stats below assume that $lookup queries the foreign collection once per local
+// document, so disable batching and the hash join for the duration of the test.
+const originalParams = assert.commandWorked(db.adminCommand({
+    getParameter: 1,
+    internalDocumentSourceLookupBatchSize: 1,
+    internalDocumentSourceLookupHashJoinMaxMemoryBytes: 1
+}));
+assert.commandWorked(db.adminCommand({
+    setParameter: 1,
+    internalDocumentSourceLookupBatchSize: 1,
+    internalDocumentSourceLookupHashJoinMaxMemoryBytes: 0
+}));
+
 // Keeps track of the last query execution stats.
 let lastScannedObjects = 0;
 let lastScannedKeys = 0;
@@ -188,4 +201,11 @@ getCurrentQueryExecutorStats();
 
 testQueryExecutorStatsWithCollectionScan();
 testQueryExecutorStatsWithIndexScan();
+
+assert.commandWorked(db.adminCommand({
+    setParameter: 1,
+    internalDocumentSourceLookupBatchSize: originalParams.internalDocumentSourceLookupBatchSize,
+    internalDocumentSourceLookupHashJoinMaxMemoryBytes:
+        originalParams.internalDocumentSourceLookupHashJoinMaxMemoryBytes
+}));
 }());
@@ -322,6 +322,249 @@ Future<executor::RemoteCommandResponse> AsyncDBClient::runCommandRequest(
         });
 }
 
+Future<executor::RemoteCommandResponse> AsyncDBClient::runMultiplexedCommandRequest(
+    executor::RemoteCommandRequest request,
+    int32_t msgId,
+    const transport::ReactorHandle& reactor) {
+    invariant(_negotiatedProtocol);
+    auto startTimer = Timer();
+    auto opMsgRequest = OpMsgRequest::fromDBAndBody(
+        std::move(request.dbname), std::move(request.cmdObj), std::move(request.metadata));
+    auto requestMsg = rpc::messageFromOpMsgRequest(*_negotiatedProtocol, std::move(opMsgRequest));
+    auto fireAndForget =
+        request.fireAndForgetMode == executor::RemoteCommandRequest::FireAndForgetMode::kOn;
+    if (fireAndForget) {
+        OpMsg::setFlag(&requestMsg, OpMsg::kMoreToCome);
+    }
+
+    auto [sendPromise, sendFuture] = makePromiseFuture<void>();
+    auto [replyPromise, replyFuture] = makePromiseFuture<Message>();
+    {
+        stdx::lock_guard lk(_multiplexMutex);
+        if (!_multiplexStatus.isOK()) {
+            return _multiplexStatus;
+        }
+
+        _multiplexReactor = reactor;
+        MultiplexedSend send{std::move(requestMsg), msgId, boost::none};
+        if (fireAndForget) {
+            send.promise = std::move(sendPromise);
+        } else {
+            _awaitingReply.emplace(msgId, std::move(replyPromise));
+        }
+        _toSend.push_back(std::move(send));
+        _pumpMultiplexed(lk);
+    }
+
+    if (fireAndForget) {
+        return std::move(sendFuture).then([msgId, startTimer = std::move(startTimer)] {
+            // Return a mock status OK response since we do not expect a real response.
+            OpMsgBuilder builder;
+            builder.setBody(BSON("ok" << 1));
+            Message responseMsg = builder.finish();
+            responseMsg.header().setResponseToMsgId(msgId);
+            responseMsg.header().setId(msgId);
+            rpc::UniqueReply response(responseMsg, rpc::makeReply(&responseMsg));
+            return executor::RemoteCommandResponse(*response, startTimer.elapsed());
+        });
+    }
+
+    return std::move(replyFuture)
+        .then([startTimer = std::move(startTimer)](Message responseMsg) {
+            rpc::UniqueReply response(responseMsg, rpc::makeReply(&responseMsg));
+            return executor::RemoteCommandResponse(*response, startTimer.elapsed());
+        });
+}
+
+void AsyncDBClient::cancelMultiplexedRequest(int32_t msgId) {
+    boost::optional<MultiplexedSend> unsent;
+    boost::optional<Promise<Message>> replyPromise;
+    {
+        stdx::lock_guard lk(_multiplexMutex);
+        auto sendIt = std::find_if(_toSend.begin(), _toSend.end(), [&](const auto& send) {
+            return send.msgId == msgId;
+        });
+        if (sendIt != _toSend.end()) {
+            unsent = std::move(*sendIt);
+            _toSend.erase(sendIt);
+        }
+
+        auto replyIt = _awaitingReply.find(msgId);
+        if (replyIt != _awaitingReply.end()) {
+            replyPromise = std::move(replyIt->second);
+            _awaitingReply.erase(replyIt);
+            if (!unsent) {
+                // The request is already on the wire, so its reply still has to be read.
+                ++_abandonedReplies;
+            }
+        }
+    }
+
+    Status status(ErrorCodes::CallbackCanceled, "Multiplexed request was canceled");
+    if (unsent && unsent->promise) {
+        unsent->promise->setError(status);
+    }
+    if (replyPromise) {
+        replyPromise->setError(status);
+    }
+}
+
+Status AsyncDBClient::getMultiplexingStatus() {
+    stdx::lock_guard lk(_multiplexMutex);
+    return _multiplexStatus;
+}
+
+bool AsyncDBClient::hasMultiplexedRequestsInFlight() {
+    stdx::lock_guard lk(_multiplexMutex);
+    return _sending || _receiving || !_toSend.empty() || !_awaitingReply.empty() ||
+        _abandonedReplies > 0;
+}
+
+bool AsyncDBClient::canMultiplexMoreRequests() {
+    stdx::lock_guard lk(_multiplexMutex);
+    return _multiplexStatus.isOK() && _abandonedReplies == 0;
+}
+
+void AsyncDBClient::_pumpMultiplexed(WithLock) {
+    if (!_multiplexStatus.isOK()) {
+        return;
+    }
+
+    const bool send = !_sending && !_toSend.empty();
+    const bool receive = !_receiving && (!_awaitingReply.empty() || _abandonedReplies > 0);
+    if (!send && !receive) {
+        return;
+    }
+
+    _sending |= send;
+    _receiving |= receive;
+
+    // Both directions are driven from the reactor so that the write and the read in progress on
+    // the session are never started from two threads at once.
+    _multiplexReactor->schedule(
+        [this, self = shared_from_this(), send, receive](Status status) {
+            if (!status.isOK()) {
+                _failMultiplexed(std::move(status));
+                return;
+            }
+
+            if (send) {
+                _sendMultiplexed();
+            }
+            if (receive) {
+                _receiveMultiplexed();
+            }
+        });
+}
+
+void AsyncDBClient::_sendMultiplexed() {
+    boost::optional<MultiplexedSend> next;
+    {
+        stdx::lock_guard lk(_multiplexMutex);
+        if (_toSend.empty()) {
+            // Everything queued was canceled before it could be written.
+            _sending = false;
+            return;
+        }
+
+        next = std::move(_toSend.front());
+        _toSend.pop_front();
+    }
+
+    // Messages are compressed as they are written, which keeps any streaming compressor state in
+    // the order the peer decompresses in.
+    _call(std::move(next->message), next->msgId)
+        .getAsync([this, self = shared_from_this(), promise = std::move(next->promise)](
+                      Status status) mutable {
+            if (!status.isOK()) {
+                if (promise) {
+                    promise->setError(status);
+                }
+                _failMultiplexed(std::move(status));
+                return;
+            }
+
+            {
+                stdx::lock_guard lk(_multiplexMutex);
+                _sending = false;
+                _pumpMultiplexed(lk);
+            }
+
+            if (promise) {
+                promise->emplaceValue();
+            }
+        });
+}
+
+void AsyncDBClient::_receiveMultiplexed() {
+    _waitForResponse(boost::none)
+        .getAsync([this, self = shared_from_this()](StatusWith<Message> swResponse) {
+            if (!swResponse.isOK()) {
+                _failMultiplexed(swResponse.getStatus());
+                return;
+            }
+
+            auto& response = swResponse.getValue();
+            if (OpMsg::isFlagSet(response, OpMsg::kMoreToCome)) {
+                _failMultiplexed(Status(ErrorCodes::ProtocolError,
+                                        "Received a moreToCome reply to a multiplexed request"));
+                return;
+            }
+
+            boost::optional<Promise<Message>> replyPromise;
+            {
+                stdx::lock_guard lk(_multiplexMutex);
+                _receiving = false;
+
+                auto it = _awaitingReply.find(response.header().getResponseToMsgId());
+                if (it != _awaitingReply.end()) {
+                    replyPromise = std::move(it->second);
+                    _awaitingReply.erase(it);
+                } else if (_abandonedReplies > 0) {
+                    --_abandonedReplies;
+                }
+
+                _pumpMultiplexed(lk);
+            }
+
+            if (replyPromise) {
+                replyPromise->emplaceValue(std::move(response));
+            }
+        });
+}
+
+void AsyncDBClient::_failMultiplexed(Status status) {
+    std::deque<MultiplexedSend> toSend;
+    stdx::unordered_map<int32_t, Promise<Message>> awaitingReply;
+    {
+        stdx::lock_guard lk(_multiplexMutex);
+        if (_multiplexStatus.isOK()) {
+            _multiplexStatus = status;
+        }
+
+        toSend = std::exchange(_toSend, {});
+        awaitingReply = std::exchange(_awaitingReply, {});
+        _abandonedReplies = 0;
+    }
+
+    LOGV2_DEBUG(5933201,
+                2,
+                "Multiplexed connection failed",
+                "remote"_attr = _peer,
+                "error"_attr = status);
+
+    _session->end();
+
+    for (auto& send : toSend) {
+        if (send.promise) {
+            send.promise->setError(status);
+        }
+    }
+    for (auto& [msgId, replyPromise] : awaitingReply) {
+        replyPromise.setError(status);
+    }
+}
+
 Future<executor::RemoteCommandResponse> AsyncDBClient::_continueReceiveExhaustResponse(
     ClockSource::StopWatch stopwatch, boost::optional<int32_t> msgId, const BatonHandle& baton) {
     return _waitForResponse(msgId, baton)
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 
 #include "mongo/client/authenticate.h"
@@ -36,12 +37,15 @@
 #include "mongo/executor/network_connection_hook.h"
 #include "mongo/executor/remote_command_request.h"
 #include "mongo/executor/remote_command_response.h"
+#include "mongo/platform/mutex.h"
 #include "mongo/rpc/protocol.h"
 #include "mongo/rpc/unique_message.h"
+#include "mongo/stdx/unordered_map.h"
 #include "mongo/transport/baton.h"
 #include "mongo/transport/message_compressor_manager.h"
 #include "mongo/transport/ssl_connection_context.h"
 #include "mongo/transport/transport_layer.h"
+#include "mongo/util/concurrency/with_lock.h"
 #include "mongo/util/future.h"
 
 namespace mongo {
@@ -75,6 +79,46 @@ public:
                                                               const BatonHandle& baton = nullptr);
     Future<executor::RemoteCommandResponse> awaitExhaustCommand(const BatonHandle& baton = nullptr);
 
+    /**
+     * Runs 'request' over this client's connection alongside any other multiplexed requests that
+     * are in flight on it. Requests are written in the order they are submitted and their replies
+     * are matched back to them by responseTo, so 'msgId' must be unique to the request. The socket
+     * operations are started on 'reactor'. If the connection fails, every multiplexed request on it
+     * fails with the same status and the session is ended.
+     *
+     * Multiplexed requests must not be mixed with the other operations of this client; only once
+     * getMultiplexingStatus() is OK may the connection be used for them again.
+     */
+    Future<executor::RemoteCommandResponse> runMultiplexedCommandRequest(
+        executor::RemoteCommandRequest request,
+        int32_t msgId,
+        const transport::ReactorHandle& reactor);
+
+    /**
+     * Fails the multiplexed request 'msgId' with CallbackCanceled. Unlike cancel(), this leaves the
+     * connection and the other requests in flight on it alone: a reply that arrives later for
+     * 'msgId' is read and discarded.
+     */
+    void cancelMultiplexedRequest(int32_t msgId);
+
+    /**
+     * Returns the error that failed the multiplexed requests on this connection, or OK.
+     */
+    Status getMultiplexingStatus();
+
+    /**
+     * Returns true while a multiplexed request is waiting to be written or for its reply, including
+     * the replies to canceled requests.
+     */
+    bool hasMultiplexedRequestsInFlight();
+
+    /**
+     * Returns true if more requests may be multiplexed over this connection: none of them failed
+     * it, and none was canceled while its reply is still outstanding. Such a reply may never come,
+     * and the remote host would run anything queued behind it only after it.
+     */
+    bool canMultiplexMoreRequests();
+
     Future<void> authenticate(const BSONObj& params);
 
     Future<void> authenticateInternal(
@@ -99,6 +143,19 @@ public:
     const HostAndPort& local() const;
 
 private:
+    struct MultiplexedSend {
+        Message message;
+        int32_t msgId;
+
+        // Only set for fire-and-forget requests, which are done once they are written.
+        boost::optional<Promise<void>> promise;
+    };
+
+    void _pumpMultiplexed(WithLock);
+    void _sendMultiplexed();
+    void _receiveMultiplexed();
+    void _failMultiplexed(Status status);
+
     Future<executor::RemoteCommandResponse> _continueReceiveExhaustResponse(
         ClockSource::StopWatch stopwatch,
         boost::optional<int32_t> msgId,
@@ -117,6 +174,17 @@ private:
     ServiceContext* const _svcCtx;
     MessageCompressorManager _compressorManager;
     boost::optional<rpc::Protocol> _negotiatedProtocol;
+
+    // State of the requests multiplexed over this connection. At most one write and one read are
+    // in progress at any time, both started on _multiplexReactor.
+    Mutex _multiplexMutex = MONGO_MAKE_LATCH("AsyncDBClient::_multiplexMutex");
+    transport::ReactorHandle _multiplexReactor;
+    std::deque<MultiplexedSend> _toSend;
+    stdx::unordered_map<int32_t, Promise<Message>> _awaitingReply;
+    size_t _abandonedReplies = 0;
+    bool _sending = false;
+    bool _receiving = false;
+    Status _multiplexStatus = Status::OK();
 };
 
 }  // namespace mongo
@@ -0,0 +1,354 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <deque>
+
+#include "mongo/client/async_client.h"
+#include "mongo/db/service_context_test_fixture.h"
+#include "mongo/db/wire_version.h"
+#include "mongo/executor/remote_command_request.h"
+#include "mongo/rpc/legacy_reply_builder.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/transport/mock_session.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const HostAndPort kPeer("peer", 27017);
+const Status kSessionEndedStatus(ErrorCodes::HostUnreachable, "Session was ended");
+
+/**
+ * A session whose remote end is played by the test. It records the messages written to it, and
+ * each read returns the next reply passed to reply(), waiting for it if necessary.
+ */
+class ScriptedSession final : public transport::MockSessionBase {
+public:
+    transport::TransportLayer* getTransportLayer() const override {
+        return nullptr;
+    }
+
+    void end() override {
+        stdx::unique_lock lk(_mutex);
+        _ended = true;
+        auto pendingRead = std::exchange(_pendingRead, boost::none);
+        lk.unlock();
+
+        if (pendingRead) {
+            pendingRead->setError(kSessionEndedStatus);
+        }
+    }
+
+    bool ended() {
+        stdx::lock_guard lk(_mutex);
+        return _ended;
+    }
+
+    StatusWith<Message> sourceMessage() noexcept override {
+        MONGO_UNREACHABLE;
+    }
+
+    Future<Message> asyncSourceMessage(const BatonHandle& handle = nullptr) noexcept override {
+        stdx::lock_guard lk(_mutex);
+        if (_ended) {
+            return kSessionEndedStatus;
+        }
+        if (!_replies.empty()) {
+            auto reply = std::move(_replies.front());
+            _replies.pop_front();
+            return reply;
+        }
+
+        invariant(!_pendingRead);
+        auto pf = makePromiseFuture<Message>();
+        _pendingRead = std::move(pf.promise);
+        return std::move(pf.future);
+    }
+
+    Status waitForData() noexcept override {
+        MONGO_UNREACHABLE;
+    }
+
+    Future<void> asyncWaitForData() noexcept override {
+        MONGO_UNREACHABLE;
+    }
+
+    Status sinkMessage(Message message) noexcept override {
+        MONGO_UNREACHABLE;
+    }
+
+    Future<void> asyncSinkMessage(Message message,
+                                  const BatonHandle& handle = nullptr) noexcept override {
+        stdx::lock_guard lk(_mutex);
+        if (_ended) {
+            return kSessionEndedStatus;
+        }
+        _written.push_back(std::move(message));
+        return Future<void>::makeReady();
+    }
+
+    /**
+     * Makes the next read return 'reply', which may be an error.
+     */
+    void reply(StatusWith<Message> reply) {
+        stdx::unique_lock lk(_mutex);
+        if (!_pendingRead) {
+            _replies.push_back(std::move(reply));
+            return;
+        }
+        auto pendingRead = std::exchange(_pendingRead, boost::none);
+        lk.unlock();
+
+        pendingRead->setFrom(std::move(reply));
+    }
+
+    std::vector<int32_t> writtenIds() {
+        stdx::lock_guard lk(_mutex);
+        std::vector<int32_t> ids;
+        for (auto&& message : _written) {
+            ids.push_back(message.header().getId());
+        }
+        return ids;
+    }
+
+private:
+    Mutex _mutex = MONGO_MAKE_LATCH("ScriptedSession::_mutex");
+    bool _ended = false;
+    std::vector<Message> _written;
+    std::deque<StatusWith<Message>> _replies;
+    boost::optional<Promise<Message>> _pendingRead;
+};
+
+/**
+ * A reactor which only runs the tasks scheduled on it when the test drains it.
+ */
+class ManualReactor final : public transport::Reactor {
+public:
+    void run() noexcept override {
+        MONGO_UNREACHABLE;
+    }
+
+    void runFor(Milliseconds time) noexcept override {
+        MONGO_UNREACHABLE;
+    }
+
+    void stop() override {}
+
+    void drain() override {
+        while (true) {
+            Task task;
+            {
+                stdx::lock_guard lk(_mutex);
+                if (_tasks.empty()) {
+                    return;
+                }
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+            task(Status::OK());
+        }
+    }
+
+    void schedule(Task task) override {
+        stdx::lock_guard lk(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+
+    void dispatch(Task task) override {
+        schedule(std::move(task));
+    }
+
+    bool onReactorThread() const override {
+        return false;
+    }
+
+    std::unique_ptr<transport::ReactorTimer> makeTimer() override {
+        MONGO_UNREACHABLE;
+    }
+
+    Date_t now() override {
+        return Date_t::now();
+    }
+
+private:
+    Mutex _mutex = MONGO_MAKE_LATCH("ManualReactor::_mutex");
+    std::deque<Task> _tasks;
+};
+
+class AsyncDBClientMultiplexingTest : public ServiceContextTest {
+public:
+    void setUp() override {
+        _session = std::make_shared<ScriptedSession>();
+        _reactor = std::make_shared<ManualReactor>();
+        _client = std::make_shared<AsyncDBClient>(kPeer, _session, getServiceContext());
+
+        // Negotiate OP_MSG, which multiplexed requests are sent with.
+        auto helloFuture = _client->initWireVersion("AsyncDBClientMultiplexingTest", nullptr);
+        const auto helloReplyBody = BSON("ok" << 1 << "ismaster" << true << "minWireVersion" << 0
+                                              << "maxWireVersion"
+                                              << WireVersion::LATEST_WIRE_VERSION);
+        auto helloReply = rpc::LegacyReplyBuilder().setRawCommandReply(helloReplyBody).done();
+        helloReply.header().setResponseToMsgId(_session->writtenIds().front());
+        _session->reply(std::move(helloReply));
+        helloFuture.get();
+    }
+
+protected:
+    Future<executor::RemoteCommandResponse> startRequest(int32_t msgId) {
+        executor::RemoteCommandRequest request(
+            kPeer, "admin", BSON("ping" << 1 << "msgId" << msgId), nullptr);
+        return _client->runMultiplexedCommandRequest(std::move(request), msgId, _reactor);
+    }
+
+    static Message makeReply(int32_t responseTo, const BSONObj& body) {
+        OpMsgBuilder builder;
+        builder.setBody(body);
+        Message reply = builder.finish();
+        reply.header().setId(nextMessageId());
+        reply.header().setResponseToMsgId(responseTo);
+        return reply;
+    }
+
+    std::shared_ptr<ScriptedSession> _session;
+    std::shared_ptr<ManualReactor> _reactor;
+    std::shared_ptr<AsyncDBClient> _client;
+};
+
+TEST_F(AsyncDBClientMultiplexingTest, MatchesRepliesToRequestsByResponseTo) {
+    auto first = startRequest(1);
+    auto second = startRequest(2);
+    _reactor->drain();
+    ASSERT_EQ(_session->writtenIds().size(), 3UL);  // Including the hello.
+
+    // The replies may arrive in any order.
+    _session->reply(makeReply(2, BSON("ok" << 1 << "n" << 2)));
+    _reactor->drain();
+    ASSERT_TRUE(second.isReady());
+    ASSERT_FALSE(first.isReady());
+    ASSERT_BSONOBJ_EQ(second.get().data, BSON("ok" << 1 << "n" << 2));
+    ASSERT_TRUE(_client->hasMultiplexedRequestsInFlight());
+
+    _session->reply(makeReply(1, BSON("ok" << 1 << "n" << 1)));
+    _reactor->drain();
+    ASSERT_BSONOBJ_EQ(first.get().data, BSON("ok" << 1 << "n" << 1));
+    ASSERT_FALSE(_client->hasMultiplexedRequestsInFlight());
+    ASSERT_TRUE(_client->canMultiplexMoreRequests());
+}
+
+TEST_F(AsyncDBClientMultiplexingTest, CancelingARequestLeavesTheOthersInFlight) {
+    auto first = startRequest(1);
+    auto second = startRequest(2);
+    auto third = startRequest(3);
+    _reactor->drain();
+
+    _client->cancelMultiplexedRequest(2);
+    ASSERT_EQ(second.getNoThrow(), ErrorCodes::CallbackCanceled);
+    ASSERT_FALSE(first.isReady());
+    ASSERT_FALSE(third.isReady());
+
+    // The canceled request's reply is still on its way, so the connection takes no more requests
+    // until it has been read and discarded.
+    ASSERT_OK(_client->getMultiplexingStatus());
+    ASSERT_FALSE(_client->canMultiplexMoreRequests());
+
+    _session->reply(makeReply(2, BSON("ok" << 1 << "n" << 2)));
+    _reactor->drain();
+    ASSERT_FALSE(first.isReady());
+    ASSERT_FALSE(third.isReady());
+    ASSERT_TRUE(_client->canMultiplexMoreRequests());
+
+    _session->reply(makeReply(3, BSON("ok" << 1 << "n" << 3)));
+    _reactor->drain();
+    _session->reply(makeReply(1, BSON("ok" << 1 << "n" << 1)));
+    _reactor->drain();
+    ASSERT_BSONOBJ_EQ(first.get().data, BSON("ok" << 1 << "n" << 1));
+    ASSERT_BSONOBJ_EQ(third.get().data, BSON("ok" << 1 << "n" << 3));
+    ASSERT_FALSE(_client->hasMultiplexedRequestsInFlight());
+    ASSERT_FALSE(_session->ended());
+}
+
+TEST_F(AsyncDBClientMultiplexingTest, CancelingAnUnsentRequestDoesNotWriteIt) {
+    auto first = startRequest(1);
+    auto second = startRequest(2);
+    _client->cancelMultiplexedRequest(2);
+    ASSERT_EQ(second.getNoThrow(), ErrorCodes::CallbackCanceled);
+    _reactor->drain();
+
+    // Only the hello and the first request were written, so no reply is owed for the second.
+    ASSERT_EQ(_session->writtenIds().size(), 2UL);
+    ASSERT_EQ(_session->writtenIds().back(), 1);
+    ASSERT_TRUE(_client->canMultiplexMoreRequests());
+
+    _session->reply(makeReply(1, BSON("ok" << 1)));
+    _reactor->drain();
+    ASSERT_OK(first.getNoThrow());
+}
+
+TEST_F(AsyncDBClientMultiplexingTest, ConnectionFailureFailsEveryRequestInFlight) {
+    auto first = startRequest(1);
+    auto second = startRequest(2);
+    _reactor->drain();
+    _client->cancelMultiplexedRequest(1);
+    ASSERT_EQ(first.getNoThrow(), ErrorCodes::CallbackCanceled);
+
+    auto third = startRequest(3);
+    const Status resetStatus(ErrorCodes::HostUnreachable, "Connection reset by peer");
+    _session->reply(resetStatus);
+    _reactor->drain();
+
+    // Every request on the connection fails with the same status, and the session is ended.
+    ASSERT_EQ(second.getNoThrow(), resetStatus);
+    ASSERT_EQ(third.getNoThrow(), resetStatus);
+    ASSERT_EQ(_client->getMultiplexingStatus(), resetStatus);
+    ASSERT_FALSE(_client->canMultiplexMoreRequests());
+    ASSERT_TRUE(_session->ended());
+
+    // Later requests fail right away.
+    ASSERT_EQ(startRequest(4).getNoThrow(), resetStatus);
+}
+
+TEST_F(AsyncDBClientMultiplexingTest, MoreToComeReplyFailsTheConnection) {
+    auto first = startRequest(1);
+    auto second = startRequest(2);
+    _reactor->drain();
+
+    auto reply = makeReply(1, BSON("ok" << 1));
+    OpMsg::setFlag(&reply, OpMsg::kMoreToCome);
+    _session->reply(std::move(reply));
+    _reactor->drain();
+
+    ASSERT_EQ(first.getNoThrow(), ErrorCodes::ProtocolError);
+    ASSERT_EQ(second.getNoThrow(), ErrorCodes::ProtocolError);
+    ASSERT_TRUE(_session->ended());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -32,6 +32,7 @@
 #include "mongo/config.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/transport/message_compressor_registry.h"
+#include "mongo/transport/network_latency_metrics.h"
 #include "mongo/transport/service_entry_point.h"
 #include "mongo/transport/service_executor_fixed.h"
 #include "mongo/transport/service_executor_reserved.h"
@@ -85,6 +86,7 @@ public:
         BSONObjBuilder b;
         networkCounter.append(b);
         appendMessageCompressionStats(&b);
+        transport::appendNetworkLatencyStats(opCtx->getServiceContext(), &b);
 
         {
             BSONObjBuilder section = b.subobjStart("serviceExecutors");
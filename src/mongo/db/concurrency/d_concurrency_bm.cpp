@@ -42,6 +42,13 @@ namespace {
 
 const int kMaxPerfThreads = 16;  // max number of threads to use for lock perf
 
+// Max number of threads for the intent lock benchmarks, which should scale with the number of
+// cores as long as no conflicting lock is requested.
+const int kMaxIntentLockThreads = 128;
+
+// How often the conflicting benchmark takes an exclusive database lock.
+const int kIterationsPerConflict = 1000;
+
 
 class DConcurrencyTest : public benchmark::Fixture {
 public:
@@ -122,6 +129,31 @@ BENCHMARK_DEFINE_F(DConcurrencyTest, BM_CollectionIntentExclusiveLock)(benchmark
     }
 }
 
+BENCHMARK_DEFINE_F(DConcurrencyTest, BM_CollectionIntentExclusiveLockWithConflicts)
+(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        makeKClientsWithLockers(state.threads);
+    }
+
+    // Thread 0 periodically takes the database lock in MODE_X, which moves every granted intent
+    // lock out of the lock manager partitions and back onto the shared lock head.
+    int iteration = 0;
+    for (auto keepRunning : state) {
+        auto opCtx = clients[state.thread_index].second.get();
+        if (state.thread_index == 0 && ++iteration % kIterationsPerConflict == 0) {
+            Lock::DBLock dlk(opCtx, "test", MODE_X);
+            continue;
+        }
+
+        Lock::DBLock dlk(opCtx, "test", MODE_IX);
+        Lock::CollectionLock clk(opCtx, NamespaceString("test.coll"), MODE_IX);
+    }
+
+    if (state.thread_index == 0) {
+        clients.clear();
+    }
+}
+
 BENCHMARK_DEFINE_F(DConcurrencyTest, BM_CollectionSharedLock)(benchmark::State& state) {
     if (state.thread_index == 0) {
         makeKClientsWithLockers(state.threads);
@@ -160,9 +192,11 @@ BENCHMARK_REGISTER_F(DConcurrencyTest, BM_ResourceMutexShared)->ThreadRange(1, k
 BENCHMARK_REGISTER_F(DConcurrencyTest, BM_ResourceMutexExclusive)->ThreadRange(1, kMaxPerfThreads);
 
 BENCHMARK_REGISTER_F(DConcurrencyTest, BM_CollectionIntentSharedLock)
-    ->ThreadRange(1, kMaxPerfThreads);
+    ->ThreadRange(1, kMaxIntentLockThreads);
 BENCHMARK_REGISTER_F(DConcurrencyTest, BM_CollectionIntentExclusiveLock)
-    ->ThreadRange(1, kMaxPerfThreads);
+    ->ThreadRange(1, kMaxIntentLockThreads);
+BENCHMARK_REGISTER_F(DConcurrencyTest, BM_CollectionIntentExclusiveLockWithConflicts)
+    ->ThreadRange(1, kMaxIntentLockThreads);
 
 BENCHMARK_REGISTER_F(DConcurrencyTest, BM_CollectionSharedLock)->ThreadRange(1, kMaxPerfThreads);
 BENCHMARK_REGISTER_F(DConcurrencyTest, BM_CollectionExclusiveLock)->ThreadRange(1, kMaxPerfThreads);
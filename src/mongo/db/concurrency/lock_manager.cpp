@@ -45,6 +45,7 @@
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/locker.h"
 #include "mongo/logv2/log.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/str.h"
 #include "mongo/util/timer.h"
@@ -413,9 +414,28 @@ void LockHead::migratePartitionedLockHeads() {
 // Have more buckets than CPUs to reduce contention on lock and caches
 const unsigned LockManager::_numLockBuckets(128);
 
-// Balance scalability of intent locks against potential added cost of conflicting locks.
-// The exact value doesn't appear very important, but should be power of two
-const unsigned LockManager::_numPartitions = 32;
+namespace {
+
+// Balance scalability of intent locks against potential added cost of conflicting locks, which
+// must migrate the requests out of every partition that holds them. Use at least
+// kMinPartitions, and beyond that two per core so that the lockers of concurrently running
+// operations, whose ids are mostly consecutive, land in different partitions. Always a power of
+// two.
+const unsigned kMinPartitions = 32;
+const unsigned kMaxPartitions = 1024;
+
+unsigned computeNumPartitions() {
+    // The global LockManager is constructed during static initialization, so ask the standard
+    // library rather than ProcessInfo.
+    const auto wanted = 2 * stdx::thread::hardware_concurrency();
+    unsigned numPartitions = kMinPartitions;
+    while (numPartitions < wanted && numPartitions < kMaxPartitions) {
+        numPartitions *= 2;
+    }
+    return numPartitions;
+}
+
+}  // namespace
 
 // static
 std::map<LockerId, BSONObj> LockManager::getLockToClientMap(ServiceContext* serviceContext) {
@@ -443,7 +463,7 @@ std::map<LockerId, BSONObj> LockManager::getLockToClientMap(ServiceContext* serv
     return lockToClientMap;
 }
 
-LockManager::LockManager() {
+LockManager::LockManager() : _numPartitions(computeNumPartitions()) {
     _lockBuckets = new LockBucket[_numLockBuckets];
     _partitions = new Partition[_numPartitions];
 }
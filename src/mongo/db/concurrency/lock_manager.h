@@ -42,6 +42,7 @@
 #include "mongo/platform/compiler.h"
 #include "mongo/platform/mutex.h"
 #include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/new.h"
 #include "mongo/stdx/unordered_map.h"
 #include "mongo/util/concurrency/mutex.h"
 
@@ -166,8 +167,9 @@ private:
 
     // Each locker maps to a partition that is used for resources acquired in intent modes
     // modes and potentially other modes that don't conflict with themselves. This avoids
-    // contention on the regular LockHead in the lock manager.
-    struct Partition {
+    // contention on the regular LockHead in the lock manager. Partitions are padded to a cache
+    // line so that lockers on neighbouring partitions do not contend on the same line.
+    struct alignas(stdx::hardware_destructive_interference_size) Partition {
         PartitionedLockHead* find(ResourceId resId);
         PartitionedLockHead* findOrInsert(ResourceId resId);
         typedef stdx::unordered_map<ResourceId, PartitionedLockHead*> Map;
@@ -219,7 +221,9 @@ private:
     static const unsigned _numLockBuckets;
     LockBucket* _lockBuckets;
 
-    static const unsigned _numPartitions;
+    // Sized from the number of cores, so that the lockers of concurrently running operations
+    // rarely share a partition.
+    const unsigned _numPartitions;
     Partition* _partitions;
 };
 }  // namespace mongo
@@ -789,6 +789,10 @@ void CurOp::reportState(OperationContext* opCtx, BSONObjBuilder* builder, bool t
     if (_debug.dataThroughputAverage) {
         builder->append("dataThroughputAverage", *_debug.dataThroughputAverage);
     }
+
+    if (_debug.mergerStallTime > Microseconds{0}) {
+        builder->append("mergerStallMillis", durationCount<Milliseconds>(_debug.mergerStallTime));
+    }
 }
 
 namespace {
@@ -976,6 +980,18 @@ string OpDebug::report(OperationContext* opCtx, const SingleThreadedLockStats* l
         s << " remoteOpWaitMillis:" << durationCount<Milliseconds>(*remoteOpWaitTime);
     }
 
+    if (mergerStallTime > Microseconds{0}) {
+        s << " mergerStallMillis:" << durationCount<Milliseconds>(mergerStallTime);
+    }
+
+    if (sourceMessageTime > Microseconds{0}) {
+        s << " sourceMessageMicros:" << durationCount<Microseconds>(sourceMessageTime);
+    }
+
+    if (schedulingDelay > Microseconds{0}) {
+        s << " schedulingDelayMicros:" << durationCount<Microseconds>(schedulingDelay);
+    }
+
     s << " " << durationCount<Milliseconds>(executionTime) << "ms";
 
     return s.str();
@@ -1169,6 +1185,18 @@ void OpDebug::report(OperationContext* opCtx,
         pAttrs->add("remoteOpWaitMillis", durationCount<Milliseconds>(*remoteOpWaitTime));
     }
 
+    if (mergerStallTime > Microseconds{0}) {
+        pAttrs->add("mergerStallMillis", durationCount<Milliseconds>(mergerStallTime));
+    }
+
+    if (sourceMessageTime > Microseconds{0}) {
+        pAttrs->add("sourceMessageMicros", durationCount<Microseconds>(sourceMessageTime));
+    }
+
+    if (schedulingDelay > Microseconds{0}) {
+        pAttrs->add("schedulingDelayMicros", durationCount<Microseconds>(schedulingDelay));
+    }
+
     pAttrs->add("durationMillis", durationCount<Milliseconds>(executionTime));
 }
 
@@ -1306,6 +1334,18 @@ void OpDebug::append(OperationContext* opCtx,
         b.append("remoteOpWaitMillis", durationCount<Milliseconds>(*remoteOpWaitTime));
     }
 
+    if (mergerStallTime > Microseconds{0}) {
+        b.append("mergerStallMillis", durationCount<Milliseconds>(mergerStallTime));
+    }
+
+    if (sourceMessageTime > Microseconds{0}) {
+        b.append("sourceMessageMicros", durationCount<Microseconds>(sourceMessageTime));
+    }
+
+    if (schedulingDelay > Microseconds{0}) {
+        b.append("schedulingDelayMicros", durationCount<Microseconds>(schedulingDelay));
+    }
+
     b.appendNumber("millis", durationCount<Milliseconds>(executionTime));
 
     if (!curop.getPlanSummary().empty()) {
@@ -1588,6 +1628,24 @@ std::function<BSONObj(ProfileFilter::Args)> OpDebug::appendStaged(StringSet requ
         }
     });
 
+    addIfNeeded("mergerStallMillis", [](auto field, auto args, auto& b) {
+        if (args.op.mergerStallTime > Microseconds{0}) {
+            b.append(field, durationCount<Milliseconds>(args.op.mergerStallTime));
+        }
+    });
+
+    addIfNeeded("sourceMessageMicros", [](auto field, auto args, auto& b) {
+        if (args.op.sourceMessageTime > Microseconds{0}) {
+            b.append(field, durationCount<Microseconds>(args.op.sourceMessageTime));
+        }
+    });
+
+    addIfNeeded("schedulingDelayMicros", [](auto field, auto args, auto& b) {
+        if (args.op.schedulingDelay > Microseconds{0}) {
+            b.append(field, durationCount<Microseconds>(args.op.schedulingDelay));
+        }
+    });
+
     // millis and durationMillis are the same thing. This is one of the few inconsistencies between
     // the profiler (OpDebug::append) and the log file (OpDebug::report), so for the profile filter
     // we support both names.
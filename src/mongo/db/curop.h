@@ -277,6 +277,17 @@ public:
     // Used to track the amount of time spent waiting for a response from remote operations.
     boost::optional<Microseconds> remoteOpWaitTime;
 
+    // Time spent blocked in a results merger because no remote had a buffered result ready. Unlike
+    // 'remoteOpWaitTime' this is always recorded, and is reported only when non-zero. Written and
+    // read under the Client lock so that $currentOp can report it for a running operation.
+    Microseconds mergerStallTime{0};
+
+    // Time the ServiceStateMachine spent reading this operation's request off the network, and
+    // waiting for the ServiceExecutor to run it, before the operation started. Zero when the phase
+    // could not be measured for the session's transport mode, and reported only when non-zero.
+    Microseconds sourceMessageTime{0};
+    Microseconds schedulingDelay{0};
+
     // Stores additive metrics.
     AdditiveMetrics additiveMetrics;
 
@@ -859,6 +859,14 @@ struct DocumentSourceLookupStats : public SpecificStats {
 
     // Tracks the summary stats in aggregate across all executions of the subpipeline.
     PlanSummaryStats planSummaryStats;
+
+    // Whether the join was answered from an in-memory hash table of the foreign collection.
+    bool usedHashJoin = false;
+
+    // The number of batched queries issued for an equality join, and the number of distinct local
+    // values they looked up.
+    long long batches = 0;
+    long long probes = 0;
 };
 
 struct UnionWithStats final : public SpecificStats {
@@ -75,6 +75,7 @@ void ProjectionNode::_addExpressionForPath(const FieldPath& path,
     if (path.getPathLength() == 1) {
         auto fieldName = path.fullPath();
         _expressions[fieldName] = expr;
+        _compiledExpressions.erase(fieldName);
         _orderToProcessAdditionsAndChildren.push_back(fieldName);
         return;
     }
@@ -196,10 +197,12 @@ void ProjectionNode::applyExpressions(const Document& root, MutableDocument* out
         } else {
             auto expressionIt = _expressions.find(field);
             invariant(expressionIt != _expressions.end());
-            outputDoc->setField(
-                field,
-                expressionIt->second->evaluate(
-                    root, &expressionIt->second->getExpressionContext()->variables));
+            auto variables = &expressionIt->second->getExpressionContext()->variables;
+            auto compiledIt = _compiledExpressions.find(field);
+            outputDoc->setField(field,
+                                compiledIt != _compiledExpressions.end()
+                                    ? compiledIt->second->evaluate(root, variables)
+                                    : expressionIt->second->evaluate(root, variables));
         }
     }
 }
@@ -260,6 +263,11 @@ void ProjectionNode::reportComputedPaths(std::set<std::string>* computedPaths,
 void ProjectionNode::optimize() {
     for (auto&& expressionIt : _expressions) {
         _expressions[expressionIt.first] = expressionIt.second->optimize();
+        if (auto compiled = CompiledExpression::compile(expressionIt.second)) {
+            _compiledExpressions[expressionIt.first] = std::move(compiled);
+        } else {
+            _compiledExpressions.erase(expressionIt.first);
+        }
     }
     for (auto&& childPair : _children) {
         childPair.second->optimize();
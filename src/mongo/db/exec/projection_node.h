@@ -30,6 +30,7 @@
 #pragma once
 
 #include "mongo/db/exec/projection_executor.h"
+#include "mongo/db/pipeline/compiled_expression.h"
 
 #include "mongo/db/query/projection_policies.h"
 
@@ -162,6 +163,9 @@ protected:
 
     StringMap<std::unique_ptr<ProjectionNode>> _children;
     StringMap<boost::intrusive_ptr<Expression>> _expressions;
+    // Compiled forms of the entries of '_expressions' which support compilation, built by
+    // optimize() and used in their place by applyExpressions().
+    StringMap<std::unique_ptr<CompiledExpression>> _compiledExpressions;
     StringSet _projectedFields;
     ProjectionPolicies _policies;
     std::string _pathToNode;
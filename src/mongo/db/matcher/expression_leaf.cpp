@@ -44,6 +44,7 @@
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/matcher/path.h"
 #include "mongo/db/query/collation/collator_interface.h"
+#include "mongo/db/query/regex_cache.h"
 #include "mongo/util/regex_util.h"
 #include "mongo/util/str.h"
 
@@ -220,8 +221,7 @@ RegexMatchExpression::RegexMatchExpression(StringData path,
                                            clonable_ptr<ErrorAnnotation> annotation)
     : LeafMatchExpression(REGEX, path, std::move(annotation)),
       _regex(regex.toString()),
-      _flags(options.toString()),
-      _re(new pcrecpp::RE(_regex.c_str(), regex_util::flagsToPcreOptions(_flags, true))) {
+      _flags(options.toString()) {
 
     uassert(ErrorCodes::BadValue,
             "Regular expression cannot contain an embedded null byte",
@@ -231,9 +231,12 @@ RegexMatchExpression::RegexMatchExpression(StringData path,
             "Regular expression options string cannot contain an embedded null byte",
             _flags.find('\0') == std::string::npos);
 
+    auto swRe = RegexCache::get().getOrCompile(
+        _regex, regex_util::flagsToPcreOptions(_flags, true).all_options());
     uassert(51091,
-            str::stream() << "Regular expression is invalid: " << _re->error(),
-            _re->error().empty());
+            str::stream() << "Regular expression is invalid: " << swRe.getStatus().reason(),
+            swRe.isOK());
+    _re = std::move(swRe.getValue());
 }
 
 RegexMatchExpression::~RegexMatchExpression() {}
@@ -252,10 +255,10 @@ bool RegexMatchExpression::matchesSingleElement(const BSONElement& e, MatchDetai
         case String:
         case Symbol: {
             // String values stored in documents can contain embedded NUL bytes. We construct a
-            // pcrecpp::StringPiece instance using the full length of the string to avoid truncating
-            // 'data' early.
-            pcrecpp::StringPiece data(e.valuestr(), e.valuestrsize() - 1);
-            return _re->PartialMatch(data);
+            // StringData instance using the full length of the string to avoid truncating 'data'
+            // early.
+            StringData data(e.valuestr(), e.valuestrsize() - 1);
+            return _re->partialMatch(data);
         }
         case RegEx:
             return _regex == e.regex() && _flags == e.regexFlags();
@@ -48,6 +48,7 @@ class RE;
 namespace mongo {
 
 class CollatorInterface;
+class CompiledRegex;
 
 class LeafMatchExpression : public PathMatchExpression {
 public:
@@ -466,7 +467,8 @@ private:
 
     std::string _regex;
     std::string _flags;
-    std::unique_ptr<pcrecpp::RE> _re;
+    // Shared with other users of the same pattern and flags through the process-wide RegexCache.
+    std::shared_ptr<const CompiledRegex> _re;
 };
 
 class ModMatchExpression : public LeafMatchExpression {
@@ -32,6 +32,7 @@
 #include "mongo/db/catalog/document_validation.h"
 #include "mongo/db/commands/test_commands_enabled.h"
 #include "mongo/db/dbmessage.h"
+#include "mongo/db/ops/update_request.h"
 #include "mongo/db/ops/write_ops.h"
 #include "mongo/db/ops/write_ops_parsers_test_helpers.h"
 #include "mongo/unittest/unittest.h"
@@ -288,6 +289,55 @@ TEST(CommandWriteOpsParsers, MultiInsertWithStmtIdsArray) {
     }
 }
 
+TEST(CommandWriteOpsParsers, InsertDocumentSequenceReferencesReceiveBuffer) {
+    const auto ns = NamespaceString("test", "foo");
+    const BSONObj obj0 = BSON("_id" << 0 << "x" << 0);
+    const BSONObj obj1 = BSON("_id" << 1 << "x" << 1);
+    auto cmd = BSON("insert" << ns.coll() << "documents" << BSON_ARRAY(obj0 << obj1));
+    const auto message = toOpMsg(ns.db(), cmd, true).serialize();
+    const char* const bufBegin = message.buf();
+    const char* const bufEnd = bufBegin + message.size();
+
+    const auto op = InsertOp::parse(OpMsgRequest::parseOwned(message));
+    ASSERT_EQ(op.getDocuments().size(), 2u);
+    ASSERT_BSONOBJ_EQ(op.getDocuments()[0], obj0);
+    ASSERT_BSONOBJ_EQ(op.getDocuments()[1], obj1);
+
+    // Each parsed document must be a view into the received message which keeps that buffer
+    // alive, rather than a separately allocated copy.
+    for (const auto& doc : op.getDocuments()) {
+        ASSERT(doc.isOwned());
+        ASSERT_GTE(doc.objdata(), bufBegin);
+        ASSERT_LTE(doc.objdata() + doc.objsize(), bufEnd);
+    }
+}
+
+TEST(CommandWriteOpsParsers, UpdateDocumentSequenceReferencesReceiveBuffer) {
+    const auto ns = NamespaceString("test", "foo");
+    const BSONObj query = BSON("_id" << 0);
+    const BSONObj update = BSON("$inc" << BSON("x" << 1));
+    auto cmd = BSON("update" << ns.coll() << "updates"
+                             << BSON_ARRAY(BSON("q" << query << "u" << update)));
+    const auto message = toOpMsg(ns.db(), cmd, true).serialize();
+    const char* const bufBegin = message.buf();
+    const char* const bufEnd = bufBegin + message.size();
+
+    auto pointsIntoBuffer = [&](const BSONObj& obj) {
+        return obj.objdata() >= bufBegin && obj.objdata() + obj.objsize() <= bufEnd;
+    };
+
+    const auto op = UpdateOp::parse(OpMsgRequest::parseOwned(message));
+    ASSERT_EQ(op.getUpdates().size(), 1u);
+
+    // The query and update of each entry, and of the UpdateRequest which executes it, must be
+    // views into the received message rather than separately allocated copies.
+    UpdateRequest request(op.getUpdates()[0]);
+    ASSERT_BSONOBJ_EQ(request.getQuery(), query);
+    ASSERT_BSONOBJ_EQ(request.getUpdateModification().getUpdateClassic(), update);
+    ASSERT(pointsIntoBuffer(request.getQuery()));
+    ASSERT(pointsIntoBuffer(request.getUpdateModification().getUpdateClassic()));
+}
+
 TEST(CommandWriteOpsParsers, UpdateCommandRequest) {
     const auto ns = NamespaceString("test", "foo");
     const BSONObj query = BSON("x" << 1);
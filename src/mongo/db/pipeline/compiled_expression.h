@@ -0,0 +1,74 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <functional>
+#include <memory>
+
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/value.h"
+
+namespace mongo {
+
+class Expression;
+class Variables;
+
+/**
+ * An Expression translated into a form which is cheaper to evaluate than walking the Expression
+ * tree. The translation itself lives outside of this library, and is installed with
+ * registerCompiler() by the process which links it in.
+ *
+ * A CompiledExpression evaluates to exactly the same result as the Expression it was built from,
+ * and may hold state between calls, so it must not be shared between threads.
+ */
+class CompiledExpression {
+public:
+    using CompileFn =
+        std::function<std::unique_ptr<CompiledExpression>(boost::intrusive_ptr<Expression>)>;
+
+    virtual ~CompiledExpression() = default;
+
+    /**
+     * Installs the function used by compile(). Must only be called during process startup.
+     */
+    static void registerCompiler(CompileFn compileFn);
+
+    /**
+     * Returns a compiled form of 'expr', or nullptr if compilation is disabled by
+     * 'internalQueryCompileClassicExpressions', if no compiler has been registered, or if 'expr'
+     * uses anything the compiler does not support.
+     */
+    static std::unique_ptr<CompiledExpression> compile(boost::intrusive_ptr<Expression> expr);
+
+    virtual Value evaluate(const Document& root, Variables* variables) = 0;
+};
+
+}  // namespace mongo
@@ -31,6 +31,7 @@
 
 #include "mongo/db/pipeline/document_source_facet.h"
 
+#include <deque>
 #include <memory>
 #include <vector>
 
@@ -38,14 +39,22 @@
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/bson/bsontypes.h"
+#include "mongo/db/client.h"
 #include "mongo/db/exec/document_value/document.h"
 #include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/pipeline/document_source_queue.h"
 #include "mongo/db/pipeline/document_source_tee_consumer.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/field_path.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/pipeline/tee_buffer.h"
+#include "mongo/db/service_context.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
@@ -107,6 +116,251 @@ vector<pair<string, vector<BSONObj>>> extractRawPipelines(const BSONElement& ele
     return rawFacetPipelines;
 }
 
+void assertOutputUnderMemoryLimit(size_t usedBytes, size_t maxBytes) {
+    uassert(4031700,
+            str::stream() << "document constructed by $facet is " << usedBytes
+                          << " bytes, which exceeds the limit of " << maxBytes << " bytes",
+            usedBytes <= maxBytes);
+}
+
+/**
+ * Coordinates a $facet stage whose sub-pipelines each run on their own worker thread. The thread
+ * running the $facet stage pushes every batch of input to all of the sub-pipelines, and blocks
+ * while any of them has too many batches waiting. Batches are shared as owned BSON, since a
+ * Document lazily caches its fields and so cannot be read from several threads at once.
+ */
+class ParallelFacetExecution {
+public:
+    using Batch = std::shared_ptr<const std::vector<BSONObj>>;
+
+    ParallelFacetExecution(size_t nPipelines, size_t maxQueuedBatches, size_t maxOutputBytes)
+        : _pipelines(nPipelines),
+          _maxQueuedBatches(maxQueuedBatches),
+          _maxOutputBytes(maxOutputBytes) {}
+
+    /**
+     * Hands 'batch' to every sub-pipeline which still wants input, waiting for space in their
+     * queues. Returns false if no more input should be pushed, either because every sub-pipeline
+     * has finished early or because execution was stopped.
+     */
+    bool push(OperationContext* opCtx, Batch batch) {
+        stdx::unique_lock<Latch> lk(_mutex);
+        opCtx->waitForConditionOrInterrupt(_batchConsumed, lk, [&] {
+            return _stopped ||
+                std::all_of(_pipelines.begin(), _pipelines.end(), [&](const auto& pipeline) {
+                       return pipeline.doneReading || pipeline.batches.size() < _maxQueuedBatches;
+                   });
+        });
+
+        bool anyReading = false;
+        for (auto&& pipeline : _pipelines) {
+            if (!_stopped && !pipeline.doneReading) {
+                pipeline.batches.push_back(batch);
+                anyReading = true;
+            }
+        }
+        _batchAvailable.notify_all();
+        return anyReading;
+    }
+
+    /**
+     * Signals that no more batches will be pushed.
+     */
+    void finishInput() {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _inputExhausted = true;
+        _batchAvailable.notify_all();
+    }
+
+    /**
+     * Waits until every worker has finished, then throws the first error any of them hit.
+     */
+    void waitForWorkers(OperationContext* opCtx) {
+        stdx::unique_lock<Latch> lk(_mutex);
+        opCtx->waitForConditionOrInterrupt(
+            _workerFinished, lk, [&] { return _nWorkersFinished == _pipelines.size(); });
+        uassertStatusOK(_status);
+    }
+
+    /**
+     * Stops all workers as soon as possible by killing their operations. Has no effect on workers
+     * which have already finished.
+     */
+    void stop() {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _stop(lk);
+    }
+
+    std::vector<Value> releaseResults(size_t facetId) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        return std::move(_pipelines[facetId].results);
+    }
+
+    /**
+     * The body of the worker thread for sub-pipeline 'facetId'. 'input' must be the first stage of
+     * 'pipeline'; documents from each batch are fed through it followed by a pause, in the same way
+     * a DocumentSourceTeeConsumer pauses at the end of each batch of the TeeBuffer.
+     */
+    void runWorker(size_t facetId,
+                   ServiceContext* serviceContext,
+                   Pipeline* pipeline,
+                   DocumentSourceQueue* input) {
+        ThreadClient client("$facet", serviceContext);
+        auto opCtx = client->makeOperationContext();
+
+        auto status = [&]() -> Status {
+            try {
+                _registerWorker(facetId, opCtx.get());
+                pipeline->reattachToOperationContext(opCtx.get());
+                ON_BLOCK_EXIT([&] { pipeline->detachFromOperationContext(); });
+                _runPipeline(facetId, pipeline, input);
+                return Status::OK();
+            } catch (...) {
+                return exceptionToStatus();
+            }
+        }();
+
+        stdx::lock_guard<Latch> lk(_mutex);
+        _pipelines[facetId].opCtx = nullptr;
+        if (!status.isOK() && _status.isOK()) {
+            _status = std::move(status);
+            _stop(lk);
+        }
+        ++_nWorkersFinished;
+        _workerFinished.notify_all();
+    }
+
+private:
+    struct PipelineState {
+        std::deque<Batch> batches;
+        bool doneReading = false;
+        OperationContext* opCtx = nullptr;
+        std::vector<Value> results;
+    };
+
+    void _registerWorker(size_t facetId, OperationContext* opCtx) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _pipelines[facetId].opCtx = opCtx;
+        if (_stopped) {
+            _killWorker(_pipelines[facetId]);
+        }
+    }
+
+    /**
+     * Returns the next batch for sub-pipeline 'facetId', or null once the input is exhausted or
+     * execution has been stopped.
+     */
+    Batch _pop(size_t facetId) {
+        stdx::unique_lock<Latch> lk(_mutex);
+        auto& batches = _pipelines[facetId].batches;
+        _batchAvailable.wait(lk, [&] { return _stopped || _inputExhausted || !batches.empty(); });
+        if (_stopped || batches.empty()) {
+            return nullptr;
+        }
+
+        auto batch = std::move(batches.front());
+        batches.pop_front();
+        _batchConsumed.notify_all();
+        return batch;
+    }
+
+    void _finishReading(size_t facetId) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _pipelines[facetId].doneReading = true;
+        _pipelines[facetId].batches.clear();
+        _batchConsumed.notify_all();
+    }
+
+    void _runPipeline(size_t facetId, Pipeline* pipeline, DocumentSourceQueue* input) {
+        auto& results = _pipelines[facetId].results;
+
+        // Returns true once 'pipeline' is exhausted.
+        auto drainPipeline = [&] {
+            auto next = pipeline->getSources().back()->getNext();
+            for (; next.isAdvanced(); next = pipeline->getSources().back()->getNext()) {
+                const auto docSize = next.getDocument().getApproximateSize();
+                assertOutputUnderMemoryLimit(_outputBytes.addAndFetch(docSize), _maxOutputBytes);
+                results.emplace_back(next.releaseDocument());
+            }
+            return next.isEOF();
+        };
+
+        for (auto batch = _pop(facetId); batch; batch = _pop(facetId)) {
+            for (auto&& obj : *batch) {
+                input->emplace_back(Document::fromBsonWithMetaData(obj));
+            }
+            input->emplace_back(DocumentSource::GetNextResult::makePauseExecution());
+
+            if (drainPipeline()) {
+                // This sub-pipeline is done, for instance because it ended with a $limit.
+                _finishReading(facetId);
+                return;
+            }
+        }
+
+        if (_isStopped()) {
+            return;
+        }
+        while (!drainPipeline()) {
+        }
+    }
+
+    bool _isStopped() {
+        stdx::lock_guard<Latch> lk(_mutex);
+        return _stopped;
+    }
+
+    void _stop(WithLock) {
+        _stopped = true;
+        for (auto&& pipeline : _pipelines) {
+            _killWorker(pipeline);
+        }
+        _batchAvailable.notify_all();
+        _batchConsumed.notify_all();
+    }
+
+    void _killWorker(const PipelineState& pipeline) {
+        if (!pipeline.opCtx) {
+            return;
+        }
+        stdx::lock_guard<Client> clientLock(*pipeline.opCtx->getClient());
+        pipeline.opCtx->getServiceContext()->killOperation(clientLock, pipeline.opCtx);
+    }
+
+    Mutex _mutex = MONGO_MAKE_LATCH("ParallelFacetExecution::_mutex");
+    stdx::condition_variable _batchAvailable;
+    stdx::condition_variable _batchConsumed;
+    stdx::condition_variable _workerFinished;
+
+    std::vector<PipelineState> _pipelines;
+    const size_t _maxQueuedBatches;
+    bool _inputExhausted = false;
+    bool _stopped = false;
+    size_t _nWorkersFinished = 0;
+    Status _status = Status::OK();
+
+    const size_t _maxOutputBytes;
+    AtomicWord<long long> _outputBytes{0};
+};
+
+// The number of worker threads on which $facet stages across all operations are currently running
+// their sub-pipelines.
+AtomicWord<int> facetWorkersInUse{0};
+
+/**
+ * Reserves 'nWorkers' of the 'internalQueryFacetMaxParallelWorkers' threads. A $facet stage needs
+ * a thread for each of its sub-pipelines at once, so it either gets all of them or none.
+ */
+bool tryReserveFacetWorkers(int nWorkers) {
+    auto inUse = facetWorkersInUse.load();
+    do {
+        if (inUse + nWorkers > internalQueryFacetMaxParallelWorkers.load()) {
+            return false;
+        }
+    } while (!facetWorkersInUse.compareAndSwap(&inUse, inUse + nWorkers));
+    return true;
+}
+
 }  // namespace
 
 std::unique_ptr<DocumentSourceFacet::LiteParsed> DocumentSourceFacet::LiteParsed::parse(
@@ -151,13 +405,41 @@ DocumentSource::GetNextResult DocumentSourceFacet::doGetNext() {
         return GetNextResult::makeEOF();
     }
 
-    const size_t maxBytes = _maxOutputDocSizeBytes;
-    auto ensureUnderMemoryLimit = [usedBytes = 0ul, &maxBytes](long long additional) mutable {
+    auto results = [&] {
+        const auto nWorkers = static_cast<int>(_facets.size());
+        if (canRunPipelinesInParallel() && tryReserveFacetWorkers(nWorkers)) {
+            ON_BLOCK_EXIT([&] { facetWorkersInUse.subtractAndFetch(nWorkers); });
+            return runPipelinesInParallel();
+        }
+        return runPipelinesSerially();
+    }();
+
+    MutableDocument resultDoc;
+    for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
+        resultDoc[_facets[facetId].name] = Value(std::move(results[facetId]));
+    }
+
+    _done = true;  // We will only ever produce one result.
+    return resultDoc.freeze();
+}
+
+bool DocumentSourceFacet::canRunPipelinesInParallel() const {
+    if (!internalQueryFacetRunPipelinesInParallel.load() || _facets.size() < 2) {
+        return false;
+    }
+
+    // Reading from other collections needs the storage resources of this operation, which the
+    // worker threads do not have.
+    stdx::unordered_set<NamespaceString> involvedCollections;
+    addInvolvedCollections(&involvedCollections);
+    return involvedCollections.empty();
+}
+
+vector<vector<Value>> DocumentSourceFacet::runPipelinesSerially() {
+    auto ensureUnderMemoryLimit = [usedBytes = 0ul, maxBytes = _maxOutputDocSizeBytes](
+                                      long long additional) mutable {
         usedBytes += additional;
-        uassert(4031700,
-                str::stream() << "document constructed by $facet is " << usedBytes
-                              << " bytes, which exceeds the limit of " << maxBytes << " bytes",
-                usedBytes <= maxBytes);
+        assertOutputUnderMemoryLimit(usedBytes, maxBytes);
     };
 
     vector<vector<Value>> results(_facets.size());
@@ -174,14 +456,78 @@ DocumentSource::GetNextResult DocumentSourceFacet::doGetNext() {
             allPipelinesEOF = allPipelinesEOF && next.isEOF();
         }
     }
+    return results;
+}
+
+vector<vector<Value>> DocumentSourceFacet::runPipelinesInParallel() {
+    auto opCtx = pExpCtx->opCtx;
+
+    // Expressions keep their variables in their ExpressionContext, so each sub-pipeline is parsed
+    // again with a context of its own before it is handed to another thread.
+    vector<std::unique_ptr<Pipeline, PipelineDeleter>> pipelines;
+    vector<DocumentSourceQueue*> inputs;
+    for (auto&& facet : _facets) {
+        auto expCtx = pExpCtx->copyWith(pExpCtx->ns, pExpCtx->uuid);
+        vector<BSONObj> rawPipeline;
+        for (auto&& stage : facet.pipeline->serialize()) {
+            rawPipeline.push_back(stage.getDocument().toBson());
+        }
+        auto pipeline = Pipeline::parse(rawPipeline, expCtx);
+        pipeline->optimizePipeline();
+
+        auto input = DocumentSourceQueue::create(expCtx);
+        pipeline->addInitialSource(input);
+        pipeline->detachFromOperationContext();
+        inputs.push_back(input.get());
+        pipelines.push_back(std::move(pipeline));
+    }
 
-    MutableDocument resultDoc;
     for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
-        resultDoc[_facets[facetId].name] = Value(std::move(results[facetId]));
+        // The original sub-pipeline has not read any input, so it holds nothing to dispose of.
+        _facets[facetId].pipeline.get_deleter().dismissDisposal();
+        _facets[facetId].pipeline = std::move(pipelines[facetId]);
     }
 
-    _done = true;  // We will only ever produce one result.
-    return resultDoc.freeze();
+    ParallelFacetExecution execution(
+        _facets.size(), internalQueryFacetMaxQueuedBatches.load(), _maxOutputDocSizeBytes);
+    vector<stdx::thread> workers;
+    ON_BLOCK_EXIT([&] {
+        execution.stop();
+        for (auto&& worker : workers) {
+            worker.join();
+        }
+        // Put back the original first stage, so that disposing of the sub-pipelines also disposes
+        // of the input through '_teeBuffer'.
+        for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
+            auto& pipeline = _facets[facetId].pipeline;
+            pipeline->popFront();
+            pipeline->addInitialSource(
+                DocumentSourceTeeConsumer::create(pExpCtx, facetId, _teeBuffer));
+            pipeline->reattachToOperationContext(opCtx);
+        }
+    });
+
+    for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
+        workers.emplace_back([&, facetId, pipeline = _facets[facetId].pipeline.get()] {
+            execution.runWorker(facetId, opCtx->getServiceContext(), pipeline, inputs[facetId]);
+        });
+    }
+
+    for (auto batch = _teeBuffer->getNextBatchAsBson(); !batch.empty();
+         batch = _teeBuffer->getNextBatchAsBson()) {
+        if (!execution.push(opCtx,
+                            std::make_shared<const vector<BSONObj>>(std::move(batch)))) {
+            break;
+        }
+    }
+    execution.finishInput();
+    execution.waitForWorkers(opCtx);
+
+    vector<vector<Value>> results;
+    for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
+        results.push_back(execution.releaseResults(facetId));
+    }
+    return results;
 }
 
 Value DocumentSourceFacet::serialize(boost::optional<ExplainOptions::Verbosity> explain) const {
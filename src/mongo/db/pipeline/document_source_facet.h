@@ -157,6 +157,27 @@ private:
 
     Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
 
+    /**
+     * Returns true if the sub-pipelines may each run on their own thread: parallel execution is
+     * enabled, there is more than one sub-pipeline, and none of them reads from a collection.
+     */
+    bool canRunPipelinesInParallel() const;
+
+    /**
+     * Runs every sub-pipeline to completion on the calling thread, interleaving them one buffered
+     * batch of input at a time. Returns the results of each sub-pipeline.
+     */
+    std::vector<std::vector<Value>> runPipelinesSerially();
+
+    /**
+     * Runs each sub-pipeline on its own thread, which the caller must have reserved out of
+     * 'internalQueryFacetMaxParallelWorkers'. The calling thread reads batches of input through
+     * '_teeBuffer' and hands every batch to all of the sub-pipelines, waiting whenever one of them
+     * falls 'internalQueryFacetMaxQueuedBatches' batches behind. Replaces each sub-pipeline with
+     * the copy which was run, so that explain sees the executed stages.
+     */
+    std::vector<std::vector<Value>> runPipelinesInParallel();
+
     boost::intrusive_ptr<TeeBuffer> _teeBuffer;
     std::vector<FacetPipeline> _facets;
 
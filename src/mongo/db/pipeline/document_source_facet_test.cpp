@@ -44,6 +44,7 @@
 #include "mongo/db/pipeline/document_source_limit.h"
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/document_source_skip.h"
+#include "mongo/idl/server_parameter_test_util.h"
 #include "mongo/unittest/death_test.h"
 #include "mongo/unittest/unittest.h"
 
@@ -455,6 +456,53 @@ TEST_F(DocumentSourceFacetTest, ShouldBeAbleToEvaluateMultipleStagesWithinOneSub
     ASSERT_DOCUMENT_EQ(output.getDocument(), Document(fromjson("{subPipe: [{_id: 0}, {_id: 1}]}")));
 }
 
+TEST_F(DocumentSourceFacetTest, ShouldProduceTheSameResultsWhenRunningPipelinesInParallel) {
+    // Buffer a few documents at a time and let each sub-pipeline fall at most one batch behind, so
+    // that the input is spread over many batches.
+    RAIIServerParameterControllerForTest bufferSize("internalQueryFacetBufferSizeBytes", 200);
+    RAIIServerParameterControllerForTest queuedBatches("internalQueryFacetMaxQueuedBatches", 1);
+
+    auto spec = fromjson(
+        "{$facet: {"
+        "  counts: [{$group: {_id: '$k', n: {$sum: 1}}}, {$sort: {_id: 1}}],"
+        "  firstTwo: [{$match: {x: {$gte: 20}}}, {$limit: 2}],"
+        "  doubled: [{$project: {_id: 0, y: {$let: {vars: {v: {$multiply: ['$x', 2]}},"
+        "                                        in: '$$v'}}}}]"
+        "}}");
+
+    auto runFacet = [&](bool inParallel) {
+        RAIIServerParameterControllerForTest parallel("internalQueryFacetRunPipelinesInParallel",
+                                                      inParallel);
+        deque<DocumentSource::GetNextResult> inputs;
+        for (int i = 0; i < 100; ++i) {
+            inputs.emplace_back(Document{{"_id", i}, {"x", i}, {"k", i % 3}});
+        }
+        auto mock = DocumentSourceMock::createForTest(inputs, getExpCtx());
+        auto facetStage = DocumentSourceFacet::createFromBson(spec.firstElement(), getExpCtx());
+        facetStage->setSource(mock.get());
+
+        auto output = facetStage->getNext();
+        ASSERT(output.isAdvanced());
+        ASSERT(facetStage->getNext().isEOF());
+        return output.releaseDocument();
+    };
+
+    auto serialOutput = runFacet(false);
+    ASSERT_VALUE_EQ(serialOutput["counts"],
+                    Value(BSON_ARRAY(fromjson("{_id: 0, n: 34}") << fromjson("{_id: 1, n: 33}")
+                                                                 << fromjson("{_id: 2, n: 33}"))));
+    ASSERT_VALUE_EQ(serialOutput["firstTwo"],
+                    Value(BSON_ARRAY(fromjson("{_id: 20, x: 20, k: 2}")
+                                     << fromjson("{_id: 21, x: 21, k: 0}"))));
+    ASSERT_EQ(serialOutput["doubled"].getArrayLength(), 100UL);
+
+    ASSERT_DOCUMENT_EQ(runFacet(true), serialOutput);
+
+    // Without a thread available for each sub-pipeline, they run serially.
+    RAIIServerParameterControllerForTest maxWorkers("internalQueryFacetMaxParallelWorkers", 2);
+    ASSERT_DOCUMENT_EQ(runFacet(true), serialOutput);
+}
+
 TEST_F(DocumentSourceFacetTest, ShouldPropagateDisposeThroughToSource) {
     auto ctx = getExpCtx();
 
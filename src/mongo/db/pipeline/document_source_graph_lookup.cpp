@@ -31,6 +31,7 @@
 
 #include "mongo/db/pipeline/document_source_graph_lookup.h"
 
+#include <boost/filesystem/operations.hpp>
 #include <memory>
 
 #include "mongo/base/init.h"
@@ -45,6 +46,8 @@
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner_common.h"
+#include "mongo/db/stats/resource_consumption_metrics.h"
+#include "mongo/util/destructor_guard.h"
 
 namespace mongo {
 
@@ -85,6 +88,30 @@ NamespaceString parseGraphLookupFromAndResolveNamespace(const BSONElement& elem,
     return nss;
 }
 
+/**
+ * Generates a new file name on each call using a static, atomic and monotonically increasing
+ * number. See the equivalent function in document_source_group.cpp for why this is needed.
+ */
+std::string nextFileName() {
+    static AtomicWord<unsigned> documentSourceGraphLookupFileCounter;
+    return "extsort-doc-graphlookup." +
+        std::to_string(documentSourceGraphLookupFileCounter.fetchAndAdd(1));
+}
+
+class SorterComparator {
+public:
+    typedef std::pair<Value, Value> Data;
+
+    SorterComparator(ValueComparator valueComparator) : _valueComparator(valueComparator) {}
+
+    int operator()(const Data& lhs, const Data& rhs) const {
+        return _valueComparator.compare(lhs.first, rhs.first);
+    }
+
+private:
+    ValueComparator _valueComparator;
+};
+
 }  // namespace
 
 using boost::intrusive_ptr;
@@ -134,17 +161,15 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::doGetNext() {
     performSearch();
 
     std::vector<Value> results;
-    while (!_visited.empty()) {
+    while (hasVisitedLeft()) {
         // Remove elements one at a time to avoid consuming more memory.
-        auto it = _visited.begin();
-        results.push_back(Value(it->second));
-        _visited.erase(it);
+        results.push_back(Value(popVisited()));
     }
 
     MutableDocument output(*_input);
     output.setNestedField(_as, Value(std::move(results)));
 
-    _visitedUsageBytes = 0;
+    resetVisited();
 
     invariant(_visited.empty());
 
@@ -157,9 +182,10 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
     // If the unwind is not preserving empty arrays, we might have to process multiple inputs before
     // we get one that will produce an output.
     while (true) {
-        if (_visited.empty()) {
+        if (!hasVisitedLeft()) {
             // No results are left for the current input, so we should move on to the next one and
             // perform a new search.
+            resetVisited();
 
             auto input = pSource->getNext();
             if (!input.isAdvanced()) {
@@ -168,12 +194,11 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
 
             _input = input.releaseDocument();
             performSearch();
-            _visitedUsageBytes = 0;
             _outputIndex = 0;
         }
         MutableDocument unwound(*_input);
 
-        if (_visited.empty()) {
+        if (!hasVisitedLeft()) {
             if ((*_unwind)->preserveNullAndEmptyArrays()) {
                 // Since "preserveNullAndEmptyArrays" was specified, output a document even though
                 // we had no result.
@@ -187,78 +212,122 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
                 continue;
             }
         } else {
-            auto it = _visited.begin();
-            unwound.setNestedField(_as, Value(it->second));
+            unwound.setNestedField(_as, Value(popVisited()));
             if (indexPath) {
                 unwound.setNestedField(*indexPath, Value(_outputIndex));
                 ++_outputIndex;
             }
-            _visited.erase(it);
         }
 
         return unwound.freeze();
     }
 }
 
+bool DocumentSourceGraphLookUp::hasVisitedLeft() {
+    if (!_visited.empty()) {
+        return true;
+    }
+    if (_visitedRuns.empty()) {
+        return false;
+    }
+    if (!_visitedRunsIterator) {
+        _visitedRunsIterator.reset(Sorter<Value, Value>::Iterator::merge(
+            _visitedRuns, SortOptions(), SorterComparator(ValueComparator::kInstance)));
+    }
+    return _visitedRunsIterator->more();
+}
+
+Document DocumentSourceGraphLookUp::popVisited() {
+    if (!_visited.empty()) {
+        auto it = _visited.begin();
+        Document result = std::move(it->second);
+        _visited.erase(it);
+        return result;
+    }
+    return _visitedRunsIterator->next().second.getDocument();
+}
+
+void DocumentSourceGraphLookUp::resetVisited() {
+    _visited.clear();
+    _visitedUsageBytes = 0;
+
+    _visitedRunsIterator.reset();
+    _visitedRuns.clear();
+    _spilledVisitedIds.clear();
+    _spilledVisitedIdsUsageBytes = 0;
+
+    // Nothing refers to the spill file anymore, so reclaim its space before the next search.
+    if (_nextSortedFileWriterOffset != 0) {
+        boost::filesystem::remove(_fileName);
+        _nextSortedFileWriterOffset = 0;
+    }
+}
+
 void DocumentSourceGraphLookUp::doDispose() {
     _cache.clear();
     _frontier.clear();
-    _visited.clear();
+    _frontierRuns.clear();
+    resetVisited();
 }
 
 void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
     long long depth = 0;
     bool shouldPerformAnotherQuery;
     do {
-        if (!foreignShardedLookupAllowed()) {
-            // Enforce that the foreign collection must be unsharded for $graphLookup.
-            _fromExpCtx->mongoProcessInterface->setExpectedShardVersion(
-                _fromExpCtx->opCtx, _fromExpCtx->ns, ChunkVersion::UNSHARDED());
-        }
         shouldPerformAnotherQuery = false;
 
-        // Check whether each key in the frontier exists in the cache or needs to be queried.
-        auto cached = pExpCtx->getDocumentComparator().makeUnorderedDocumentSet();
-        auto matchStage = makeMatchStageFromFrontier(&cached);
-
-        ValueUnorderedSet queried = pExpCtx->getValueComparator().makeUnorderedValueSet();
-        _frontier.swap(queried);
+        // Take the current level of the search, leaving '_frontier' to collect the next one.
+        ValueUnorderedSet level = pExpCtx->getValueComparator().makeUnorderedValueSet();
+        _frontier.swap(level);
         _frontierUsageBytes = 0;
 
-        // Process cached values, populating '_frontier' for the next iteration of search.
-        while (!cached.empty()) {
-            auto doc = *cached.begin();
-            cached.erase(cached.begin());
-            shouldPerformAnotherQuery =
-                addToVisitedAndFrontier(std::move(doc), depth) || shouldPerformAnotherQuery;
-            checkMemoryUsage();
+        // If part of the level was spilled, spill the remainder as well so that merging the runs
+        // yields every value of the level in sorted order, with duplicates next to each other.
+        std::unique_ptr<Sorter<Value, Value>::Iterator> spilledLevel;
+        if (!_frontierRuns.empty()) {
+            auto runs = std::move(_frontierRuns);
+            _frontierRuns.clear();
+            if (!level.empty()) {
+                runs.push_back(spillFrontier(&level));
+            }
+            spilledLevel.reset(Sorter<Value, Value>::Iterator::merge(
+                runs, SortOptions(), SorterComparator(pExpCtx->getValueComparator())));
         }
 
-        if (matchStage) {
-            // Query for all keys that were in the frontier and not in the cache, populating
-            // '_frontier' for the next iteration of search.
-
-            // We've already allocated space for the trailing $match stage in '_fromPipeline'.
-            _fromPipeline.back() = *matchStage;
-            MakePipelineOptions pipelineOpts;
-            pipelineOpts.optimize = true;
-            pipelineOpts.attachCursorSource = true;
-            // By default, $graphLookup doesn't support a sharded 'from' collection.
-            pipelineOpts.allowTargetingShards = internalQueryAllowShardedLookup.load();
-            _variables.copyToExpCtx(_variablesParseState, _fromExpCtx.get());
-            auto pipeline = Pipeline::makePipeline(_fromPipeline, _fromExpCtx, pipelineOpts);
-            while (auto next = pipeline->getNext()) {
-                uassert(40271,
-                        str::stream()
-                            << "Documents in the '" << _from.ns()
-                            << "' namespace must contain an _id for de-duplication in $graphLookup",
-                        !(*next)["_id"].missing());
-
-                shouldPerformAnotherQuery =
-                    addToVisitedAndFrontier(*next, depth) || shouldPerformAnotherQuery;
-                addToCache(std::move(*next), queried);
+        // Query for the level in batches of at most '_maxFrontierBatchBytes', populating
+        // '_frontier' for the next iteration of search.
+        boost::optional<Value> lastSpilledValue;
+        while (true) {
+            auto batch = pExpCtx->getValueComparator().makeUnorderedValueSet();
+            size_t batchBytes = 0;
+            while (batchBytes < _maxFrontierBatchBytes) {
+                Value value;
+                if (spilledLevel) {
+                    if (!spilledLevel->more()) {
+                        break;
+                    }
+                    value = spilledLevel->next().first;
+                    if (lastSpilledValue &&
+                        pExpCtx->getValueComparator().evaluate(*lastSpilledValue == value)) {
+                        continue;
+                    }
+                    lastSpilledValue = value;
+                } else {
+                    if (level.empty()) {
+                        break;
+                    }
+                    value = *level.begin();
+                    level.erase(level.begin());
+                }
+                batchBytes += value.getApproximateSize();
+                batch.insert(std::move(value));
             }
-            checkMemoryUsage();
+
+            if (batch.empty()) {
+                break;
+            }
+            shouldPerformAnotherQuery =
+                searchFrontierBatch(std::move(batch), depth) || shouldPerformAnotherQuery;
         }
 
         ++depth;
@@ -266,13 +335,66 @@ void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
              (!_maxDepth || depth <= *_maxDepth));
 
     _frontier.clear();
+    _frontierRuns.clear();
     _frontierUsageBytes = 0;
 }
 
+bool DocumentSourceGraphLookUp::searchFrontierBatch(ValueUnorderedSet frontier, long long depth) {
+    if (!foreignShardedLookupAllowed()) {
+        // Enforce that the foreign collection must be unsharded for $graphLookup.
+        _fromExpCtx->mongoProcessInterface->setExpectedShardVersion(
+            _fromExpCtx->opCtx, _fromExpCtx->ns, ChunkVersion::UNSHARDED());
+    }
+    bool shouldPerformAnotherQuery = false;
+
+    // Check whether each key in the frontier exists in the cache or needs to be queried.
+    auto cached = pExpCtx->getDocumentComparator().makeUnorderedDocumentSet();
+    auto matchStage = makeMatchStageFromFrontier(&frontier, &cached);
+
+    // Process cached values, populating '_frontier' for the next iteration of search.
+    while (!cached.empty()) {
+        auto doc = *cached.begin();
+        cached.erase(cached.begin());
+        shouldPerformAnotherQuery =
+            addToVisitedAndFrontier(std::move(doc), depth) || shouldPerformAnotherQuery;
+        checkMemoryUsage();
+    }
+
+    if (matchStage) {
+        // Query for all keys that were in the frontier and not in the cache, populating
+        // '_frontier' for the next iteration of search.
+
+        // We've already allocated space for the trailing $match stage in '_fromPipeline'.
+        _fromPipeline.back() = *matchStage;
+        MakePipelineOptions pipelineOpts;
+        pipelineOpts.optimize = true;
+        pipelineOpts.attachCursorSource = true;
+        // By default, $graphLookup doesn't support a sharded 'from' collection.
+        pipelineOpts.allowTargetingShards = internalQueryAllowShardedLookup.load();
+        _variables.copyToExpCtx(_variablesParseState, _fromExpCtx.get());
+        auto pipeline = Pipeline::makePipeline(_fromPipeline, _fromExpCtx, pipelineOpts);
+        while (auto next = pipeline->getNext()) {
+            uassert(40271,
+                    str::stream()
+                        << "Documents in the '" << _from.ns()
+                        << "' namespace must contain an _id for de-duplication in $graphLookup",
+                    !(*next)["_id"].missing());
+
+            shouldPerformAnotherQuery =
+                addToVisitedAndFrontier(*next, depth) || shouldPerformAnotherQuery;
+            addToCache(std::move(*next), frontier);
+            checkMemoryUsage();
+        }
+    }
+
+    return shouldPerformAnotherQuery;
+}
+
 bool DocumentSourceGraphLookUp::addToVisitedAndFrontier(Document result, long long depth) {
     auto id = result.getField("_id");
 
-    if (_visited.find(id) != _visited.end()) {
+    if (_visited.find(id) != _visited.end() ||
+        _spilledVisitedIds.find(id) != _spilledVisitedIds.end()) {
         // We've already seen this object, don't repeat any work.
         return false;
     }
@@ -320,18 +442,12 @@ void DocumentSourceGraphLookUp::addToCache(const Document& result,
 }
 
 boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
-    DocumentUnorderedSet* cached) {
-    // Add any cached values to 'cached' and remove them from '_frontier'.
-    for (auto it = _frontier.begin(); it != _frontier.end();) {
+    ValueUnorderedSet* frontier, DocumentUnorderedSet* cached) {
+    // Add any cached values to 'cached' and remove them from 'frontier'.
+    for (auto it = frontier->begin(); it != frontier->end();) {
         if (auto entry = _cache[*it]) {
             cached->insert(entry->begin(), entry->end());
-            size_t valueSize = it->getApproximateSize();
-            _frontier.erase(it++);
-
-            // If the cached value increased in size while in the cache, we don't want to underflow
-            // '_frontierUsageBytes'.
-            invariant(valueSize <= _frontierUsageBytes);
-            _frontierUsageBytes -= valueSize;
+            frontier->erase(it++);
         } else {
             ++it;
         }
@@ -356,7 +472,7 @@ boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
                     BSONObjBuilder subObj(connectToObj.subobjStart(_connectToField.fullPath()));
                     {
                         BSONArrayBuilder in(subObj.subarrayStart("$in"));
-                        for (auto&& value : _frontier) {
+                        for (auto&& value : *frontier) {
                             in << value;
                         }
                     }
@@ -365,7 +481,7 @@ boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
         }
     }
 
-    return _frontier.empty() ? boost::none : boost::optional<BSONObj>(match.obj());
+    return frontier->empty() ? boost::none : boost::optional<BSONObj>(match.obj());
 }
 
 void DocumentSourceGraphLookUp::performSearch() {
@@ -431,11 +547,85 @@ Pipeline::SourceContainer::iterator DocumentSourceGraphLookUp::doOptimizeAt(
 }
 
 void DocumentSourceGraphLookUp::checkMemoryUsage() {
-    // TODO SERVER-23980: Implement spilling to disk if allowDiskUse is specified.
+    auto usageBytes = [&] {
+        return _visitedUsageBytes + _frontierUsageBytes + _spilledVisitedIdsUsageBytes;
+    };
+
+    if (_allowSpilling && usageBytes() >= _maxMemoryUsageBytes) {
+        // Spill the larger of the two structures first, and the other only if that was not
+        // enough.
+        if (_frontierUsageBytes > _visitedUsageBytes) {
+            _frontierRuns.push_back(spillFrontier(&_frontier));
+            _frontierUsageBytes = 0;
+        }
+        if (usageBytes() >= _maxMemoryUsageBytes && !_visited.empty()) {
+            spillVisited();
+        }
+        if (usageBytes() >= _maxMemoryUsageBytes && !_frontier.empty()) {
+            _frontierRuns.push_back(spillFrontier(&_frontier));
+            _frontierUsageBytes = 0;
+        }
+    }
+
+    // The '_id' values of spilled documents stay in memory, so a search may still run out.
     uassert(40099,
             "$graphLookup reached maximum memory consumption",
-            (_visitedUsageBytes + _frontierUsageBytes) < _maxMemoryUsageBytes);
-    _cache.evictDownTo(_maxMemoryUsageBytes - _frontierUsageBytes - _visitedUsageBytes);
+            usageBytes() < _maxMemoryUsageBytes);
+    _cache.evictDownTo(_maxMemoryUsageBytes - usageBytes());
+}
+
+void DocumentSourceGraphLookUp::spillVisited() {
+    std::vector<std::pair<Value, Value>> data;
+    data.reserve(_visited.size());
+    for (auto&& [id, doc] : _visited) {
+        _spilledVisitedIdsUsageBytes += id.getApproximateSize();
+        _spilledVisitedIds.insert(id);
+        data.emplace_back(id, Value(std::move(doc)));
+    }
+    _visited.clear();
+    _visitedUsageBytes = 0;
+
+    std::sort(data.begin(), data.end(), [](const auto& lhs, const auto& rhs) {
+        return ValueComparator::kInstance.evaluate(lhs.first < rhs.first);
+    });
+    _visitedRuns.push_back(writeRun(data));
+}
+
+DocumentSourceGraphLookUp::SpilledRun DocumentSourceGraphLookUp::spillFrontier(
+    ValueUnorderedSet* values) {
+    std::vector<std::pair<Value, Value>> data;
+    data.reserve(values->size());
+    for (auto&& value : *values) {
+        data.emplace_back(value, Value());
+    }
+    values->clear();
+
+    const auto& comparator = pExpCtx->getValueComparator();
+    std::sort(data.begin(), data.end(), [&](const auto& lhs, const auto& rhs) {
+        return comparator.evaluate(lhs.first < rhs.first);
+    });
+    return writeRun(data);
+}
+
+DocumentSourceGraphLookUp::SpilledRun DocumentSourceGraphLookUp::writeRun(
+    const std::vector<std::pair<Value, Value>>& data) {
+    invariant(_allowSpilling);
+    invariant(!data.empty());
+    ++_spills;
+
+    SortedFileWriter<Value, Value> writer(
+        SortOptions().TempDir(pExpCtx->tempDir), _fileName, _nextSortedFileWriterOffset);
+    for (auto&& [key, value] : data) {
+        writer.addAlreadySorted(key, value);
+    }
+
+    auto& metricsCollector = ResourceConsumption::MetricsCollector::get(pExpCtx->opCtx);
+    metricsCollector.incrementKeysSorted(data.size());
+    metricsCollector.incrementSorterSpills(1);
+
+    Sorter<Value, Value>::Iterator* iteratorPtr = writer.done();
+    _nextSortedFileWriterOffset = writer.getFileEndOffset();
+    return SpilledRun(iteratorPtr);
 }
 
 void DocumentSourceGraphLookUp::serializeToArray(
@@ -509,6 +699,10 @@ DocumentSourceGraphLookUp::DocumentSourceGraphLookUp(
       _additionalFilter(additionalFilter),
       _depthField(depthField),
       _maxDepth(maxDepth),
+      _maxMemoryUsageBytes(internalDocumentSourceGraphLookupMaxMemoryBytes.load()),
+      _maxFrontierBatchBytes(internalDocumentSourceGraphLookupMaxFrontierBatchBytes.load()),
+      _allowSpilling(expCtx->allowDiskUse && !expCtx->inMongos),
+      _spilledVisitedIds(ValueComparator::kInstance.makeUnorderedValueSet()),
       _frontier(pExpCtx->getValueComparator().makeUnorderedValueSet()),
       _visited(ValueComparator::kInstance.makeUnorderedValueMap<Document>()),
       _cache(pExpCtx->getValueComparator()),
@@ -523,6 +717,16 @@ DocumentSourceGraphLookUp::DocumentSourceGraphLookUp(
     _fromPipeline = resolvedNamespace.pipeline;
     _fromPipeline.reserve(_fromPipeline.size() + 1);
     _fromPipeline.push_back(BSON("$match" << BSONObj()));
+
+    if (_allowSpilling) {
+        _fileName = pExpCtx->tempDir + "/" + nextFileName();
+    }
+}
+
+DocumentSourceGraphLookUp::~DocumentSourceGraphLookUp() {
+    if (_allowSpilling) {
+        DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName));
+    }
 }
 
 intrusive_ptr<DocumentSourceGraphLookUp> DocumentSourceGraphLookUp::create(
@@ -661,3 +865,6 @@ void DocumentSourceGraphLookUp::addInvolvedCollections(
     }
 }
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -34,6 +34,7 @@
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
+#include "mongo/db/sorter/sorter.h"
 
 namespace mongo {
 
@@ -60,6 +61,8 @@ public:
         }
     };
 
+    ~DocumentSourceGraphLookUp();
+
     const char* getSourceName() const final;
 
     const FieldPath& getConnectFromField() const {
@@ -95,16 +98,24 @@ public:
         StageConstraints constraints(StreamType::kStreaming,
                                      PositionRequirement::kNone,
                                      HostTypeRequirement::kPrimaryShard,
-                                     DiskUseRequirement::kNoDiskUse,
+                                     pExpCtx->allowDiskUse && !pExpCtx->inMongos
+                                         ? DiskUseRequirement::kWritesTmpData
+                                         : DiskUseRequirement::kNoDiskUse,
                                      FacetRequirement::kAllowed,
                                      TransactionRequirement::kAllowed,
                                      LookupRequirement::kAllowed,
                                      UnionRequirement::kAllowed);
 
         constraints.canSwapWithMatch = true;
+        // Without an absorbed $unwind, each input document produces exactly one output document.
+        constraints.canSwapWithSkippingOrLimitingStage = !_unwind;
         return constraints;
     }
 
+    bool usedDisk() final {
+        return _spills > 0;
+    }
+
     boost::optional<DistributedPlanLogic> distributedPlanLogic() final {
         // {shardsStage, mergingStage, sortPattern}
         return DistributedPlanLogic{nullptr, this, boost::none};
@@ -164,16 +175,62 @@ private:
         MONGO_UNREACHABLE;
     }
 
+    using SpilledRun = std::shared_ptr<Sorter<Value, Value>::Iterator>;
+
     /**
      * Prepares the query to execute on the 'from' collection wrapped in a $match by using the
-     * contents of '_frontier'.
+     * contents of 'frontier'.
      *
-     * Fills 'cached' with any values that were retrieved from the cache.
+     * Fills 'cached' with any values that were retrieved from the cache, removing them from
+     * 'frontier'.
      *
      * Returns boost::none if no query is necessary, i.e., all values were retrieved from the cache.
      * Otherwise, returns a query object.
      */
-    boost::optional<BSONObj> makeMatchStageFromFrontier(DocumentUnorderedSet* cached);
+    boost::optional<BSONObj> makeMatchStageFromFrontier(ValueUnorderedSet* frontier,
+                                                        DocumentUnorderedSet* cached);
+
+    /**
+     * Looks up the documents matching the values in 'frontier', which is one batch of the current
+     * level of the search, adding them to '_visited' at the given 'depth'.
+     *
+     * Returns whether '_visited' was updated, and thus, whether the search should recurse.
+     */
+    bool searchFrontierBatch(ValueUnorderedSet frontier, long long depth);
+
+    /**
+     * Returns whether there are any visited documents for the current input which have not yet
+     * been returned, whether held in '_visited' or spilled to disk.
+     */
+    bool hasVisitedLeft();
+
+    /**
+     * Removes and returns one of the visited documents for the current input. Must only be called
+     * if hasVisitedLeft() returns true.
+     */
+    Document popVisited();
+
+    /**
+     * Clears all of the state, including any spilled data, accumulated for the current input.
+     */
+    void resetVisited();
+
+    /**
+     * Writes the contents of '_visited' to disk, keeping only the '_id' of each document in memory
+     * so that the search can still de-duplicate against it.
+     */
+    void spillVisited();
+
+    /**
+     * Writes 'values', which are not yet queried frontier values, to disk as a sorted run and
+     * clears 'values'.
+     */
+    SpilledRun spillFrontier(ValueUnorderedSet* values);
+
+    /**
+     * Writes 'data' to the spill file as a single run. 'data' must already be sorted by key.
+     */
+    SpilledRun writeRun(const std::vector<std::pair<Value, Value>>& data);
 
     /**
      * If we have internalized a $unwind, getNext() dispatches to this function.
@@ -200,8 +257,9 @@ private:
     void addToCache(const Document& result, const ValueUnorderedSet& queried);
 
     /**
-     * Assert that '_visited' and '_frontier' have not exceeded the maximum meory usage, and then
-     * evict from '_cache' until this source is using less than '_maxMemoryUsageBytes'.
+     * Spill '_visited' or '_frontier' to disk if they have exceeded the maximum memory usage and
+     * spilling is allowed, assert that the memory usage is now within bounds, and then evict from
+     * '_cache' until this source is using less than '_maxMemoryUsageBytes'.
      */
     void checkMemoryUsage();
 
@@ -230,11 +288,39 @@ private:
     // The aggregation pipeline to perform against the '_from' namespace.
     std::vector<BSONObj> _fromPipeline;
 
-    size_t _maxMemoryUsageBytes = 100 * 1024 * 1024;
+    const size_t _maxMemoryUsageBytes;
+
+    // The maximum size of the frontier values placed in a single query against '_from'. Keeps the
+    // $in well below the maximum BSON size when a level of the search is very wide.
+    const size_t _maxFrontierBatchBytes;
 
     // Track memory usage to ensure we don't exceed '_maxMemoryUsageBytes'.
     size_t _visitedUsageBytes = 0;
     size_t _frontierUsageBytes = 0;
+    size_t _spilledVisitedIdsUsageBytes = 0;
+
+    // Whether '_visited' and '_frontier' may be written to disk once they outgrow
+    // '_maxMemoryUsageBytes', rather than failing the operation.
+    const bool _allowSpilling;
+
+    // The file holding both spilled visited documents and spilled frontier values. It is removed
+    // once the search for each input has been returned.
+    std::string _fileName;
+    std::streampos _nextSortedFileWriterOffset = 0;
+
+    // Runs of frontier values for the next level of the search which did not fit in memory.
+    std::vector<SpilledRun> _frontierRuns;
+
+    // Runs of visited documents, keyed by '_id', which did not fit in memory, along with the
+    // '_id' values of those documents so that the search does not revisit them.
+    std::vector<SpilledRun> _visitedRuns;
+    ValueUnorderedSet _spilledVisitedIds;
+
+    // Only used while returning results, once '_visited' has been drained; reads '_visitedRuns'.
+    std::unique_ptr<Sorter<Value, Value>::Iterator> _visitedRunsIterator;
+
+    // The number of times this stage has spilled to disk.
+    size_t _spills = 0;
 
     // Only used during the breadth-first search, tracks the set of values on the current frontier.
     ValueUnorderedSet _frontier;
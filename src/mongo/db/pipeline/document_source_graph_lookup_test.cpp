@@ -39,6 +39,8 @@
 #include "mongo/db/pipeline/document_source_graph_lookup.h"
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/process_interface/stub_mongo_process_interface.h"
+#include "mongo/idl/server_parameter_test_util.h"
+#include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/str.h"
@@ -711,5 +713,86 @@ TEST_F(DocumentSourceGraphLookUpTest, ShouldNotExpandArraysWithinArraysAtEndOfCo
     ASSERT(graphLookupStage->getNext().isEOF());
 }
 
+/**
+ * Makes a chain of 'length' documents in which each document connects to the next, each with
+ * enough padding that a small memory limit is quickly exceeded.
+ */
+std::deque<DocumentSource::GetNextResult> makePaddedChain(int length) {
+    std::deque<DocumentSource::GetNextResult> chain;
+    for (int i = 0; i < length; ++i) {
+        chain.push_back(Document{{"_id", i}, {"to", i + 1}, {"padding", std::string(200, 'x')}});
+    }
+    return chain;
+}
+
+boost::intrusive_ptr<DocumentSourceGraphLookUp> makeChainGraphLookup(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx, int length) {
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+    expCtx->mongoProcessInterface = std::make_shared<MockMongoInterface>(makePaddedChain(length));
+    return DocumentSourceGraphLookUp::create(
+        expCtx,
+        fromNs,
+        "results",
+        "to",
+        "_id",
+        ExpressionFieldPath::deprecatedCreate(expCtx.get(), "startVal"),
+        boost::none,
+        boost::none,
+        boost::none,
+        boost::none);
+}
+
+TEST_F(DocumentSourceGraphLookUpTest, ShouldSpillVisitedAndFrontierWhenAllowDiskUseIsSet) {
+    RAIIServerParameterControllerForTest maxMemory{
+        "internalDocumentSourceGraphLookupMaxMemoryBytes", 2 * 1024};
+    RAIIServerParameterControllerForTest maxBatch{
+        "internalDocumentSourceGraphLookupMaxFrontierBatchBytes", 1};
+
+    auto expCtx = getExpCtx();
+    unittest::TempDir tempDir("DocumentSourceGraphLookUpTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+
+    std::deque<DocumentSource::GetNextResult> inputs{Document{{"_id", 0}, {"startVal", 0}},
+                                                     Document{{"_id", 1}, {"startVal", 0}}};
+    auto inputMock = DocumentSourceMock::createForTest(std::move(inputs), expCtx);
+
+    const int kChainLength = 20;
+    auto graphLookupStage = makeChainGraphLookup(expCtx, kChainLength);
+    graphLookupStage->setSource(inputMock.get());
+
+    // Each input should see the whole chain, even though it does not fit in memory.
+    for (int input = 0; input < 2; ++input) {
+        auto next = graphLookupStage->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+
+        auto resultsArray = next.getDocument().getField("results").getArray();
+        ASSERT_EQ(static_cast<size_t>(kChainLength), resultsArray.size());
+        for (auto&& doc : makePaddedChain(kChainLength)) {
+            ASSERT(arrayContains(expCtx, resultsArray, Value(doc.getDocument())));
+        }
+    }
+    ASSERT(graphLookupStage->getNext().isEOF());
+    ASSERT_TRUE(graphLookupStage->usedDisk());
+}
+
+TEST_F(DocumentSourceGraphLookUpTest, ShouldFailWhenExceedingMemoryLimitWithoutAllowDiskUse) {
+    RAIIServerParameterControllerForTest maxMemory{
+        "internalDocumentSourceGraphLookupMaxMemoryBytes", 2 * 1024};
+
+    auto expCtx = getExpCtx();
+    expCtx->allowDiskUse = false;
+
+    std::deque<DocumentSource::GetNextResult> inputs{Document{{"_id", 0}, {"startVal", 0}}};
+    auto inputMock = DocumentSourceMock::createForTest(std::move(inputs), expCtx);
+
+    auto graphLookupStage = makeChainGraphLookup(expCtx, 20);
+    graphLookupStage->setSource(inputMock.get());
+
+    ASSERT_THROWS_CODE(graphLookupStage->getNext(), AssertionException, 40099);
+}
+
 }  // namespace
 }  // namespace mongo
@@ -35,9 +35,11 @@
 #include "mongo/db/exec/document_value/document.h"
 #include "mongo/db/exec/document_value/value.h"
 #include "mongo/db/exec/document_value/value_comparator.h"
+#include "mongo/db/exec/sort_key_comparator.h"
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document_source_group.h"
+#include "mongo/db/pipeline/document_source_sort.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
@@ -62,6 +64,68 @@ std::string nextFileName() {
     return "extsort-doc-group." + std::to_string(documentSourceGroupFileCounter.fetchAndAdd(1));
 }
 
+// Spilled groups are partitioned by 'kSpillPartitionBits' bits of the hash of their key at a time,
+// so a partition can be split again, using the next bits, until the hash is used up.
+constexpr size_t kSpillPartitionBits = 4;
+constexpr size_t kNumSpillPartitions = size_t{1} << kSpillPartitionBits;
+constexpr size_t kMaxSpillDepth = 64 / kSpillPartitionBits;
+
+/**
+ * Computes $first or $last for a $group which has absorbed the $sort before it. Each input is an
+ * array holding a document's sort key followed by the accumulator's argument for that document,
+ * which is left out when it is missing. The accumulator keeps the argument with the lowest sort key
+ * for $first, or the highest for $last, as the first or last document of the sorted input would
+ * have provided. Partial results are the same kind of array, so they can be merged as inputs.
+ */
+class AccumulatorBySortKey final : public AccumulatorState {
+public:
+    AccumulatorBySortKey(ExpressionContext* const expCtx,
+                         std::shared_ptr<const SortKeyComparator> comparator,
+                         bool takesFirst)
+        : AccumulatorState(expCtx), _comparator(std::move(comparator)), _takesFirst(takesFirst) {
+        _memUsageBytes = sizeof(*this);
+    }
+
+    void processInternal(const Value& input, bool merging) final {
+        const auto& entry = input.getArray();
+        if (_sortKey) {
+            // Of two equal sort keys, $first keeps the earlier input and $last the later one.
+            const int cmp = (*_comparator)(entry[0], *_sortKey);
+            if (_takesFirst ? cmp >= 0 : cmp < 0) {
+                return;
+            }
+        }
+        _sortKey = entry[0];
+        _value = entry.size() > 1 ? entry[1] : Value();
+        _memUsageBytes = sizeof(*this) + _sortKey->getApproximateSize() +
+            _value.getApproximateSize() - 2 * sizeof(Value);
+    }
+
+    Value getValue(bool toBeMerged) final {
+        if (!toBeMerged || !_sortKey) {
+            return _value;
+        }
+        return _value.missing() ? Value(std::vector<Value>{*_sortKey})
+                                : Value(std::vector<Value>{*_sortKey, _value});
+    }
+
+    const char* getOpName() const final {
+        return _takesFirst ? "$first" : "$last";
+    }
+
+    void reset() final {
+        _sortKey = boost::none;
+        _value = Value();
+        _memUsageBytes = sizeof(*this);
+    }
+
+private:
+    std::shared_ptr<const SortKeyComparator> _comparator;
+    bool _takesFirst;
+    boost::optional<Value> _sortKey;
+    Value _value;
+};
+
 }  // namespace
 
 using boost::intrusive_ptr;
@@ -169,6 +233,18 @@ void DocumentSourceGroup::freeMemory() {
 }
 
 DocumentSource::GetNextResult DocumentSourceGroup::doGetNext() {
+    if (!_checkedInputSort) {
+        // A $sort which could not be pushed down into the query layer still lets us stream.
+        if (auto sortStage = dynamic_cast<DocumentSourceSort*>(pSource)) {
+            setInputSortPattern(sortStage->getSortKeyPattern());
+        }
+        _checkedInputSort = true;
+    }
+
+    if (_streamingSortKeyGen) {
+        return getNextStreaming();
+    }
+
     if (!_initialized) {
         const auto initializationResult = initialize();
         if (initializationResult.isPaused()) {
@@ -177,10 +253,6 @@ DocumentSource::GetNextResult DocumentSourceGroup::doGetNext() {
         invariant(initializationResult.isEOF());
     }
 
-    for (auto&& accum : _currentAccumulators) {
-        accum->reset();  // Prep accumulators for a new group.
-    }
-
     if (_spilled) {
         return getNextSpilled();
     } else {
@@ -189,48 +261,258 @@ DocumentSource::GetNextResult DocumentSourceGroup::doGetNext() {
 }
 
 DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
-    // We aren't streaming, and we have spilled to disk.
-    if (!_sorterIterator)
-        return GetNextResult::makeEOF();
+    // We aren't streaming, and we have spilled to disk. Return each spilled partition in turn.
+    while (groupsIterator == _groups->end()) {
+        if (!loadNextSpilledPartition()) {
+            dispose();
+            return GetNextResult::makeEOF();
+        }
+    }
+
+    Document out = makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
+    ++groupsIterator;
+    return out;
+}
+
+bool DocumentSourceGroup::loadNextSpilledPartition() {
+    _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
+    groupsIterator = _groups->end();
+    _memoryTracker.resetCurrent();
+
+    if (_pendingPartitions.empty()) {
+        return false;
+    }
+
+    auto partition = std::move(_pendingPartitions.back());
+    _pendingPartitions.pop_back();
+
+    // A partition holding a single group cannot be split any further, nor can one whose keys
+    // have used up all of the bits of their hash.
+    const bool canSplit = partition.depth + 1 < kMaxSpillDepth;
+    std::vector<SpillPartition> subPartitions;
 
-    _currentId = _firstPartOfNextGroup.first;
     const size_t numAccumulators = _accumulatedFields.size();
+    for (auto&& run : partition.runs) {
+        run->openSource();
+        while (run->more()) {
+            if (canSplit && _groups->size() > 1 &&
+                _memoryTracker.currentMemoryBytes() >
+                    static_cast<long long>(_memoryTracker._maxAllowedMemoryUsageBytes)) {
+                spill(&subPartitions, partition.depth + 1);
+            }
 
-    // Call startNewGroup on every accumulator.
-    Value expandedId = expandId(_currentId);
-    Document idDoc =
-        expandedId.getType() == BSONType::Object ? expandedId.getDocument() : Document();
-    for (size_t i = 0; i < numAccumulators; ++i) {
-        Value initializerValue =
-            _accumulatedFields[i].expr.initializer->evaluate(idDoc, &pExpCtx->variables);
-        _currentAccumulators[i]->startNewGroup(initializerValue);
-    }
-
-    while (pExpCtx->getValueComparator().evaluate(_currentId == _firstPartOfNextGroup.first)) {
-        // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
-        // At loop exit, it is the first value to be processed in the next group.
-        switch (numAccumulators) {  // mirrors switch in spill()
-            case 1:                 // Single accumulators serialize as a single Value.
-                _currentAccumulators[0]->process(_firstPartOfNextGroup.second, true);
-            case 0:  // No accumulators so no Values.
-                break;
-            default: {  // Multiple accumulators serialize as an array of Values.
-                const vector<Value>& accumulatorStates = _firstPartOfNextGroup.second.getArray();
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    _currentAccumulators[i]->process(accumulatorStates[i], true);
+            auto [id, accumulatorStates] = run->next();
+            bool inserted;
+            Accumulators& group = findOrCreateGroup(id, &inserted);
+            switch (numAccumulators) {  // mirrors switch in spill()
+                case 1:                 // Single accumulators serialize as a single Value.
+                    group[0]->process(accumulatorStates, true);
+                case 0:  // No accumulators so no Values.
+                    break;
+                default: {  // Multiple accumulators serialize as an array of Values.
+                    const vector<Value>& states = accumulatorStates.getArray();
+                    for (size_t i = 0; i < numAccumulators; i++) {
+                        group[i]->process(states[i], true);
+                    }
                 }
             }
+            for (size_t i = 0; i < numAccumulators; i++) {
+                _memoryTracker.update(_accumulatedFields[i].fieldName, group[i]->getMemUsage());
+            }
         }
+        run->closeSource();
+    }
 
-        if (!_sorterIterator->more()) {
+    if (!subPartitions.empty()) {
+        // The partition did not fit in memory, so it has been split. Its sub-partitions will be
+        // loaded by subsequent calls.
+        if (!_groups->empty()) {
+            spill(&subPartitions, partition.depth + 1);
+        }
+        for (auto&& subPartition : subPartitions) {
+            if (!subPartition.runs.empty()) {
+                _pendingPartitions.push_back(std::move(subPartition));
+            }
+        }
+        return true;
+    }
+
+    groupsIterator = _groups->begin();
+    return true;
+}
+
+DocumentSource::GetNextResult DocumentSourceGroup::getNextStreaming() {
+    while (!_streamingGroupsReady) {
+        if (_streamingInputExhausted) {
             dispose();
-            break;
+            return GetNextResult::makeEOF();
+        }
+
+        auto input = pSource->getNext();
+        if (input.isPaused()) {
+            return input;
+        }
+        if (input.isEOF()) {
+            _streamingInputExhausted = true;
+            _streamingGroupsReady = !_groups->empty();
+            groupsIterator = _groups->begin();
+            continue;
+        }
+
+        auto rootDocument = input.releaseDocument();
+        Value sortKey = _streamingSortKeyGen->computeSortKeyFromDocument(rootDocument);
+        if (_streamingSortKey &&
+            ValueComparator::kInstance.evaluate(*_streamingSortKey != sortKey)) {
+            // The input has moved past the sort key of every group in '_groups'. Documents which
+            // belong to the same group always have the same sort key, so these groups are complete.
+            _streamingGroupsReady = true;
+            groupsIterator = _groups->begin();
+            _firstDocumentOfNextGroups = std::move(rootDocument);
+        } else {
+            processDocument(rootDocument);
+            if (stopStreamingIfOutOfMemory()) {
+                return doGetNext();
+            }
+        }
+        _streamingSortKey = std::move(sortKey);
+    }
+
+    Document out = makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
+
+    if (++groupsIterator == _groups->end()) {
+        _groups->clear();
+        _memoryTracker.resetCurrent();
+        _streamingGroupsReady = false;
+        if (_firstDocumentOfNextGroups) {
+            processDocument(*_firstDocumentOfNextGroups);
+            _firstDocumentOfNextGroups.reset();
+            // A single document can exceed the limit. If so, the next call continues without the
+            // sort, before any further groups are marked ready.
+            stopStreamingIfOutOfMemory();
+        }
+    }
+
+    return out;
+}
+
+bool DocumentSourceGroup::stopStreamingIfOutOfMemory() {
+    if (_memoryTracker.currentMemoryBytes() <=
+        static_cast<long long>(_memoryTracker._maxAllowedMemoryUsageBytes)) {
+        return false;
+    }
+
+    // Too many groups share this sort key, which can happen when the group key holds arrays. Every
+    // group returned so far sorted before the current sort key, so the rest of the input cannot
+    // belong to any of them and can be grouped without the sort.
+    invariant(!_streamingGroupsReady);
+    _streamingSortKeyGen.reset();
+    return true;
+}
+
+boost::optional<SortPattern> DocumentSourceGroup::groupKeySortPrefix(
+    const SortPattern& sortPattern) const {
+    std::set<std::string> groupFields;
+    for (auto&& idExpression : _idExpressions) {
+        auto fieldPathExpr = dynamic_cast<ExpressionFieldPath*>(idExpression.get());
+        if (!fieldPathExpr || fieldPathExpr->isVariableReference() ||
+            fieldPathExpr->getFieldPath().getPathLength() == 1) {
+            return boost::none;
+        }
+        groupFields.insert(fieldPathExpr->getFieldPath().tail().fullPath());
+    }
+
+    // The group fields must be exactly the leading fields of the sort, in any order.
+    if (groupFields.size() > sortPattern.size()) {
+        return boost::none;
+    }
+    std::vector<SortPattern::SortPatternPart> sortPrefix;
+    for (size_t i = 0; i < groupFields.size(); ++i) {
+        const auto& part = sortPattern[i];
+        if (!part.fieldPath || groupFields.count(part.fieldPath->fullPath()) == 0) {
+            return boost::none;
+        }
+        sortPrefix.push_back(part);
+    }
+    return SortPattern{std::move(sortPrefix)};
+}
+
+bool DocumentSourceGroup::setInputSortPattern(const SortPattern& sortPattern) {
+    if (_absorbedSortPattern) {
+        return false;
+    }
+
+    auto sortPrefix = groupKeySortPrefix(sortPattern);
+    if (!sortPrefix) {
+        return false;
+    }
+
+    // Each part of the group key must be a top-level field. The sort key for a dotted path can
+    // differ between documents whose values at that path are equal, once arrays are involved.
+    for (auto&& part : *sortPrefix) {
+        if (part.fieldPath->getPathLength() != 1) {
+            return false;
         }
+    }
+
+    _streamingSortKeyGen.emplace(std::move(*sortPrefix), pExpCtx->getCollator());
+    return true;
+}
+
+bool DocumentSourceGroup::absorbPrecedingSort(const SortPattern& sortPattern) {
+    if (_doingMerge || pExpCtx->needsMerge || _absorbedSortPattern || _accumulatedFields.empty()) {
+        return false;
+    }
+
+    // A sort on the group key is better kept: it can let the $group stream, or be answered by a
+    // DISTINCT_SCAN.
+    if (groupKeySortPrefix(sortPattern)) {
+        return false;
+    }
+
+    for (auto&& part : sortPattern) {
+        if (!part.fieldPath) {
+            // $meta sort keys are not available to this stage.
+            return false;
+        }
+    }
 
-        _firstPartOfNextGroup = _sorterIterator->next();
+    std::vector<bool> takesFirst;
+    for (auto&& accumulatedField : _accumulatedFields) {
+        const auto documentsNeeded = accumulatedField.makeAccumulator()->documentsNeeded();
+        if (documentsNeeded != AccumulatorDocumentsNeeded::kFirstDocument &&
+            documentsNeeded != AccumulatorDocumentsNeeded::kLastDocument) {
+            return false;
+        }
+        takesFirst.push_back(documentsNeeded == AccumulatorDocumentsNeeded::kFirstDocument);
+    }
+
+    _absorbedSortPattern = sortPattern;
+    _absorbedSortKeyGen.emplace(sortPattern, pExpCtx->getCollator());
+    _absorbedSortKeyComparator = std::make_shared<SortKeyComparator>(sortPattern);
+    _absorbedSortTakesFirst = std::move(takesFirst);
+    return true;
+}
+
+void DocumentSourceGroup::serializeToArray(
+    std::vector<Value>& array, boost::optional<ExplainOptions::Verbosity> explain) const {
+    if (!_absorbedSortPattern) {
+        DocumentSource::serializeToArray(array, explain);
+        return;
+    }
+
+    if (explain) {
+        // Explain the stage as it runs, showing the sort which it applies within each group.
+        MutableDocument out(serialize(explain).getDocument());
+        out["sortWithinGroups"] = Value(
+            _absorbedSortPattern->serialize(SortPattern::SortKeySerialization::kForExplain));
+        array.push_back(out.freezeToValue());
+        return;
     }
 
-    return makeDocument(_currentId, _currentAccumulators, pExpCtx->needsMerge);
+    // Otherwise reproduce the original $sort and $group, which are equivalent to this stage.
+    array.push_back(Value(DOC(DocumentSourceSort::kStageName << _absorbedSortPattern->serialize(
+                                  SortPattern::SortKeySerialization::kForPipelineSerialization))));
+    DocumentSource::serializeToArray(array);
 }
 
 DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
@@ -249,7 +531,8 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
 void DocumentSourceGroup::doDispose() {
     // Free our resources.
     _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
-    _sorterIterator.reset();
+    _spillPartitions.clear();
+    _pendingPartitions.clear();
 
     // Make us look done.
     groupsIterator = _groups->end();
@@ -336,6 +619,10 @@ DepsTracker::State DocumentSourceGroup::getDependencies(DepsTracker* deps) const
         // Don't add initializer, because it doesn't refer to docs from the input stream.
     }
 
+    if (_absorbedSortPattern) {
+        _absorbedSortPattern->addDependencies(deps);
+    }
+
     return DepsTracker::State::EXHAUSTIVE_ALL;
 }
 
@@ -410,9 +697,7 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
 }
 
 DocumentSourceGroup::~DocumentSourceGroup() {
-    if (_ownsFileDeletion) {
-        DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName));
-    }
+    DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName));
 }
 
 void DocumentSourceGroup::addAccumulator(AccumulationStatement accumulationStatement) {
@@ -503,93 +788,52 @@ intrusive_ptr<DocumentSource> DocumentSourceGroup::createFromBson(
     return groupStage;
 }
 
-namespace {
+bool DocumentSourceGroup::processDocument(const Document& root) {
+    const size_t numAccumulators = _accumulatedFields.size();
 
-using GroupsMap = DocumentSourceGroup::GroupsMap;
+    Value id = computeId(root);
 
-class SorterComparator {
-public:
-    typedef pair<Value, Value> Data;
+    bool inserted;
+    Accumulators& group = findOrCreateGroup(id, &inserted);
 
-    SorterComparator(ValueComparator valueComparator) : _valueComparator(valueComparator) {}
+    /* tickle all the accumulators for the group we found */
+    dassert(numAccumulators == group.size());
 
-    int operator()(const Data& lhs, const Data& rhs) const {
-        return _valueComparator.compare(lhs.first, rhs.first);
+    if (_absorbedSortKeyGen) {
+        // Pair each argument with the document's sort key (see AccumulatorBySortKey).
+        const Value sortKey = _absorbedSortKeyGen->computeSortKeyFromDocument(root);
+        for (size_t i = 0; i < numAccumulators; i++) {
+            Value argument =
+                _accumulatedFields[i].expr.argument->evaluate(root, &pExpCtx->variables);
+            group[i]->process(argument.missing()
+                                  ? Value(std::vector<Value>{sortKey})
+                                  : Value(std::vector<Value>{sortKey, std::move(argument)}),
+                              false);
+            _memoryTracker.update(_accumulatedFields[i].fieldName, group[i]->getMemUsage());
+        }
+        return inserted;
     }
 
-private:
-    ValueComparator _valueComparator;
-};
-
-class SpillSTLComparator {
-public:
-    SpillSTLComparator(ValueComparator valueComparator) : _valueComparator(valueComparator) {}
-
-    bool operator()(const GroupsMap::value_type* lhs, const GroupsMap::value_type* rhs) const {
-        return _valueComparator.evaluate(lhs->first < rhs->first);
+    for (size_t i = 0; i < numAccumulators; i++) {
+        group[i]->process(_accumulatedFields[i].expr.argument->evaluate(root, &pExpCtx->variables),
+                          _doingMerge);
+        _memoryTracker.update(_accumulatedFields[i].fieldName, group[i]->getMemUsage());
     }
-
-private:
-    ValueComparator _valueComparator;
-};
-}  // namespace
+    return inserted;
+}
 
 DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
-    const size_t numAccumulators = _accumulatedFields.size();
-
     // Barring any pausing, this loop exhausts 'pSource' and populates '_groups'.
     GetNextResult input = pSource->getNext();
 
     for (; input.isAdvanced(); input = pSource->getNext()) {
         if (shouldSpillWithAttemptToSaveMemory()) {
-            _sortedFiles.push_back(spill());
+            spill(&_spillPartitions, 0);
         }
 
         // We release the result document here so that it does not outlive the end of this loop
         // iteration. Not releasing could lead to an array copy when this group follows an unwind.
-        auto rootDocument = input.releaseDocument();
-        Value id = computeId(rootDocument);
-
-        // Look for the _id value in the map. If it's not there, add a new entry with a blank
-        // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
-        // looking it up in '_groups' multiple times.
-        const size_t oldSize = _groups->size();
-        vector<intrusive_ptr<AccumulatorState>>& group = (*_groups)[id];
-        const bool inserted = _groups->size() != oldSize;
-
-        vector<uint64_t> oldAccumMemUsage(numAccumulators, 0);
-        if (inserted) {
-            _memoryTracker.set(_memoryTracker.currentMemoryBytes() + id.getApproximateSize());
-
-            // Initialize and add the accumulators
-            Value expandedId = expandId(id);
-            Document idDoc =
-                expandedId.getType() == BSONType::Object ? expandedId.getDocument() : Document();
-            group.reserve(numAccumulators);
-            for (auto&& accumulatedField : _accumulatedFields) {
-                auto accum = accumulatedField.makeAccumulator();
-                Value initializerValue =
-                    accumulatedField.expr.initializer->evaluate(idDoc, &pExpCtx->variables);
-                accum->startNewGroup(initializerValue);
-                group.push_back(accum);
-            }
-        } else {
-            for (size_t i = 0; i < group.size(); i++) {
-                // subtract old mem usage. New usage added back after processing.
-                _memoryTracker.update(_accumulatedFields[i].fieldName,
-                                      -1 * group[i]->getMemUsage());
-            }
-        }
-
-        /* tickle all the accumulators for the group we found */
-        dassert(numAccumulators == group.size());
-
-        for (size_t i = 0; i < numAccumulators; i++) {
-            group[i]->process(
-                _accumulatedFields[i].expr.argument->evaluate(rootDocument, &pExpCtx->variables),
-                _doingMerge);
-            _memoryTracker.update(_accumulatedFields[i].fieldName, group[i]->getMemUsage());
-        }
+        const bool inserted = processDocument(input.releaseDocument());
 
         if (kDebugBuild && !storageGlobalParams.readOnly) {
             // In debug mode, spill every time we have a duplicate id to stress merge logic.
@@ -597,9 +841,9 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
                 !pExpCtx->inMongos &&  // can't spill to disk in mongos
                 !_memoryTracker
                      ._allowDiskUse &&       // don't change behavior when testing external sort
-                _sortedFiles.size() < 20) {  // don't open too many FDs
+                _stats.spills < 20) {        // don't write too many runs
 
-                _sortedFiles.push_back(spill());
+                spill(&_spillPartitions, 0);
             }
         }
     }
@@ -613,27 +857,20 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         }
         case DocumentSource::GetNextResult::ReturnStatus::kEOF: {
             // Do any final steps necessary to prepare to output results.
-            if (!_sortedFiles.empty()) {
+            if (!_spillPartitions.empty()) {
                 _spilled = true;
                 if (!_groups->empty()) {
-                    _sortedFiles.push_back(spill());
+                    spill(&_spillPartitions, 0);
                 }
 
-                // We won't be using groups again so free its memory.
-                _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
-
-                _sorterIterator.reset(Sorter<Value, Value>::Iterator::merge(
-                    _sortedFiles, SortOptions(), SorterComparator(pExpCtx->getValueComparator())));
-                _ownsFileDeletion = false;
-
-                // prepare current to accumulate data
-                _currentAccumulators.reserve(numAccumulators);
-                for (auto&& accumulatedField : _accumulatedFields) {
-                    _currentAccumulators.push_back(accumulatedField.makeAccumulator());
+                // Each partition will be aggregated on its own, in memory, as it is returned.
+                for (auto&& partition : _spillPartitions) {
+                    if (!partition.runs.empty()) {
+                        _pendingPartitions.push_back(std::move(partition));
+                    }
                 }
-
-                verify(_sorterIterator->more());  // we put data in, we should get something out.
-                _firstPartOfNextGroup = _sorterIterator->next();
+                _spillPartitions.clear();
+                verify(loadNextSpilledPartition());  // we put data in, we should get something out.
             } else {
                 // start the group iterator
                 groupsIterator = _groups->begin();
@@ -648,58 +885,135 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
     MONGO_UNREACHABLE;
 }
 
-shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
+DocumentSourceGroup::Accumulators& DocumentSourceGroup::findOrCreateGroup(const Value& id,
+                                                                         bool* inserted) {
+    // Look for the _id value in the map. If it's not there, add a new entry with a blank
+    // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
+    // looking it up in '_groups' multiple times.
+    const size_t oldSize = _groups->size();
+    Accumulators& group = (*_groups)[id];
+    *inserted = _groups->size() != oldSize;
+
+    if (*inserted) {
+        _memoryTracker.set(_memoryTracker.currentMemoryBytes() + id.getApproximateSize());
+
+        // Initialize and add the accumulators
+        Value expandedId = expandId(id);
+        Document idDoc =
+            expandedId.getType() == BSONType::Object ? expandedId.getDocument() : Document();
+        group.reserve(_accumulatedFields.size());
+        for (size_t i = 0; i < _accumulatedFields.size(); ++i) {
+            auto accum = makeAccumulator(i);
+            Value initializerValue =
+                _accumulatedFields[i].expr.initializer->evaluate(idDoc, &pExpCtx->variables);
+            accum->startNewGroup(initializerValue);
+            group.push_back(accum);
+        }
+    } else {
+        for (size_t i = 0; i < group.size(); i++) {
+            // subtract old mem usage. New usage added back after processing.
+            _memoryTracker.update(_accumulatedFields[i].fieldName, -1 * group[i]->getMemUsage());
+        }
+    }
+    return group;
+}
+
+intrusive_ptr<DocumentSourceGroup> DocumentSourceGroup::cloneWithoutAbsorbedSort() const {
+    intrusive_ptr<DocumentSourceGroup> group(
+        new DocumentSourceGroup(pExpCtx, getMaxMemoryUsageBytes()));
+    group->_idExpressions = _idExpressions;
+    group->_idFieldNames = _idFieldNames;
+    for (auto&& accumulatedField : _accumulatedFields) {
+        group->addAccumulator(accumulatedField);
+        group->_memoryTracker.set(accumulatedField.fieldName, 0);
+    }
+    return group;
+}
+
+intrusive_ptr<AccumulatorState> DocumentSourceGroup::makeAccumulator(size_t i) const {
+    if (_absorbedSortKeyComparator) {
+        return new AccumulatorBySortKey(
+            pExpCtx.get(), _absorbedSortKeyComparator, _absorbedSortTakesFirst[i]);
+    }
+    return _accumulatedFields[i].makeAccumulator();
+}
+
+size_t DocumentSourceGroup::spillPartitionFor(const Value& id, size_t depth) const {
+    uint64_t hash = pExpCtx->getValueComparator().hash(id);
+
+    // Mix the hash (using the MurmurHash3 finalizer) so that every group of bits depends on the
+    // whole key, and the bits used at one depth say nothing about those used at the next.
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    return (hash >> (depth * kSpillPartitionBits)) & (kNumSpillPartitions - 1);
+}
+
+void DocumentSourceGroup::spill(std::vector<SpillPartition>* partitions, size_t depth) {
     _stats.spills++;
 
-    vector<const GroupsMap::value_type*> ptrs;  // using pointers to speed sorting
-    ptrs.reserve(_groups->size());
-    for (GroupsMap::const_iterator it = _groups->begin(), end = _groups->end(); it != end; ++it) {
-        ptrs.push_back(&*it);
+    if (partitions->empty()) {
+        partitions->resize(kNumSpillPartitions);
+        for (auto&& partition : *partitions) {
+            partition.depth = depth;
+        }
     }
 
-    stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator(pExpCtx->getValueComparator()));
+    // Bucket the groups by partition so that each partition gets a single run per spill. Since
+    // a partition is aggregated with a hash table when it is read back, and never merged with
+    // other runs by key, the runs do not need to be sorted.
+    vector<vector<const GroupsMap::value_type*>> buckets(kNumSpillPartitions);
+    for (auto&& group : *_groups) {
+        buckets[spillPartitionFor(group.first, depth)].push_back(&group);
+    }
 
-    SortedFileWriter<Value, Value> writer(
-        SortOptions().TempDir(pExpCtx->tempDir), _fileName, _nextSortedFileWriterOffset);
-    switch (_accumulatedFields.size()) {  // same as ptrs[i]->second.size() for all i.
-        case 0:                           // no values, essentially a distinct
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
-            }
-            break;
+    for (size_t partition = 0; partition < kNumSpillPartitions; ++partition) {
+        const auto& ptrs = buckets[partition];
+        if (ptrs.empty()) {
+            continue;
+        }
 
-        case 1:  // just one value, use optimized serialization as single Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
-            }
-            break;
+        SortedFileWriter<Value, Value> writer(
+            SortOptions().TempDir(pExpCtx->tempDir), _fileName, _nextSortedFileWriterOffset);
+        switch (_accumulatedFields.size()) {  // same as ptrs[i]->second.size() for all i.
+            case 0:                           // no values, essentially a distinct
+                for (size_t i = 0; i < ptrs.size(); i++) {
+                    writer.addAlreadySorted(ptrs[i]->first, Value());
+                }
+                break;
 
-        default:  // multiple values, serialize as array-typed Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                vector<Value> accums;
-                for (size_t j = 0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
+            case 1:  // just one value, use optimized serialization as single Value
+                for (size_t i = 0; i < ptrs.size(); i++) {
+                    writer.addAlreadySorted(ptrs[i]->first,
+                                            ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
                 }
-                writer.addAlreadySorted(ptrs[i]->first, Value(std::move(accums)));
-            }
-            break;
+                break;
+
+            default:  // multiple values, serialize as array-typed Value
+                for (size_t i = 0; i < ptrs.size(); i++) {
+                    vector<Value> accums;
+                    for (size_t j = 0; j < ptrs[i]->second.size(); j++) {
+                        accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
+                    }
+                    writer.addAlreadySorted(ptrs[i]->first, Value(std::move(accums)));
+                }
+                break;
+        }
+
+        (*partitions)[partition].runs.emplace_back(writer.done());
+        _nextSortedFileWriterOffset = writer.getFileEndOffset();
     }
 
     auto& metricsCollector = ResourceConsumption::MetricsCollector::get(pExpCtx->opCtx);
-    metricsCollector.incrementKeysSorted(ptrs.size());
+    metricsCollector.incrementKeysSorted(_groups->size());
     metricsCollector.incrementSorterSpills(1);
 
     _groups->clear();
-    // Zero out the current per-accumulation statement memory consumption, as the memory has been
-    // freed by spilling.
-    for (auto accum : _accumulatedFields) {
-        _memoryTracker.set(accum.fieldName, 0);
-    }
-
-    Sorter<Value, Value>::Iterator* iteratorPtr = writer.done();
-    _nextSortedFileWriterOffset = writer.getFileEndOffset();
-    return shared_ptr<Sorter<Value, Value>::Iterator>(iteratorPtr);
+    // Zero out the current memory consumption, as the memory has been freed by spilling.
+    _memoryTracker.resetCurrent();
 }
 
 Value DocumentSourceGroup::computeId(const Document& root) {
@@ -762,6 +1076,19 @@ Document DocumentSourceGroup::makeDocument(const Value& id,
 }
 
 boost::optional<DocumentSource::DistributedPlanLogic> DocumentSourceGroup::distributedPlanLogic() {
+    if (_absorbedSortPattern) {
+        // Split as the original $sort and $group would: the shards sort, and the merger groups the
+        // merged sorted streams with the ordinary accumulators. This stage is left as it is, since
+        // callers may only be asking whether it can be split.
+        DistributedPlanLogic split;
+        split.shardsStage = DocumentSourceSort::create(pExpCtx, *_absorbedSortPattern);
+        split.mergingStage = cloneWithoutAbsorbedSort();
+        split.inputSortPattern =
+            _absorbedSortPattern->serialize(SortPattern::SortKeySerialization::kForSortKeyMerging)
+                .toBson();
+        return split;
+    }
+
     intrusive_ptr<DocumentSourceGroup> mergingGroup(new DocumentSourceGroup(pExpCtx));
     mergingGroup->setDoingMerge(true);
 
@@ -823,6 +1150,11 @@ bool DocumentSourceGroup::canRunInParallelBeforeWriteStage(
 
 std::unique_ptr<GroupFromFirstDocumentTransformation>
 DocumentSourceGroup::rewriteGroupAsTransformOnFirstDocument() const {
+    if (_absorbedSortPattern) {
+        // The first document of each group is not the first one in the input.
+        return nullptr;
+    }
+
     if (_idExpressions.size() != 1) {
         // This transformation is only intended for $group stages that group on a single field.
         return nullptr;
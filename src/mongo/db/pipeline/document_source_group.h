@@ -32,6 +32,7 @@
 #include <memory>
 #include <utility>
 
+#include "mongo/db/index/sort_key_generator.h"
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document_source.h"
@@ -41,6 +42,8 @@
 
 namespace mongo {
 
+class SortKeyComparator;
+
 /**
  * GroupFromFirstTransformation consists of a list of (field name, expression pairs). It returns a
  * document synthesized by assigning each field name in the output document to the result of
@@ -189,6 +192,30 @@ public:
      */
     size_t getMaxMemoryUsageBytes() const;
 
+    /**
+     * Tells this stage that its input arrives sorted by 'sortPattern'. If the group key is made up
+     * of top-level fields which form a prefix of 'sortPattern', the stage streams: it returns each
+     * group as soon as the input moves past it, rather than after consuming all of its input.
+     *
+     * Returns whether the stage will stream.
+     */
+    bool setInputSortPattern(const SortPattern& sortPattern);
+
+    /**
+     * Called when this stage directly follows a $sort on 'sortPattern' which has no limit. If every
+     * accumulator is $first or $last, and the sort cannot be used to stream the groups or to scan
+     * the first document of each group, this stage takes over the sort: each accumulator keeps
+     * only the value from the document which would have come first (or last) in its group, and
+     * the input is never sorted. The stage still serializes as the original $sort and $group.
+     *
+     * Returns whether the sort was absorbed, in which case the caller must remove the $sort.
+     */
+    bool absorbPrecedingSort(const SortPattern& sortPattern);
+
+    void serializeToArray(
+        std::vector<Value>& array,
+        boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
+
 protected:
     GetNextResult doGetNext() final;
     void doDispose() final;
@@ -200,13 +227,44 @@ private:
     ~DocumentSourceGroup();
 
     /**
-     * getNext() dispatches to one of these three depending on what type of $group it is. These
-     * methods expect '_currentAccumulators' to have been reset before being called, and also expect
-     * initialize() to have been called already.
+     * A set of partially aggregated groups which were spilled to disk, all of whose keys hash to
+     * the same partition.
+     */
+    struct SpillPartition {
+        // Runs of partially aggregated groups, in the order in which they were spilled.
+        std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>> runs;
+
+        // The number of times the groups in this partition have been partitioned. Selects which
+        // bits of the key's hash choose the sub-partition if this partition must be split again.
+        size_t depth = 0;
+    };
+
+    /**
+     * getNext() dispatches to one of these two depending on whether the $group has spilled. These
+     * methods expect initialize() to have been called already.
      */
     GetNextResult getNextSpilled();
     GetNextResult getNextStandard();
 
+    /**
+     * getNext() dispatches to this instead when the input is sorted on the group key. Groups are
+     * accumulated until the input's sort key changes, at which point they are all complete.
+     */
+    GetNextResult getNextStreaming();
+
+    /**
+     * Called by getNextStreaming() after adding a document to '_groups'. If that exceeded the
+     * memory limit, stops streaming so that the remaining input is grouped without relying on its
+     * sort order, and returns true.
+     */
+    bool stopStreamingIfOutOfMemory();
+
+    /**
+     * Adds 'root' to the group in '_groups' which it belongs to. Returns whether the group had to
+     * be created.
+     */
+    bool processDocument(const Document& root);
+
     /**
      * Before returning anything, this source must prepare itself. In a streaming $group,
      * initialize() requests the first document from the previous source, and uses it to prepare the
@@ -220,11 +278,35 @@ private:
     GetNextResult initialize();
 
     /**
-     * Spill groups map to disk and returns an iterator to the file. Note: Since a sorted $group
-     * does not exhaust the previous stage before returning, and thus does not maintain as large a
-     * store of documents at any one time, only an unsorted group can spill to disk.
+     * Spills the groups map to disk, appending one run to each of 'partitions' (which is filled
+     * with 'kNumSpillPartitions' empty partitions if it is empty) for the groups whose keys hash to
+     * that partition at the given 'depth'.
+     */
+    void spill(std::vector<SpillPartition>* partitions, size_t depth);
+
+    /**
+     * Replaces the groups map with the contents of the next pending spilled partition, aggregating
+     * the partial groups from each of its runs. If the partition does not fit in memory, it is
+     * split into sub-partitions which are pushed back onto '_pendingPartitions' instead, leaving
+     * the groups map empty.
+     *
+     * Returns false if there are no pending partitions left.
+     */
+    bool loadNextSpilledPartition();
+
+    /**
+     * Returns the accumulators for the group with key 'id', creating and initializing them if this
+     * is the first time the key has been seen, which is reported through 'inserted'. The memory
+     * used by the accumulators is subtracted from '_memoryTracker', so the caller must add it back
+     * once it has processed its input.
+     */
+    Accumulators& findOrCreateGroup(const Value& id, bool* inserted);
+
+    /**
+     * Returns which of the 'kNumSpillPartitions' partitions the group with key 'id' belongs to
+     * when partitioning at the given 'depth'.
      */
-    std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
+    size_t spillPartitionFor(const Value& id, size_t depth) const;
 
     /**
      * If we ran out of memory, finish all the pending operations so that some memory
@@ -245,6 +327,23 @@ private:
      */
     Value expandId(const Value& val);
 
+    /**
+     * If the group key is made up of field paths which are exactly the leading fields of
+     * 'sortPattern', in any order, returns the part of 'sortPattern' which covers them.
+     */
+    boost::optional<SortPattern> groupKeySortPrefix(const SortPattern& sortPattern) const;
+
+    /**
+     * Returns a new $group with the same group key and accumulators as this one, which has not
+     * absorbed a $sort, to stand in for this stage when it runs after its absorbed $sort.
+     */
+    boost::intrusive_ptr<DocumentSourceGroup> cloneWithoutAbsorbedSort() const;
+
+    /**
+     * Creates the accumulator for '_accumulatedFields[i]' in a new group.
+     */
+    boost::intrusive_ptr<AccumulatorState> makeAccumulator(size_t i) const;
+
     /**
      * Returns true if 'dottedPath' is one of the group keys present in '_idExpressions'.
      */
@@ -268,31 +367,51 @@ private:
 
     std::string _fileName;
     std::streampos _nextSortedFileWriterOffset = 0;
-    bool _ownsFileDeletion = true;  // unless a MergeIterator is made that takes over.
 
     std::vector<std::string> _idFieldNames;  // used when id is a document
     std::vector<boost::intrusive_ptr<Expression>> _idExpressions;
 
     bool _initialized;
 
-    Value _currentId;
-    Accumulators _currentAccumulators;
-
     // We use boost::optional to defer initialization until the ExpressionContext containing the
     // correct comparator is injected, since the groups must be built using the comparator's
     // definition of equality.
     boost::optional<GroupsMap> _groups;
 
-    std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>> _sortedFiles;
+    // The partitions which groups are spilled to while consuming the input, each holding the
+    // groups whose keys share a hash partition.
+    std::vector<SpillPartition> _spillPartitions;
     bool _spilled;
 
-    // Only used when '_spilled' is false.
+    // Iterates over '_groups'. When '_spilled' is true, '_groups' only holds the partition which
+    // is currently being returned.
     GroupsMap::iterator groupsIterator;
 
-    // Only used when '_spilled' is true.
-    std::unique_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
-
-    std::pair<Value, Value> _firstPartOfNextGroup;
+    // Only used when '_spilled' is true. The spilled partitions which have not been returned yet.
+    std::vector<SpillPartition> _pendingPartitions;
+
+    // Whether the preceding stage has been checked for a sort that allows streaming.
+    bool _checkedInputSort = false;
+
+    // Set when the input is sorted on the group key (see setInputSortPattern()). Generates the
+    // part of the input's sort key which covers the group key.
+    boost::optional<SortKeyGenerator> _streamingSortKeyGen;
+
+    // Only used when streaming. The sort key of the groups currently in '_groups', the document
+    // which moved the input past them, and whether they are being returned.
+    boost::optional<Value> _streamingSortKey;
+    boost::optional<Document> _firstDocumentOfNextGroups;
+    bool _streamingGroupsReady = false;
+    bool _streamingInputExhausted = false;
+
+    // Set when the $sort which preceded this stage has been absorbed (see absorbPrecedingSort()).
+    // Each document's sort key is generated once and passed to every accumulator alongside its
+    // argument, and '_absorbedSortTakesFirst[i]' says whether the i-th accumulator keeps the value
+    // with the lowest sort key ($first) or the highest ($last).
+    boost::optional<SortPattern> _absorbedSortPattern;
+    boost::optional<SortKeyGenerator> _absorbedSortKeyGen;
+    std::shared_ptr<const SortKeyComparator> _absorbedSortKeyComparator;
+    std::vector<bool> _absorbedSortTakesFirst;
 };
 
 }  // namespace mongo
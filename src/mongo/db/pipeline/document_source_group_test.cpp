@@ -51,6 +51,7 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/query/query_test_service_context.h"
+#include "mongo/db/query/sort_pattern.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/unordered_set.h"
 #include "mongo/unittest/temp_dir.h"
@@ -148,6 +149,51 @@ TEST_F(DocumentSourceGroupTest, ShouldBeAbleToPauseLoadingWhileSpilled) {
     ASSERT_EQ(idSet.count(2), 1UL);
 }
 
+TEST_F(DocumentSourceGroupTest, ShouldRepartitionSpilledGroupsThatDoNotFitInMemory) {
+    auto expCtx = getExpCtx();
+
+    // Allow the $group stage to spill to disk, with a limit small enough that even a single
+    // spilled partition has to be split again to be aggregated.
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    const size_t maxMemoryUsageBytes = 1000;
+
+    auto&& parser = AccumulationStatement::getParser("$push", boost::none);
+    auto accumulatorArg = BSON(""
+                               << "$x");
+    auto accExpr = parser(expCtx.get(), accumulatorArg.firstElement(), expCtx->variablesParseState);
+    AccumulationStatement pushStatement{"xs", accExpr};
+    auto groupByExpression =
+        ExpressionFieldPath::parse(expCtx.get(), "$key", expCtx->variablesParseState);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {pushStatement}, maxMemoryUsageBytes);
+
+    // Every key appears in several rounds of input, so its partial groups are spread over many
+    // spilled runs.
+    const int kNumKeys = 500;
+    const int kNumRounds = 3;
+    std::deque<DocumentSource::GetNextResult> inputs;
+    for (int round = 0; round < kNumRounds; ++round) {
+        for (int key = 0; key < kNumKeys; ++key) {
+            inputs.push_back(Document{{"key", key}, {"x", round}});
+        }
+    }
+    auto mock = DocumentSourceMock::createForTest(std::move(inputs), expCtx);
+    group->setSource(mock.get());
+
+    // Each group should be returned once, with its values in input order.
+    stdx::unordered_set<int> idSet;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        ASSERT_TRUE(idSet.insert(doc["_id"].coerceToInt()).second);
+        ASSERT_VALUE_EQ(doc["xs"], Value(std::vector<Value>{Value(0), Value(1), Value(2)}));
+    }
+    ASSERT_TRUE(group->getNext().isEOF());
+    ASSERT_EQ(idSet.size(), static_cast<size_t>(kNumKeys));
+    ASSERT_TRUE(group->usedDisk());
+}
+
 TEST_F(DocumentSourceGroupTest, ShouldErrorIfNotAllowedToSpillToDiskAndResultSetIsTooLarge) {
     auto expCtx = getExpCtx();
     const size_t maxMemoryUsageBytes = 1000;
@@ -207,6 +253,210 @@ TEST_F(DocumentSourceGroupTest, ShouldCorrectlyTrackMemoryUsageBetweenPauses) {
         group->getNext(), AssertionException, ErrorCodes::QueryExceededMemoryLimitNoDiskUseAllowed);
 }
 
+intrusive_ptr<DocumentSourceGroup> makeSumOfXGroupedBy(
+    const intrusive_ptr<ExpressionContext>& expCtx, const std::string& groupByPath) {
+    auto&& parser = AccumulationStatement::getParser("$sum", boost::none);
+    auto accumulatorArg = BSON(""
+                               << "$x");
+    auto accExpr = parser(expCtx.get(), accumulatorArg.firstElement(), expCtx->variablesParseState);
+    AccumulationStatement sumStatement{"total", accExpr};
+    auto groupByExpression =
+        ExpressionFieldPath::parse(expCtx.get(), groupByPath, expCtx->variablesParseState);
+    return DocumentSourceGroup::create(expCtx, groupByExpression, {sumStatement});
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldStreamGroupsWhenInputIsSortedOnGroupKey) {
+    auto expCtx = getExpCtx();
+    auto group = makeSumOfXGroupedBy(expCtx, "$a");
+    ASSERT_TRUE(group->setInputSortPattern(SortPattern(BSON("a" << 1 << "b" << 1), expCtx)));
+
+    auto mock =
+        DocumentSourceMock::createForTest({Document{{"a", 1}, {"x", 1}},
+                                           Document{{"a", 1}, {"x", 2}},
+                                           Document{{"a", 2}, {"x", 3}},
+                                           DocumentSource::GetNextResult::makePauseExecution(),
+                                           Document{{"a", 2}, {"x", 4}},
+                                           Document{{"a", 3}, {"x", 5}}},
+                                          expCtx);
+    group->setSource(mock.get());
+
+    // The first group is complete as soon as the input moves on to the next key, before the pause.
+    auto result = group->getNext();
+    ASSERT_TRUE(result.isAdvanced());
+    ASSERT_DOCUMENT_EQ(result.releaseDocument(), (Document{{"_id", 1}, {"total", 3}}));
+
+    ASSERT_TRUE(group->getNext().isPaused());
+
+    result = group->getNext();
+    ASSERT_TRUE(result.isAdvanced());
+    ASSERT_DOCUMENT_EQ(result.releaseDocument(), (Document{{"_id", 2}, {"total", 7}}));
+
+    result = group->getNext();
+    ASSERT_TRUE(result.isAdvanced());
+    ASSERT_DOCUMENT_EQ(result.releaseDocument(), (Document{{"_id", 3}, {"total", 5}}));
+
+    ASSERT_TRUE(group->getNext().isEOF());
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldNotSplitGroupsWhenStreamingOverArrayKeys) {
+    auto expCtx = getExpCtx();
+    auto group = makeSumOfXGroupedBy(expCtx, "$a");
+    ASSERT_TRUE(group->setInputSortPattern(SortPattern(BSON("a" << 1), expCtx)));
+
+    // The array sorts by its smallest element, so it lands among the scalar 1s.
+    auto mock = DocumentSourceMock::createForTest(
+        {Document{{"a", 1}, {"x", 1}},
+         Document{{"a", std::vector<Value>{Value(1), Value(3)}}, {"x", 2}},
+         Document{{"a", 1}, {"x", 4}},
+         Document{{"a", 2}, {"x", 8}}},
+        expCtx);
+    group->setSource(mock.get());
+
+    std::map<std::string, int> totals;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        ASSERT_TRUE(totals.emplace(doc["_id"].toString(), doc["total"].coerceToInt()).second);
+    }
+    ASSERT_EQ(totals.size(), 3UL);
+    ASSERT_EQ(totals[Value(1).toString()], 5);
+    ASSERT_EQ(totals[Value(std::vector<Value>{Value(1), Value(3)}).toString()], 2);
+    ASSERT_EQ(totals[Value(2).toString()], 8);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldOnlyStreamWhenGroupKeyIsASortPrefixOfTopLevelFields) {
+    auto expCtx = getExpCtx();
+    ASSERT_FALSE(makeSumOfXGroupedBy(expCtx, "$a")->setInputSortPattern(
+        SortPattern(BSON("b" << 1 << "a" << 1), expCtx)));
+    ASSERT_FALSE(makeSumOfXGroupedBy(expCtx, "$a.b")->setInputSortPattern(
+        SortPattern(BSON("a.b" << 1), expCtx)));
+    ASSERT_TRUE(makeSumOfXGroupedBy(expCtx, "$a")->setInputSortPattern(
+        SortPattern(BSON("a" << -1), expCtx)));
+}
+
+intrusive_ptr<DocumentSourceGroup> makeFirstAndLastOfXGroupedByA(
+    const intrusive_ptr<ExpressionContext>& expCtx, boost::optional<size_t> maxMemoryUsageBytes) {
+    VariablesParseState vps = expCtx->variablesParseState;
+    std::vector<AccumulationStatement> statements;
+    for (auto&& [fieldName, op] : {std::make_pair("f", "$first"), std::make_pair("l", "$last")}) {
+        auto&& parser = AccumulationStatement::getParser(op, boost::none);
+        auto accumulatorArg = BSON(""
+                                   << "$x");
+        statements.emplace_back(fieldName,
+                                parser(expCtx.get(), accumulatorArg.firstElement(), vps));
+    }
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx.get(), "$a", vps);
+    return DocumentSourceGroup::create(
+        expCtx, groupByExpression, std::move(statements), maxMemoryUsageBytes);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldStopStreamingWhenTheFirstDocumentOfTheNextGroupsIsTooLarge) {
+    auto expCtx = getExpCtx();
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    auto group = makeFirstAndLastOfXGroupedByA(expCtx, size_t{1000});
+    ASSERT_TRUE(group->setInputSortPattern(SortPattern(BSON("a" << 1), expCtx)));
+
+    // The group of a: 2 alone exceeds the memory limit. It is started only once the group of a: 1
+    // has been returned, and a: 3 then moves the input past it.
+    const std::string bigString(2000, 'x');
+    auto mock = DocumentSourceMock::createForTest({Document{{"a", 1}, {"x", 1}},
+                                                   Document{{"a", 2}, {"x", bigString}},
+                                                   Document{{"a", 3}, {"x", 3}}},
+                                                  expCtx);
+    group->setSource(mock.get());
+
+    auto result = group->getNext();
+    ASSERT_TRUE(result.isAdvanced());
+    ASSERT_DOCUMENT_EQ(result.releaseDocument(), (Document{{"_id", 1}, {"f", 1}, {"l", 1}}));
+
+    std::map<int, Document> results;
+    for (result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        ASSERT_TRUE(results.emplace(doc["_id"].coerceToInt(), doc).second);
+    }
+    ASSERT_EQ(results.size(), 2UL);
+    ASSERT_DOCUMENT_EQ(results[2], (Document{{"_id", 2}, {"f", bigString}, {"l", bigString}}));
+    ASSERT_DOCUMENT_EQ(results[3], (Document{{"_id", 3}, {"f", 3}, {"l", 3}}));
+    ASSERT_TRUE(group->usedDisk());
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldTakeFirstAndLastBySortKeyWhenSortIsAbsorbed) {
+    auto expCtx = getExpCtx();
+    auto group = makeFirstAndLastOfXGroupedByA(expCtx, boost::none);
+    ASSERT_TRUE(group->absorbPrecedingSort(SortPattern(BSON("b" << -1), expCtx)));
+
+    // Sorted by descending 'b', the groups are a: 1 -> [c, (missing), a], a: 2 -> [q, p, r] and
+    // a: 3 -> [z, (missing)]. Of the equal sort keys in group 2, $first sees 'p' first and $last
+    // sees 'r' last.
+    auto mock = DocumentSourceMock::createForTest({Document{{"a", 1}, {"b", 3}, {"x", "c"_sd}},
+                                                   Document{{"a", 2}, {"b", 1}, {"x", "p"_sd}},
+                                                   Document{{"a", 1}, {"b", 1}, {"x", "a"_sd}},
+                                                   Document{{"a", 3}, {"b", 0}},
+                                                   Document{{"a", 1}, {"b", 2}},
+                                                   Document{{"a", 2}, {"b", 5}, {"x", "q"_sd}},
+                                                   Document{{"a", 2}, {"b", 1}, {"x", "r"_sd}},
+                                                   Document{{"a", 3}, {"b", 9}, {"x", "z"_sd}}},
+                                                  expCtx);
+    group->setSource(mock.get());
+
+    std::map<int, Document> results;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        ASSERT_TRUE(results.emplace(doc["_id"].coerceToInt(), doc).second);
+    }
+    ASSERT_EQ(results.size(), 3UL);
+    ASSERT_DOCUMENT_EQ(results[1], (Document{{"_id", 1}, {"f", "c"_sd}, {"l", "a"_sd}}));
+    ASSERT_DOCUMENT_EQ(results[2], (Document{{"_id", 2}, {"f", "q"_sd}, {"l", "r"_sd}}));
+    ASSERT_VALUE_EQ(results[3]["f"], Value("z"_sd));
+    ASSERT_TRUE(results[3]["l"].missing());
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldTakeFirstAndLastBySortKeyWhenAbsorbedSortSpills) {
+    auto expCtx = getExpCtx();
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    auto group = makeFirstAndLastOfXGroupedByA(expCtx, size_t{1000});
+    ASSERT_TRUE(group->absorbPrecedingSort(SortPattern(BSON("b" << 1), expCtx)));
+
+    // Each key's smallest and largest 'b' arrive in different rounds of input, so they end up in
+    // different spilled runs.
+    const int kNumKeys = 500;
+    std::deque<DocumentSource::GetNextResult> inputs;
+    for (int b : {5, 1, 9, 3}) {
+        for (int key = 0; key < kNumKeys; ++key) {
+            inputs.push_back(Document{{"a", key}, {"b", b}, {"x", key * 10 + b}});
+        }
+    }
+    auto mock = DocumentSourceMock::createForTest(std::move(inputs), expCtx);
+    group->setSource(mock.get());
+
+    stdx::unordered_set<int> idSet;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        const int key = doc["_id"].coerceToInt();
+        ASSERT_TRUE(idSet.insert(key).second);
+        ASSERT_DOCUMENT_EQ(doc, (Document{{"_id", key}, {"f", key * 10 + 1}, {"l", key * 10 + 9}}));
+    }
+    ASSERT_EQ(idSet.size(), static_cast<size_t>(kNumKeys));
+    ASSERT_TRUE(group->usedDisk());
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldOnlyAbsorbSortWhenGroupNeedsFirstOrLastDocuments) {
+    auto expCtx = getExpCtx();
+    ASSERT_FALSE(makeSumOfXGroupedBy(expCtx, "$a")->absorbPrecedingSort(
+        SortPattern(BSON("b" << 1), expCtx)));
+    ASSERT_FALSE(makeFirstAndLastOfXGroupedByA(expCtx, boost::none)
+                     ->absorbPrecedingSort(SortPattern(BSON("a" << 1 << "b" << 1), expCtx)));
+    ASSERT_FALSE(makeFirstAndLastOfXGroupedByA(expCtx, boost::none)
+                     ->absorbPrecedingSort(SortPattern(BSON("score" << BSON("$meta"
+                                                                             << "textScore")),
+                                                       expCtx)));
+    ASSERT_TRUE(makeFirstAndLastOfXGroupedByA(expCtx, boost::none)
+                    ->absorbPrecedingSort(SortPattern(BSON("b" << 1 << "a" << 1), expCtx)));
+}
+
 TEST_F(DocumentSourceGroupTest, ShouldReportSingleFieldGroupKeyAsARename) {
     auto expCtx = getExpCtx();
     VariablesParseState vps = expCtx->variablesParseState;
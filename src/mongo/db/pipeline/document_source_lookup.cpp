@@ -39,9 +39,11 @@
 #include "mongo/db/exec/document_value/value.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression_algo.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pipeline/aggregation_request_helper.h"
 #include "mongo/db/pipeline/document_path_support.h"
 #include "mongo/db/pipeline/document_source_merge_gen.h"
+#include "mongo/db/pipeline/document_source_queue.h"
 #include "mongo/db/pipeline/document_source_sort.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
@@ -91,6 +93,20 @@ bool foreignShardedLookupAllowed() {
     return getTestCommandsEnabled() && internalQueryAllowShardedLookup.load();
 }
 
+/**
+ * Called when reading from the foreign collection threw 'ex'. If lookup on a sharded collection is
+ * disallowed and the foreign collection is sharded, throws a custom exception.
+ */
+void assertForeignCollectionNotSharded(
+    const ExceptionForCat<ErrorCategory::StaleShardVersionError>& ex) {
+    if (auto staleInfo = ex.extraInfo<StaleConfigInfo>()) {
+        uassert(51069,
+                "Cannot run $lookup with sharded foreign collection",
+                foreignShardedLookupAllowed() || !staleInfo->getVersionWanted() ||
+                    staleInfo->getVersionWanted() == ChunkVersion::UNSHARDED());
+    }
+}
+
 // Parses $lookup 'from' field. The 'from' field must be a string or one of the following
 // exceptions:
 // {from: {db: "config", coll: "cache.chunks.*"}, ...} or
@@ -344,7 +360,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
         return unwindResult();
     }
 
-    auto nextInput = pSource->getNext();
+    auto nextInput = getNextInput();
     if (!nextInput.isAdvanced()) {
         return nextInput;
     }
@@ -355,25 +371,11 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
-    if (hasLocalFieldForeignFieldJoin()) {
-        auto matchStage =
-            makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
-        // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-        _resolvedPipeline[*_fieldMatchPipelineIdx] = matchStage;
-    }
-
     std::unique_ptr<Pipeline, PipelineDeleter> pipeline;
     try {
-        pipeline = buildPipeline(inputDoc);
+        pipeline = buildPipelineForInput(inputDoc);
     } catch (const ExceptionForCat<ErrorCategory::StaleShardVersionError>& ex) {
-        // If lookup on a sharded collection is disallowed and the foreign collection is sharded,
-        // throw a custom exception.
-        if (auto staleInfo = ex.extraInfo<StaleConfigInfo>()) {
-            uassert(51069,
-                    "Cannot run $lookup with sharded foreign collection",
-                    foreignShardedLookupAllowed() || !staleInfo->getVersionWanted() ||
-                        staleInfo->getVersionWanted() == ChunkVersion::UNSHARDED());
-        }
+        assertForeignCollectionNotSharded(ex);
         throw;
     }
 
@@ -463,6 +465,241 @@ std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipeline(
     return pipeline;
 }
 
+DocumentSourceLookUp::ForeignDocumentTable::ForeignDocumentTable(
+    const boost::intrusive_ptr<ExpressionContext>& fromExpCtx, const FieldPath& foreignField)
+    : _foreignPath(foreignField.fullPath()),
+      _nullMatcher(uassertStatusOK(MatchExpressionParser::parse(
+          BSON(foreignField.fullPath() << BSON("$eq" << BSONNULL)), fromExpCtx))),
+      _docsByValue(fromExpCtx->getValueComparator().makeUnorderedValueMap<std::vector<size_t>>()) {
+}
+
+bool DocumentSourceLookUp::ForeignDocumentTable::add(Document doc, long long maxMemoryUsageBytes) {
+    const auto docIdx = _docs.size();
+    const auto obj = doc.toBson();
+
+    // Index the document under every element an equality predicate on the foreignField would
+    // compare against, so that probing gives the same answer as the per-document $match. Null
+    // equality also matches missing fields along the path, which the matcher decides for us.
+    BSONElementIterator it(&_foreignPath, obj);
+    while (it.more()) {
+        auto elem = it.next().element();
+        if (elem.eoo() || elem.isNull() || elem.type() == BSONType::Undefined) {
+            continue;
+        }
+        auto& docIdxs = _docsByValue[Value(elem)];
+        if (docIdxs.empty()) {
+            _memoryUsageBytes += elem.size();
+        } else if (docIdxs.back() == docIdx) {
+            // The same value appears more than once in this document.
+            continue;
+        }
+        docIdxs.push_back(docIdx);
+        _memoryUsageBytes += sizeof(size_t);
+    }
+    if (_nullMatcher->matchesBSON(obj)) {
+        _nullMatches.push_back(docIdx);
+    }
+
+    _memoryUsageBytes += doc.getApproximateSize();
+    _docs.push_back(std::move(doc));
+    return _memoryUsageBytes <= maxMemoryUsageBytes;
+}
+
+std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::ForeignDocumentTable::probe(
+    const Document& input,
+    const FieldPath& localField,
+    const boost::intrusive_ptr<ExpressionContext>& fromExpCtx) const {
+    // As in makeMatchStageFromInput(), an array on the local path joins on each of its elements
+    // and a missing local value is treated as null.
+    std::vector<size_t> docIdxs;
+    bool probedNull = false;
+    bool foundLocalValue = false;
+    document_path_support::visitAllValuesAtPath(input, localField, [&](const Value& value) {
+        foundLocalValue = true;
+        if (value.nullish()) {
+            probedNull = true;
+        } else if (auto it = _docsByValue.find(value); it != _docsByValue.end()) {
+            docIdxs.insert(docIdxs.end(), it->second.begin(), it->second.end());
+        }
+    });
+    if (probedNull || !foundLocalValue) {
+        docIdxs.insert(docIdxs.end(), _nullMatches.begin(), _nullMatches.end());
+    }
+
+    // A foreign document matching several local values is returned once, in insertion order.
+    std::sort(docIdxs.begin(), docIdxs.end());
+    docIdxs.erase(std::unique(docIdxs.begin(), docIdxs.end()), docIdxs.end());
+
+    auto queue = DocumentSourceQueue::create(fromExpCtx);
+    for (auto docIdx : docIdxs) {
+        queue->emplace_back(Document(_docs[docIdx]));
+    }
+    return Pipeline::create({queue}, fromExpCtx);
+}
+
+bool DocumentSourceLookUp::isEqualityJoin() const {
+    return hasLocalFieldForeignFieldJoin() && !hasPipeline();
+}
+
+bool DocumentSourceLookUp::useHashJoin() {
+    if (_hashJoinState == HashJoinState::kUndecided) {
+        // Only a plain localField/foreignField join can be answered by a table keyed on the
+        // foreignField; a sub-pipeline may depend on the input document in arbitrary ways.
+        if (!isEqualityJoin() || pExpCtx->inMongos ||
+            internalDocumentSourceLookupHashJoinMaxMemoryBytes.load() == 0) {
+            _hashJoinState = HashJoinState::kAbandoned;
+        } else if (internalQueryForceLookupHashJoin.load() ||
+                   _stats.planSummaryStats.collectionScans > 0) {
+            // Every further query would scan the foreign collection again, so read it once
+            // instead.
+            try {
+                buildHashJoinTable();
+            } catch (const ExceptionForCat<ErrorCategory::StaleShardVersionError>& ex) {
+                assertForeignCollectionNotSharded(ex);
+                throw;
+            }
+        }
+    }
+    return _hashJoinState == HashJoinState::kBuilt;
+}
+
+void DocumentSourceLookUp::buildHashJoinTable() {
+    invariant(_hashJoinState == HashJoinState::kUndecided);
+
+    // Read the whole foreign collection, applying any $match we have absorbed but no join
+    // predicate.
+    _resolvedPipeline[*_fieldMatchPipelineIdx] =
+        BSON("$match" << _additionalFilter.value_or(BSONObj()));
+    auto pipeline = buildPipeline(Document());
+
+    _hashJoinTable.emplace(_fromExpCtx, *_foreignField);
+    const auto maxMemoryUsageBytes = internalDocumentSourceLookupHashJoinMaxMemoryBytes.load();
+    while (auto next = pipeline->getNext()) {
+        if (!_hashJoinTable->add(std::move(*next), maxMemoryUsageBytes)) {
+            // The foreign collection is too large to hold in memory. Fall back to querying it for
+            // each input document.
+            _hashJoinState = HashJoinState::kAbandoned;
+            _hashJoinTable.reset();
+            break;
+        }
+    }
+
+    recordPlanSummaryStats(*pipeline);
+    pipeline->dispose(pExpCtx->opCtx);
+
+    if (_hashJoinState == HashJoinState::kUndecided) {
+        _hashJoinState = HashJoinState::kBuilt;
+        _stats.usedHashJoin = true;
+    }
+}
+
+DocumentSource::GetNextResult DocumentSourceLookUp::getNextInput() {
+    if (!_batchedInputs.empty()) {
+        auto inputDoc = std::move(_batchedInputs.front());
+        _batchedInputs.pop_front();
+        return std::move(inputDoc);
+    }
+
+    // Any documents read along with the previous batch have been joined.
+    _batchTable.reset();
+    if (_batchedInputEnd) {
+        auto inputEnd = std::move(*_batchedInputEnd);
+        _batchedInputEnd.reset();
+        return inputEnd;
+    }
+
+    const auto batchSize = internalDocumentSourceLookupBatchSize.load();
+    if (!isEqualityJoin() || batchSize <= 1 || useHashJoin()) {
+        return pSource->getNext();
+    }
+
+    // Read ahead a batch of input documents and look up all of their local values with one query.
+    // The batch ends early if our source pauses, so that the pause reaches the caller in order.
+    while (_batchedInputs.size() < static_cast<size_t>(batchSize)) {
+        auto nextInput = pSource->getNext();
+        if (!nextInput.isAdvanced()) {
+            if (_batchedInputs.empty()) {
+                return nextInput;
+            }
+            _batchedInputEnd = std::move(nextInput);
+            break;
+        }
+        _batchedInputs.push_back(nextInput.releaseDocument());
+    }
+    try {
+        buildBatchTable();
+    } catch (const ExceptionForCat<ErrorCategory::StaleShardVersionError>& ex) {
+        assertForeignCollectionNotSharded(ex);
+        throw;
+    }
+
+    return getNextInput();
+}
+
+void DocumentSourceLookUp::buildBatchTable() {
+    invariant(!_batchedInputs.empty());
+
+    auto localValues = _fromExpCtx->getValueComparator().makeUnorderedValueSet();
+    for (auto&& inputDoc : _batchedInputs) {
+        bool foundLocalValue = false;
+        document_path_support::visitAllValuesAtPath(
+            inputDoc, *_localField, [&](const Value& value) {
+                foundLocalValue = true;
+                localValues.insert(value);
+            });
+        if (!foundLocalValue) {
+            // Missing values are treated as null.
+            localValues.insert(Value(BSONNULL));
+        }
+    }
+
+    _resolvedPipeline[*_fieldMatchPipelineIdx] =
+        makeMatchStageFromLocalValues({localValues.begin(), localValues.end()},
+                                      _foreignField->fullPath(),
+                                      _additionalFilter.value_or(BSONObj()));
+    auto pipeline = buildPipeline(_batchedInputs.front());
+
+    // The matches are distributed back to the input documents by probing a table of them, which
+    // may hold as much as a single $lookup result. If a batch matches more than that, its input
+    // documents are looked up one at a time instead.
+    _batchTable.emplace(_fromExpCtx, *_foreignField);
+    const auto maxMemoryUsageBytes = internalLookupStageIntermediateDocumentMaxSizeBytes.load();
+    while (auto next = pipeline->getNext()) {
+        if (!_batchTable->add(std::move(*next), maxMemoryUsageBytes)) {
+            _batchTable.reset();
+            break;
+        }
+    }
+
+    recordPlanSummaryStats(*pipeline);
+    pipeline->dispose(pExpCtx->opCtx);
+
+    ++_stats.batches;
+    _stats.probes += localValues.size();
+}
+
+std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipelineForInput(
+    const Document& inputDoc) {
+    if (_batchTable) {
+        return _batchTable->probe(inputDoc, *_localField, _fromExpCtx);
+    }
+    if (useHashJoin()) {
+        return _hashJoinTable->probe(inputDoc, *_localField, _fromExpCtx);
+    }
+
+    if (hasLocalFieldForeignFieldJoin()) {
+        // If there is a pipeline, '_additionalFilter' was added to the end of '_resolvedPipeline'
+        // in doOptimizeAt(). If there is no pipeline, we must add it to the $match stage created
+        // here.
+        BSONObj filter = hasPipeline() ? BSONObj() : _additionalFilter.value_or(BSONObj());
+        auto matchStage =
+            makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), filter);
+        // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
+        _resolvedPipeline[*_fieldMatchPipelineIdx] = matchStage;
+    }
+    return buildPipeline(inputDoc);
+}
+
 DocumentSource::GetModPathsReturn DocumentSourceLookUp::getModifiedPaths() const {
     std::set<std::string> modifiedPaths{_as.fullPath()};
     if (_unwindSrc) {
@@ -630,27 +867,42 @@ void DocumentSourceLookUp::doDispose() {
         _pipeline->dispose(pExpCtx->opCtx);
         _pipeline.reset();
     }
+    _hashJoinTable.reset();
+    _batchTable.reset();
+    _batchedInputs.clear();
 }
 
 BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
                                                       const FieldPath& localFieldPath,
                                                       const std::string& foreignFieldName,
                                                       const BSONObj& additionalFilter) {
-    // Add the 'localFieldPath' of 'input' into 'localFieldList'. If 'localFieldPath' references a
+    // Add the 'localFieldPath' of 'input' into 'localValues'. If 'localFieldPath' references a
     // field with an array in its path, we may need to join on multiple values, so we add each
-    // element to 'localFieldList'.
+    // element to 'localValues'.
+    std::vector<Value> localValues;
+    document_path_support::visitAllValuesAtPath(
+        input, localFieldPath, [&](const Value& nextValue) { localValues.push_back(nextValue); });
+
+    if (localValues.empty()) {
+        // Missing values are treated as null.
+        localValues.push_back(Value(BSONNULL));
+    }
+
+    return makeMatchStageFromLocalValues(localValues, foreignFieldName, additionalFilter);
+}
+
+BSONObj DocumentSourceLookUp::makeMatchStageFromLocalValues(const std::vector<Value>& localValues,
+                                                            const std::string& foreignFieldName,
+                                                            const BSONObj& additionalFilter) {
+    invariant(!localValues.empty());
+
     BSONArrayBuilder arrBuilder;
     bool containsRegex = false;
-    document_path_support::visitAllValuesAtPath(input, localFieldPath, [&](const Value& nextValue) {
-        arrBuilder << nextValue;
-        if (!containsRegex && nextValue.getType() == BSONType::RegEx) {
+    for (auto&& value : localValues) {
+        arrBuilder << value;
+        if (!containsRegex && value.getType() == BSONType::RegEx) {
             containsRegex = true;
         }
-    });
-
-    if (arrBuilder.arrSize() == 0) {
-        // Missing values are treated as null.
-        arrBuilder << BSONNULL;
     }
 
     const auto localFieldListSize = arrBuilder.arrSize();
@@ -723,30 +975,25 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     // Note we may return early from this loop if our source stage is exhausted or if the unwind
     // source was asked to return empty arrays and we get a document without a match.
     while (!_pipeline || !_nextValue) {
-        auto nextInput = pSource->getNext();
+        auto nextInput = getNextInput();
         if (!nextInput.isAdvanced()) {
             return nextInput;
         }
 
         _input = nextInput.releaseDocument();
 
-        if (hasLocalFieldForeignFieldJoin()) {
-            // At this point, if there is a pipeline, '_additionalFilter' was added to the end of
-            // '_resolvedPipeline' in doOptimizeAt(). If there is no pipeline, we must add it to the
-            // $match stage created here.
-            BSONObj filter = hasPipeline() ? BSONObj() : _additionalFilter.value_or(BSONObj());
-            auto matchStage =
-                makeMatchStageFromInput(*_input, *_localField, _foreignField->fullPath(), filter);
-            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-            _resolvedPipeline[*_fieldMatchPipelineIdx] = matchStage;
-        }
-
         if (_pipeline) {
             recordPlanSummaryStats(*_pipeline);
             _pipeline->dispose(pExpCtx->opCtx);
+            _pipeline.reset();
         }
 
-        _pipeline = buildPipeline(*_input);
+        try {
+            _pipeline = buildPipelineForInput(*_input);
+        } catch (const ExceptionForCat<ErrorCategory::StaleShardVersionError>& ex) {
+            assertForeignCollectionNotSharded(ex);
+            throw;
+        }
 
         // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
         // potentially be used by multiple OperationContexts, and the $lookup stage is part of an
@@ -820,6 +1067,13 @@ void DocumentSourceLookUp::appendSpecificExecStats(MutableDocument& doc) const {
                    std::back_inserter(indexesUsedVec),
                    [](std::string idx) -> Value { return Value(idx); });
     doc["indexesUsed"] = Value{std::move(indexesUsedVec)};
+    if (_stats.usedHashJoin) {
+        doc["usedHashJoin"] = Value(true);
+    }
+    if (_stats.batches > 0) {
+        doc["batches"] = Value(_stats.batches);
+        doc["probes"] = Value(_stats.probes);
+    }
 }
 
 void DocumentSourceLookUp::serializeToArrayWithBothSyntaxes(
@@ -30,8 +30,10 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <deque>
 
 #include "mongo/db/exec/document_value/value_comparator.h"
+#include "mongo/db/matcher/path.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_sequential_document_cache.h"
@@ -162,6 +164,14 @@ public:
                                            const std::string& foreignFieldName,
                                            const BSONObj& additionalFilter);
 
+    /**
+     * Builds a $match stage querying the foreign collection for documents whose foreignField is
+     * equal to any of 'localValues'.
+     */
+    static BSONObj makeMatchStageFromLocalValues(const std::vector<Value>& localValues,
+                                                 const std::string& foreignFieldName,
+                                                 const BSONObj& additionalFilter);
+
     /**
      * Helper to absorb an $unwind stage. Only used for testing this special behavior.
      */
@@ -288,6 +298,81 @@ private:
      */
     std::unique_ptr<Pipeline, PipelineDeleter> buildPipeline(const Document& inputDoc);
 
+    /**
+     * Foreign documents indexed by every value of the foreignField that an equality match would
+     * compare against, so that a localField/foreignField join can be answered by probing rather
+     * than by querying the foreign collection.
+     */
+    class ForeignDocumentTable {
+    public:
+        ForeignDocumentTable(const boost::intrusive_ptr<ExpressionContext>& fromExpCtx,
+                             const FieldPath& foreignField);
+
+        /**
+         * Adds 'doc' to the table. Returns false if the table now holds more than
+         * 'maxMemoryUsageBytes'.
+         */
+        bool add(Document doc, long long maxMemoryUsageBytes);
+
+        /**
+         * Builds a pipeline which returns the documents joining with the values at 'localField' in
+         * 'input', in the order in which they were added.
+         */
+        std::unique_ptr<Pipeline, PipelineDeleter> probe(
+            const Document& input,
+            const FieldPath& localField,
+            const boost::intrusive_ptr<ExpressionContext>& fromExpCtx) const;
+
+    private:
+        ElementPath _foreignPath;
+        // Decides which documents join with a null or missing local value.
+        std::unique_ptr<MatchExpression> _nullMatcher;
+
+        std::vector<Document> _docs;
+        // Maps each foreignField value to the positions in '_docs' of the documents carrying it.
+        ValueUnorderedMap<std::vector<size_t>> _docsByValue;
+        std::vector<size_t> _nullMatches;
+        long long _memoryUsageBytes = 0;
+    };
+
+    /**
+     * Returns true if this is a localField/foreignField join without a sub-pipeline, which can be
+     * answered by looking up local values in a table of foreign documents.
+     */
+    bool isEqualityJoin() const;
+
+    /**
+     * Returns true if the equality join should be answered from an in-memory hash table of the
+     * whole foreign collection. The table is built the first time this is decided, which happens
+     * once a query on the foreign collection has needed a collection scan.
+     */
+    bool useHashJoin();
+
+    /**
+     * Reads the foreign collection once into '_hashJoinTable'. Abandons the hash join if the table
+     * grows beyond 'internalDocumentSourceLookupHashJoinMaxMemoryBytes'.
+     */
+    void buildHashJoinTable();
+
+    /**
+     * Returns the next input document. For an equality join this reads ahead a batch of
+     * 'internalDocumentSourceLookupBatchSize' documents and queries the foreign collection for all
+     * of them at once.
+     */
+    GetNextResult getNextInput();
+
+    /**
+     * Queries the foreign collection for every local value in '_batchedInputs' and collects the
+     * matches into '_batchTable'.
+     */
+    void buildBatchTable();
+
+    /**
+     * Returns a pipeline producing the foreign documents which join with 'inputDoc', probing the
+     * batch or hash join table if there is one and querying the foreign collection otherwise.
+     */
+    std::unique_ptr<Pipeline, PipelineDeleter> buildPipelineForInput(const Document& inputDoc);
+
     /**
      * Reinitialize the cache with a new max size. May only be called if this DSLookup was created
      * with pipeline syntax only, the cache has not been frozen or abandoned, and no data has been
@@ -323,6 +408,19 @@ private:
     // Indicates the index in '_resolvedPipeline' where the local/foreignField $match resides.
     boost::optional<size_t> _fieldMatchPipelineIdx;
 
+    // Whether the equality join is answered from '_hashJoinTable', which holds the whole foreign
+    // collection.
+    enum class HashJoinState { kUndecided, kBuilt, kAbandoned };
+    HashJoinState _hashJoinState = HashJoinState::kUndecided;
+    boost::optional<ForeignDocumentTable> _hashJoinTable;
+
+    // Input documents read ahead for a batched equality join, and the foreign documents matching
+    // any of them. If our source returned a pause or EOF while the batch was being read, it is held
+    // in '_batchedInputEnd' until the batch has been returned.
+    std::deque<Document> _batchedInputs;
+    boost::optional<GetNextResult> _batchedInputEnd;
+    boost::optional<ForeignDocumentTable> _batchTable;
+
     // Holds 'let' defined variables defined both in this stage and in parent pipelines. These are
     // copied to the '_fromExpCtx' ExpressionContext's 'variables' and 'variablesParseState' for use
     // in foreign pipeline execution.
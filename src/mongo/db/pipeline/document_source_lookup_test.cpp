@@ -50,6 +50,8 @@
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_options.h"
+#include "mongo/idl/server_parameter_test_util.h"
+#include "mongo/s/stale_exception.h"
 
 namespace mongo {
 namespace {
@@ -946,6 +948,171 @@ TEST_F(DocumentSourceLookUpTest, ShouldPropagatePausesWhileUnwinding) {
     lookup->dispose();
 }
 
+/**
+ * Runs an equality $lookup of 'localDocs' against 'foreignDocs' and returns the joined documents,
+ * along with the stage's execution stats in 'stats'.
+ */
+std::vector<Document> runEqualityLookup(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                        std::deque<DocumentSource::GetNextResult> localDocs,
+                                        std::deque<DocumentSource::GetNextResult> foreignDocs,
+                                        DocumentSourceLookupStats* stats) {
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+    expCtx->mongoProcessInterface = std::make_shared<MockMongoInterface>(std::move(foreignDocs));
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "a"_sd},
+                                         {"foreignField", "x"_sd},
+                                         {"as", "joined"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+    auto mockLocalSource = DocumentSourceMock::createForTest(std::move(localDocs), expCtx);
+    lookup->setSource(mockLocalSource.get());
+
+    std::vector<Document> results;
+    for (auto next = lookup->getNext(); !next.isEOF(); next = lookup->getNext()) {
+        if (next.isAdvanced()) {
+            results.push_back(next.releaseDocument());
+        }
+    }
+    *stats = *static_cast<const DocumentSourceLookupStats*>(lookup->getSpecificStats());
+    lookup->dispose();
+    return results;
+}
+
+TEST_F(DocumentSourceLookUpTest, HashJoinShouldMatchPerDocumentEqualitySemantics) {
+    RAIIServerParameterControllerForTest forceHashJoin("internalQueryForceLookupHashJoin", true);
+
+    std::deque<DocumentSource::GetNextResult> foreignDocs{Document{{"_id", 0}, {"x", 1}},
+                                                          Document{{"_id", 1}, {"x", {1, 2}}},
+                                                          Document{{"_id", 2}, {"x", BSONNULL}},
+                                                          Document{{"_id", 3}},
+                                                          Document{{"_id", 4}, {"x", "a"_sd}}};
+    std::deque<DocumentSource::GetNextResult> localDocs{Document{{"a", 1.0}},
+                                                        Document{{"a", {2, 1}}},
+                                                        Document{},
+                                                        Document{{"a", "a"_sd}},
+                                                        Document{{"a", 3}}};
+
+    DocumentSourceLookupStats stats;
+    auto results = runEqualityLookup(getExpCtx(), localDocs, foreignDocs, &stats);
+    ASSERT_TRUE(stats.usedHashJoin);
+    ASSERT_EQ(results.size(), 5U);
+
+    // Numeric values join across types, and an array on either side joins on its elements. A
+    // foreign document matching several local values is returned once.
+    ASSERT_VALUE_EQ(results[0]["joined"], Value({Value(foreignDocs[0].getDocument()),
+                                                 Value(foreignDocs[1].getDocument())}));
+    ASSERT_VALUE_EQ(results[1]["joined"], Value({Value(foreignDocs[0].getDocument()),
+                                                 Value(foreignDocs[1].getDocument())}));
+
+    // A missing local value joins with null and missing foreign values.
+    ASSERT_VALUE_EQ(results[2]["joined"], Value({Value(foreignDocs[2].getDocument()),
+                                                 Value(foreignDocs[3].getDocument())}));
+    ASSERT_VALUE_EQ(results[3]["joined"], Value({Value(foreignDocs[4].getDocument())}));
+    ASSERT_VALUE_EQ(results[4]["joined"], Value(std::vector<Value>{}));
+}
+
+TEST_F(DocumentSourceLookUpTest, HashJoinShouldFallBackToPerDocumentQueriesWhenTableIsTooLarge) {
+    RAIIServerParameterControllerForTest forceHashJoin("internalQueryForceLookupHashJoin", true);
+    RAIIServerParameterControllerForTest maxMemory(
+        "internalDocumentSourceLookupHashJoinMaxMemoryBytes", 1);
+
+    std::deque<DocumentSource::GetNextResult> foreignDocs{Document{{"_id", 0}, {"x", 1}},
+                                                          Document{{"_id", 1}, {"x", 2}}};
+    std::deque<DocumentSource::GetNextResult> localDocs{Document{{"a", 2}}, Document{{"a", 1}}};
+
+    DocumentSourceLookupStats stats;
+    auto results = runEqualityLookup(getExpCtx(), localDocs, foreignDocs, &stats);
+    ASSERT_FALSE(stats.usedHashJoin);
+    ASSERT_EQ(results.size(), 2U);
+    ASSERT_VALUE_EQ(results[0]["joined"], Value({Value(foreignDocs[1].getDocument())}));
+    ASSERT_VALUE_EQ(results[1]["joined"], Value({Value(foreignDocs[0].getDocument())}));
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldQueryForeignCollectionOncePerBatchOfInputDocuments) {
+    RAIIServerParameterControllerForTest batchSize("internalDocumentSourceLookupBatchSize", 2);
+
+    std::deque<DocumentSource::GetNextResult> foreignDocs{Document{{"_id", 0}, {"x", 1}},
+                                                          Document{{"_id", 1}, {"x", {1, 2}}},
+                                                          Document{{"_id", 2}, {"x", 3}}};
+    std::deque<DocumentSource::GetNextResult> localDocs{
+        Document{{"a", 2}},
+        Document{{"a", 1}},
+        DocumentSource::GetNextResult::makePauseExecution(),
+        Document{{"a", {3, 4}}}};
+
+    DocumentSourceLookupStats stats;
+    auto results = runEqualityLookup(getExpCtx(), localDocs, foreignDocs, &stats);
+    ASSERT_FALSE(stats.usedHashJoin);
+
+    // The pause ends the first batch early. The matches of each batch are distributed back to the
+    // input documents which they join with.
+    ASSERT_EQ(stats.batches, 2);
+    ASSERT_EQ(stats.probes, 4);
+    ASSERT_EQ(results.size(), 3U);
+    ASSERT_VALUE_EQ(results[0]["joined"], Value({Value(foreignDocs[1].getDocument())}));
+    ASSERT_VALUE_EQ(results[1]["joined"], Value({Value(foreignDocs[0].getDocument()),
+                                                 Value(foreignDocs[1].getDocument())}));
+    ASSERT_VALUE_EQ(results[2]["joined"], Value({Value(foreignDocs[2].getDocument())}));
+}
+
+/**
+ * A mock MongoProcessInterface whose foreign collection has become sharded since the query was
+ * routed, so every read of it fails with a stale shard version.
+ */
+class ShardedForeignCollectionMongoInterface final : public StubMongoProcessInterface {
+public:
+    std::unique_ptr<Pipeline, PipelineDeleter> attachCursorSourceToPipeline(
+        Pipeline* ownedPipeline, bool allowTargetingShards = true) final {
+        std::unique_ptr<Pipeline, PipelineDeleter> pipeline(
+            ownedPipeline, PipelineDeleter(ownedPipeline->getContext()->opCtx));
+        uasserted(StaleConfigInfo(pipeline->getContext()->ns,
+                                  ChunkVersion::UNSHARDED(),
+                                  ChunkVersion(1, 0, OID::gen(), boost::none /* timestamp */),
+                                  ShardId("0")),
+                  "foreign collection is sharded");
+    }
+};
+
+TEST_F(DocumentSourceLookUpTest, BatchedAndHashJoinReadsShouldRejectShardedForeignCollection) {
+    RAIIServerParameterControllerForTest batchSize("internalDocumentSourceLookupBatchSize", 2);
+    for (bool forceHashJoin : {false, true}) {
+        RAIIServerParameterControllerForTest forceHashJoinController(
+            "internalQueryForceLookupHashJoin", forceHashJoin);
+        for (bool unwind : {false, true}) {
+            auto expCtx = getExpCtx();
+            NamespaceString fromNs("test", "foreign");
+            expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+                {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+            expCtx->mongoProcessInterface =
+                std::make_shared<ShardedForeignCollectionMongoInterface>();
+
+            auto lookupSpec = Document{{"$lookup",
+                                        Document{{"from", fromNs.coll()},
+                                                 {"localField", "a"_sd},
+                                                 {"foreignField", "x"_sd},
+                                                 {"as", "joined"_sd}}}}
+                                  .toBson();
+            auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+            auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+            if (unwind) {
+                lookup->setUnwindStage(
+                    DocumentSourceUnwind::create(expCtx, "joined", false, boost::none));
+            }
+            auto mockLocalSource = DocumentSourceMock::createForTest(
+                {Document{{"a", 1}}, Document{{"a", 2}}}, expCtx);
+            lookup->setSource(mockLocalSource.get());
+
+            ASSERT_THROWS_CODE(lookup->getNext(), AssertionException, 51069);
+            lookup->dispose();
+        }
+    }
+}
+
 TEST_F(DocumentSourceLookUpTest, LookupReportsAsFieldIsModified) {
     auto expCtx = getExpCtx();
     NamespaceString fromNs("test", "foreign");
@@ -37,6 +37,7 @@
 #include "mongo/db/exec/document_value/document_comparator.h"
 #include "mongo/db/exec/document_value/value.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
@@ -158,6 +159,14 @@ Pipeline::SourceContainer::iterator DocumentSourceSort::doOptimizeAt(
         return nextStage;
     }
 
+    // A $group which only takes the first or last document of each group can find those documents
+    // by their sort keys as it goes, rather than having all of its input sorted first.
+    auto nextGroup = dynamic_cast<DocumentSourceGroup*>((*nextStage).get());
+    if (!limit && nextGroup && nextGroup->absorbPrecedingSort(getSortKeyPattern())) {
+        container->erase(itr);
+        return nextStage;
+    }
+
     if (limit && nextSort) {
         // If there's a limit between two adjacent sorts with the same key pattern it's safe to
         // merge the two sorts and take the minimum of the limits.
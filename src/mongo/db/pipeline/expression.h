@@ -35,7 +35,6 @@
 #include <boost/intrusive_ptr.hpp>
 #include <functional>
 #include <map>
-#include <pcre.h>
 #include <string>
 #include <utility>
 #include <vector>
@@ -51,6 +50,7 @@
 #include "mongo/db/pipeline/variables.h"
 #include "mongo/db/query/datetime/date_time_support.h"
 #include "mongo/db/query/query_feature_flags_gen.h"
+#include "mongo/db/query/regex_cache.h"
 #include "mongo/db/query/sort_pattern.h"
 #include "mongo/db/server_options.h"
 #include "mongo/util/intrusive_counter.h"
@@ -3116,11 +3116,11 @@ public:
         int numCaptures = 0;
 
         /**
-         * If 'regex' is constant, 'pcrePtr' will be shared between the active RegexExecutionState
-         * and '_initialExecStateForConstantRegex'. If not, then the active RegexExecutionState is
-         * the sole owner.
+         * The compiled pattern. For a constant pattern it is obtained from the process-wide
+         * RegexCache and shared with any other expression or query using the same pattern and
+         * options.
          */
-        std::shared_ptr<pcre> pcrePtr;
+        std::shared_ptr<const CompiledRegex> compiledRegex;
 
         /**
          * The input text and starting position for the current execution context.
@@ -3225,6 +3225,18 @@ private:
      */
     boost::optional<RegexExecutionState> _initialExecStateForConstantRegex;
 
+    /**
+     * The program compiled for the most recent pattern and options of a non-constant regex, so
+     * that consecutive documents with the same pattern do not compile it again. Such patterns are
+     * kept out of the process-wide RegexCache, where they would evict the constant ones. Mark as
+     * mutable since it needs to be updated by calls to evaluate().
+     */
+    mutable struct LastCompiledRegex {
+        std::string pattern;
+        int pcreOptions = 0;
+        std::shared_ptr<const CompiledRegex> compiledRegex;
+    } _lastCompiledRegex;
+
     /**
      * Name of the regex expression.
      */
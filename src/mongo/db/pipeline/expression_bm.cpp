@@ -35,6 +35,7 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/query/query_test_service_context.h"
+#include "mongo/db/query/sbe_expression_compiler.h"
 
 namespace mongo {
 namespace {
@@ -320,5 +321,96 @@ BENCHMARK(BM_DateTruncEvaluateMonth6UTCValue2030);
 BENCHMARK(BM_DateTruncEvaluateYear1NewYorkValue2020);
 BENCHMARK(BM_DateTruncEvaluateYear1UTCValue2020);
 BENCHMARK(BM_DateTruncEvaluateYear1NewYorkValue2100);
+
+/**
+ * Tests performance of evaluating an expression against a BSON-backed document, either by walking
+ * the Expression tree or by running the bytecode it compiles to.
+ */
+void testCompiledExpression(BSONObj expressionSpec,
+                            BSONObj input,
+                            bool compiled,
+                            benchmark::State& state) {
+    QueryTestServiceContext testServiceContext;
+    auto opContext = testServiceContext.makeOperationContext();
+    NamespaceString nss("test.bm");
+    boost::intrusive_ptr<ExpressionContextForTest> exprContext =
+        new ExpressionContextForTest(opContext.get(), nss);
+
+    auto expression = Expression::parseExpression(
+                          exprContext.get(), expressionSpec, exprContext->variablesParseState)
+                          ->optimize();
+    auto compiledExpression = stage_builder::compileExpression(expression);
+    invariant(compiledExpression);
+
+    auto variables = &(exprContext->variables);
+    Document document{input};
+
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(compiled ? compiledExpression->evaluate(document, variables)
+                                          : expression->evaluate(document, variables));
+        benchmark::ClobberMemory();
+    }
+}
+
+const BSONObj kCompiledExpressionInput = BSON("a" << 7 << "b" << 3.5 << "c"
+                                                  << BSON("d" << BSON("e" << 42)) << "s"
+                                                  << "abc");
+
+void BM_AddClassic(benchmark::State& state) {
+    testCompiledExpression(
+        BSON("$add" << BSON_ARRAY("$a"
+                                  << "$b")),
+        kCompiledExpressionInput,
+        false,
+        state);
+}
+
+void BM_AddCompiled(benchmark::State& state) {
+    testCompiledExpression(
+        BSON("$add" << BSON_ARRAY("$a"
+                                  << "$b")),
+        kCompiledExpressionInput,
+        true,
+        state);
+}
+
+BSONObj rangePredicateSpec() {
+    return BSON("$and" << BSON_ARRAY(BSON("$gt" << BSON_ARRAY("$a" << 5))
+                                     << BSON("$lt" << BSON_ARRAY("$b" << 10))
+                                     << BSON("$eq" << BSON_ARRAY("$s"
+                                                                 << "abc"))));
+}
+
+void BM_RangePredicateClassic(benchmark::State& state) {
+    testCompiledExpression(rangePredicateSpec(), kCompiledExpressionInput, false, state);
+}
+
+void BM_RangePredicateCompiled(benchmark::State& state) {
+    testCompiledExpression(rangePredicateSpec(), kCompiledExpressionInput, true, state);
+}
+
+BSONObj nestedArithmeticSpec() {
+    return BSON("$cond" << BSON_ARRAY(
+                    BSON("$gte" << BSON_ARRAY("$c.d.e" << 40))
+                    << BSON("$multiply" << BSON_ARRAY(
+                                "$c.d.e" << BSON("$subtract" << BSON_ARRAY("$a" << 1))))
+                    << BSON("$add" << BSON_ARRAY("$c.d.e"
+                                                 << "$a"))));
+}
+
+void BM_NestedArithmeticClassic(benchmark::State& state) {
+    testCompiledExpression(nestedArithmeticSpec(), kCompiledExpressionInput, false, state);
+}
+
+void BM_NestedArithmeticCompiled(benchmark::State& state) {
+    testCompiledExpression(nestedArithmeticSpec(), kCompiledExpressionInput, true, state);
+}
+
+BENCHMARK(BM_AddClassic);
+BENCHMARK(BM_AddCompiled);
+BENCHMARK(BM_RangePredicateClassic);
+BENCHMARK(BM_RangePredicateCompiled);
+BENCHMARK(BM_NestedArithmeticClassic);
+BENCHMARK(BM_NestedArithmeticCompiled);
 }  // namespace
 }  // namespace mongo
@@ -2846,6 +2846,28 @@ TEST(ExpressionRegexTest, InvalidUTF8InRegex) {
         ExpressionRegexTest::testAllExpressions(input, false, {}), AssertionException, 51111);
 }
 
+TEST(ExpressionRegexTest, OnlyConstantPatternsAreSharedThroughTheRegexCache) {
+    RegexCache::get().clear();
+    auto expCtx = ExpressionContextForTest{};
+
+    auto constantExpr = ExpressionRegexTest::generateOptimizedExpression<ExpressionRegexMatch>(
+        fromjson("{$regexMatch: {input: '$input', regex: '^a'}}"), &expCtx);
+    ASSERT_EQ(1U, RegexCache::get().size());
+
+    auto variableExpr = ExpressionRegexTest::generateOptimizedExpression<ExpressionRegexMatch>(
+        fromjson("{$regexMatch: {input: '$input', regex: '$regex'}}"), &expCtx);
+    for (auto&& [input, regex, matches] : std::vector<std::tuple<std::string, std::string, bool>>{
+             {"abc", "^a", true}, {"abc", "^b", false}, {"bcd", "^b", true}, {"abc", "^a", true}}) {
+        ASSERT_VALUE_EQ(
+            variableExpr->evaluate(Document{{"input", input}, {"regex", regex}}, &expCtx.variables),
+            Value(matches));
+    }
+    ASSERT_EQ(1U, RegexCache::get().size());
+
+    ASSERT_VALUE_EQ(constantExpr->evaluate(Document{{"input", "abc"_sd}}, &expCtx.variables),
+                    Value(true));
+}
+
 }  // namespace ExpressionRegexTest
 
 class All : public OldStyleSuiteSpecification {
@@ -748,6 +748,12 @@ PipelineD::buildInnerQueryExecutorGeneric(const CollectionPtr& collection,
                                                 Pipeline::kAllowedMatcherFeatures,
                                                 &shouldProduceEmptyDocs));
 
+    // If the $sort was pushed down and the $group which followed it was not, the $group can stream
+    // its results over the sorted output of the query.
+    if (sortStage && groupStage && pipeline->peekFront() == groupStage.get()) {
+        groupStage->setInputSortPattern(sortStage->getSortKeyPattern());
+    }
+
     const auto cursorType = shouldProduceEmptyDocs
         ? DocumentSourceCursor::CursorType::kEmptyDocuments
         : DocumentSourceCursor::CursorType::kRegular;
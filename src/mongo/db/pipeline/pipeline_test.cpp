@@ -1583,6 +1583,46 @@ TEST(PipelineOptimizationTest, GraphLookupShouldSwapWithMatch) {
     assertPipelineOptimizesAndSerializesTo(inputPipe, outputPipe, serializedPipe);
 }
 
+TEST(PipelineOptimizationTest, SortGraphLookupLimBecomesTopKSortGraphLookup) {
+    string inputPipe =
+        "[{$sort: {a: 1}},"
+        " {$graphLookup: {from: 'lookupColl', as: 'out', connectToField: 'b', "
+        "                 connectFromField: 'c', startWith: '$d'}},"
+        " {$limit: 5}]";
+    string outputPipe =
+        "[{$sort: {sortKey: {a: 1}, limit: 5}},"
+        " {$graphLookup: {from: 'lookupColl', as: 'out', connectToField: 'b', "
+        "                 connectFromField: 'c', startWith: '$d'}}]";
+    string serializedPipe =
+        "[{$sort: {a: 1}},"
+        " {$limit: 5},"
+        " {$graphLookup: {from: 'lookupColl', as: 'out', connectToField: 'b', "
+        "                 connectFromField: 'c', startWith: '$d'}}]";
+    assertPipelineOptimizesAndSerializesTo(inputPipe, outputPipe, serializedPipe);
+}
+
+TEST(PipelineOptimizationTest, LimDoesNotCoalesceWithSortInSortGraphLookupUnwindLim) {
+    string pipeline =
+        "[{$sort: {a: 1}},"
+        " {$graphLookup: {from: 'lookupColl', as: 'out', connectToField: 'b', "
+        "                 connectFromField: 'c', startWith: '$d'}},"
+        " {$unwind: '$out'},"
+        " {$limit: 5}]";
+    string outputPipe =
+        "[{$sort: {sortKey: {a: 1}}},"
+        " {$graphLookup: {from: 'lookupColl', as: 'out', connectToField: 'b', "
+        "                 connectFromField: 'c', startWith: '$d', "
+        "                 unwinding: {preserveNullAndEmptyArrays: false}}},"
+        " {$limit: 5}]";
+    string serializedPipe =
+        "[{$sort: {a: 1}},"
+        " {$graphLookup: {from: 'lookupColl', as: 'out', connectToField: 'b', "
+        "                 connectFromField: 'c', startWith: '$d'}},"
+        " {$unwind: {path: '$out'}},"
+        " {$limit: 5}]";
+    assertPipelineOptimizesAndSerializesTo(pipeline, outputPipe, serializedPipe);
+}
+
 TEST(PipelineOptimizationTest, ExclusionProjectShouldSwapWithIndependentMatch) {
     string inputPipe = "[{$project: {redacted: 0}}, {$match: {unrelated: 4}}]";
     string outputPipe =
@@ -2556,6 +2596,61 @@ TEST(PipelineOptimizationTest, LimDoesNotCoalesceWithSortInSortProjGroupLim) {
     assertPipelineOptimizesAndSerializesTo(inputPipe, outputPipe, serializedPipe);
 }
 
+TEST(PipelineOptimizationTest, SortGroupFirstLastIsAbsorbedIntoGroup) {
+    std::string inputPipe =
+        "[{$sort: {b: 1, c: -1}}"
+        ",{$group: {_id: '$a', f: {$first: '$x'}, l: {$last: '$x'}}}"
+        "]";
+
+    std::string outputPipe =
+        "[{$group: {_id: '$a', f: {$first: '$x'}, l: {$last: '$x'}},"
+        "  sortWithinGroups: {b: 1, c: -1}}"
+        "]";
+
+    assertPipelineOptimizesAndSerializesTo(inputPipe, outputPipe, inputPipe);
+}
+
+TEST(PipelineOptimizationTest, SortGroupFirstIsNotAbsorbedWhenSortedOnGroupKey) {
+    std::string inputPipe =
+        "[{$sort: {a: 1, b: 1}}"
+        ",{$group: {_id: '$a', f: {$first: '$x'}}}"
+        "]";
+
+    std::string outputPipe =
+        "[{$sort: {sortKey: {a: 1, b: 1}}}"
+        ",{$group: {_id: '$a', f: {$first: '$x'}}}"
+        "]";
+
+    assertPipelineOptimizesAndSerializesTo(inputPipe, outputPipe, inputPipe);
+}
+
+TEST(PipelineOptimizationTest, SortGroupIsNotAbsorbedWithOtherAccumulatorsOrALimit) {
+    std::string inputPipe =
+        "[{$sort: {b: 1}}"
+        ",{$group: {_id: '$a', f: {$first: '$x'}, s: {$sum: '$x'}}}"
+        "]";
+
+    std::string outputPipe =
+        "[{$sort: {sortKey: {b: 1}}}"
+        ",{$group: {_id: '$a', f: {$first: '$x'}, s: {$sum: '$x'}}}"
+        "]";
+
+    assertPipelineOptimizesAndSerializesTo(inputPipe, outputPipe, inputPipe);
+
+    inputPipe =
+        "[{$sort: {b: 1}}"
+        ",{$limit: 10}"
+        ",{$group: {_id: '$a', f: {$first: '$x'}}}"
+        "]";
+
+    outputPipe =
+        "[{$sort: {sortKey: {b: 1}, limit: 10}}"
+        ",{$group: {_id: '$a', f: {$first: '$x'}}}"
+        "]";
+
+    assertPipelineOptimizesAndSerializesTo(inputPipe, outputPipe, inputPipe);
+}
+
 TEST(PipelineOptimizationTest, SortProjSkipLimBecomesTopKSortSkipProj) {
     std::string inputPipe =
         "[{$sort: {a: 1}}"
@@ -2801,6 +2896,10 @@ public:
         mergePipe = Pipeline::parse(request.getPipeline(), ctx);
         mergePipe->optimizePipeline();
 
+        // As on mongos, ask whether the pipeline must run there before splitting it. This must not
+        // change the pipeline.
+        mergePipe->requiredToRunOnMongos();
+
         auto splitPipeline = sharded_agg_helpers::splitPipeline(std::move(mergePipe));
 
         ASSERT_VALUE_EQ(Value(splitPipeline.shardsPipeline->writeExplainOps(
@@ -3254,6 +3353,23 @@ class ShardedMatchSortProjLimBecomesMatchTopKSortProj : public Base {
     }
 };
 
+class ShardedSortGroupFirstSplitsAsSortAndGroup : public Base {
+    string inputPipeJson() {
+        return "[{$sort: {ts: -1}}"
+               ",{$group: {_id: '$k', v: {$first: '$x'}}}"
+               "]";
+    }
+    string shardPipeJson() {
+        return "[{$sort: {sortKey: {ts: -1}}}"
+               ",{$project: {k: true, x: true, _id: false}}"
+               "]";
+    }
+    string mergePipeJson() {
+        return "[{$group: {_id: '$k', v: {$first: '$x'}}}"
+               "]";
+    }
+};
+
 }  // namespace limitFieldsSentFromShardsToMerger
 
 namespace coalesceLookUpAndUnwind {
@@ -4555,6 +4671,8 @@ public:
                 ShardedSortGroupProjLimDoesNotBecomeTopKSortProjGroup>();
         add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::
                 ShardedMatchSortProjLimBecomesMatchTopKSortProj>();
+        add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::
+                ShardedSortGroupFirstSplitsAsSortAndGroup>();
         add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::ShardAlreadyExhaustive>();
         add<Optimizations::Sharded::lookupFromShardsInParallel::LookupWithDBAndColl>();
         add<Optimizations::Sharded::lookupFromShardsInParallel::LookupWithLetWithDBAndColl>();
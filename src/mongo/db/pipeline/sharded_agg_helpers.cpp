@@ -795,6 +795,71 @@ boost::optional<ShardedExchangePolicy> checkIfEligibleForExchange(OperationConte
     return walkPipelineBackwardsTrackingShardKey(opCtx, mergePipeline, cm);
 }
 
+boost::optional<ShardedExchangePolicy> checkIfEligibleForGroupExchange(
+    const Pipeline* mergePipeline, const std::set<ShardId>& shardIds) {
+    if (!internalQueryEnableGroupMergeExchange.load() || internalQueryDisableExchange.load()) {
+        return boost::none;
+    }
+
+    // With a single targeted shard there is nobody to share the merge with.
+    if (shardIds.size() < 2 || mergePipeline->getSources().empty()) {
+        return boost::none;
+    }
+
+    auto groupStage =
+        dynamic_cast<DocumentSourceGroup*>(mergePipeline->getSources().front().get());
+    if (!groupStage || !groupStage->doingMerge()) {
+        return boost::none;
+    }
+
+    // Partitioning hashes the binary representation of the group key, so two keys which compare
+    // equal only under a non-simple collation could be sent to different consumers.
+    if (mergePipeline->getContext()->getCollator()) {
+        return boost::none;
+    }
+
+    // The consumers run the merging $group followed by every stage which can be applied to each
+    // partition independently. Anything else still needs a single stream and stays with the
+    // regular merger, which now only has to union the already-merged groups.
+    const auto& sources = mergePipeline->getSources();
+    size_t numConsumerStages = 1;
+    for (auto it = std::next(sources.begin()); it != sources.end(); ++it) {
+        const auto constraints = (*it)->constraints(Pipeline::SplitState::kSplitForMerge);
+        if ((*it)->distributedPlanLogic() ||
+            constraints.hostRequirement != StageConstraints::HostTypeRequirement::kNone) {
+            break;
+        }
+        ++numConsumerStages;
+    }
+
+    // Split the hashed key space into equally sized ranges, one per targeted shard.
+    const size_t numConsumers = shardIds.size();
+    const uint64_t step = std::numeric_limits<uint64_t>::max() / numConsumers;
+    std::vector<BSONObj> boundaries;
+    std::vector<int> consumerIds;
+    boundaries.emplace_back(BSON("_id" << MINKEY));
+    for (size_t i = 1; i < numConsumers; ++i) {
+        const auto split = static_cast<uint64_t>(std::numeric_limits<long long>::min()) + i * step;
+        boundaries.emplace_back(BSON("_id" << static_cast<long long>(split)));
+    }
+    boundaries.emplace_back(BSON("_id" << MAXKEY));
+    for (size_t i = 0; i < numConsumers; ++i) {
+        consumerIds.emplace_back(i);
+    }
+
+    ExchangeSpec exchangeSpec;
+    exchangeSpec.setPolicy(ExchangePolicyEnum::kKeyRange);
+    exchangeSpec.setKey(BSON("_id"
+                             << "hashed"));
+    exchangeSpec.setBoundaries(std::move(boundaries));
+    exchangeSpec.setConsumers(numConsumers);
+    exchangeSpec.setConsumerIds(std::move(consumerIds));
+
+    return ShardedExchangePolicy{std::move(exchangeSpec),
+                                 std::vector<ShardId>(shardIds.begin(), shardIds.end()),
+                                 numConsumerStages};
+}
+
 SplitPipeline splitPipeline(std::unique_ptr<Pipeline, PipelineDeleter> pipeline) {
     auto& expCtx = pipeline->getContext();
     // Re-brand 'pipeline' as the merging pipeline. We will move stages one by one from the merging
@@ -958,6 +1023,10 @@ DispatchShardPipelineResults dispatchShardPipeline(
         splitPipelines = splitPipeline(std::move(pipeline));
 
         exchangeSpec = checkIfEligibleForExchange(opCtx, splitPipelines->mergePipeline.get());
+        if (!exchangeSpec) {
+            exchangeSpec =
+                checkIfEligibleForGroupExchange(splitPipelines->mergePipeline.get(), shardIds);
+        }
     }
 
     // Generate the command object for the targeted shards.
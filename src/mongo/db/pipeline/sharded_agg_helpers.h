@@ -67,6 +67,11 @@ struct ShardedExchangePolicy {
 
     // Shards that will run the consumer part of the exchange.
     std::vector<ShardId> consumerShards;
+
+    // If set, the consumers run only this many leading stages of the merge pipeline and the rest is
+    // run by the regular merger over the union of their outputs. Otherwise the consumers run the
+    // entire merge pipeline.
+    boost::optional<size_t> numConsumerStages;
 };
 
 struct DispatchShardPipelineResults {
@@ -105,6 +110,15 @@ struct DispatchShardPipelineResults {
 boost::optional<ShardedExchangePolicy> checkIfEligibleForExchange(OperationContext* opCtx,
                                                                   const Pipeline* mergePipeline);
 
+/**
+ * If the merging pipeline begins with the merging half of a $group, returns an exchange policy
+ * which hash-partitions the partial groups by their _id across 'shardIds', so that each of those
+ * shards merges a disjoint subset of the groups. Returns boost::none if the optimization is
+ * disabled or not applicable.
+ */
+boost::optional<ShardedExchangePolicy> checkIfEligibleForGroupExchange(
+    const Pipeline* mergePipeline, const std::set<ShardId>& shardIds);
+
 /**
  * Split the current Pipeline into a Pipeline for each shard, and a Pipeline that combines the
  * results within a merging process. This call also performs optimizations with the aim of reducing
@@ -76,6 +76,23 @@ DocumentSource::GetNextResult TeeBuffer::getNext(size_t consumerId) {
     return _buffer[bufferIndex];
 }
 
+std::vector<BSONObj> TeeBuffer::getNextBatchAsBson() {
+    loadNextBatch();
+
+    std::vector<BSONObj> batch;
+    batch.reserve(_buffer.size());
+    for (auto&& input : _buffer) {
+        batch.push_back(input.getDocument().toBsonWithMetaData());
+    }
+
+    // Nothing is left for the consumers to read through getNext().
+    _buffer.clear();
+    for (auto&& consumer : _consumers) {
+        consumer.nLeftToReturn = 0;
+    }
+    return batch;
+}
+
 void TeeBuffer::loadNextBatch() {
     _buffer.clear();
     size_t bytesInBuffer = 0;
@@ -83,6 +83,14 @@ public:
      */
     DocumentSource::GetNextResult getNext(size_t consumerId);
 
+    /**
+     * Loads the next batch from the source and returns it as owned BSON, which unlike Document may
+     * be read from several threads at once. Returns an empty batch once the source is exhausted.
+     * This is an alternative to getNext() for consumers running on their own threads, and the two
+     * must not be mixed on the same buffer.
+     */
+    std::vector<BSONObj> getNextBatchAsBson();
+
 private:
     TeeBuffer(size_t nConsumers, size_t bufferSizeBytes);
 
@@ -29,11 +29,20 @@
 
 #pragma once
 
+#include <deque>
+
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/window_function/window_function.h"
 
 namespace mongo {
 
+/**
+ * Computes the min or max of a sliding window. Since values are removed in the order they were
+ * added, a value can be discarded as soon as a later value is at least as extreme: it will leave
+ * the window first, so it can never be the result again. The values kept are therefore monotonic
+ * from oldest to newest, the result is always the oldest of them, and add() and remove() take
+ * amortized constant time.
+ */
 template <AccumulatorMinMax::Sense sense>
 class WindowFunctionMinMax : public WindowFunctionState {
 public:
@@ -43,47 +52,71 @@ public:
         return std::make_unique<WindowFunctionMinMax<sense>>(expCtx);
     }
 
-    explicit WindowFunctionMinMax(ExpressionContext* const expCtx)
-        : WindowFunctionState(expCtx),
-          _values(_expCtx->getValueComparator().makeOrderedValueMultiset()) {
+    explicit WindowFunctionMinMax(ExpressionContext* const expCtx) : WindowFunctionState(expCtx) {
         _memUsageBytes = sizeof(*this);
     }
 
     void add(Value value) final {
+        while (!_values.empty() && supersedes(value, _values.back().value)) {
+            _memUsageBytes -= _values.back().value.getApproximateSize();
+            _values.pop_back();
+        }
         _memUsageBytes += value.getApproximateSize();
-        _values.insert(std::move(value));
+        _values.push_back({std::move(value), _numAdded++});
     }
 
     void remove(Value value) final {
-        // std::multiset::insert is guaranteed to put the element after any equal elements
-        // already in the container. So find() / erase() will remove the oldest equal element,
-        // which is what we want, to satisfy "remove() undoes add() when called in FIFO order".
-        auto iter = _values.find(std::move(value));
-        tassert(5371400, "Can't remove from an empty WindowFunctionMinMax", iter != _values.end());
-        _memUsageBytes -= iter->getApproximateSize();
-        _values.erase(iter);
+        // remove() is called in FIFO order, so the value leaving the window is always the
+        // '_numRemoved'th one added. It is still held only if nothing since has superseded it.
+        tassert(5371400,
+                "Can't remove from an empty WindowFunctionMinMax",
+                _numRemoved < _numAdded);
+        if (_values.front().position == _numRemoved) {
+            _memUsageBytes -= _values.front().value.getApproximateSize();
+            _values.pop_front();
+        }
+        ++_numRemoved;
     }
 
     void reset() final {
         _values.clear();
+        _numAdded = 0;
+        _numRemoved = 0;
         _memUsageBytes = sizeof(*this);
     }
 
     Value getValue() const final {
         if (_values.empty())
             return kDefault;
+        return _values.front().value;
+    }
+
+protected:
+    struct PositionedValue {
+        Value value;
+        // How many values were added to the window before this one.
+        long long position;
+    };
+
+    /**
+     * Returns true if 'newer' makes the earlier-added 'older' irrelevant. Of values which compare
+     * equal, the min reports the oldest and the max the newest, so only the max discards ties.
+     */
+    bool supersedes(const Value& newer, const Value& older) const {
+        const int cmp = _expCtx->getValueComparator().compare(newer, older);
         switch (sense) {
             case AccumulatorMinMax::Sense::kMin:
-                return *_values.begin();
+                return cmp < 0;
             case AccumulatorMinMax::Sense::kMax:
-                return *_values.rbegin();
+                return cmp >= 0;
         }
         MONGO_UNREACHABLE_TASSERT(5371401);
     }
 
-protected:
-    // Holds all the values in the window, in order, with constant-time access to both ends.
-    ValueMultiset _values;
+    // Holds the values which may still become the result, in the order they were added.
+    std::deque<PositionedValue> _values;
+    long long _numAdded = 0;
+    long long _numRemoved = 0;
 };
 using WindowFunctionMin = WindowFunctionMinMax<AccumulatorMinMax::Sense::kMin>;
 using WindowFunctionMax = WindowFunctionMinMax<AccumulatorMinMax::Sense::kMax>;
@@ -151,5 +151,55 @@ TEST_F(WindowFunctionMinMaxTest, TracksMemoryUsageOnAddAndRemove) {
     ASSERT_EQ(min.getApproximateSize(), trackingSize);
 }
 
+TEST_F(WindowFunctionMinMaxTest, DiscardsValuesWhichCanNoLongerBeTheResult) {
+    // A later, larger value means no earlier value can be the max again, so only it is held.
+    auto largeStr = Value{"this is quite a long string"_sd};
+    max.add(largeStr);
+    max.add(largeStr);
+    max.add(Value{"~"_sd});
+    ASSERT_EQ(max.getApproximateSize(),
+              sizeof(WindowFunctionMax) + Value{"~"_sd}.getApproximateSize());
+
+    // Removing values which were already discarded leaves the result unchanged.
+    max.remove(largeStr);
+    max.remove(largeStr);
+    ASSERT_VALUE_EQ(max.getValue(), Value{"~"_sd});
+
+    max.remove(Value{"~"_sd});
+    ASSERT_VALUE_EQ(max.getValue(), Value{BSONNULL});
+    ASSERT_EQ(max.getApproximateSize(), sizeof(WindowFunctionMax));
+}
+
+TEST_F(WindowFunctionMinMaxTest, SlidingWindowMatchesRecomputation) {
+    const int kWindowSize = 5;
+    std::vector<Value> values;
+    for (int i = 0; i < 200; ++i) {
+        values.push_back(Value{(i * 37) % 23 - (i % 7)});
+    }
+
+    auto comparator = expCtx->getValueComparator();
+    for (size_t i = 0; i < values.size(); ++i) {
+        min.add(values[i]);
+        max.add(values[i]);
+        if (i >= kWindowSize) {
+            min.remove(values[i - kWindowSize]);
+            max.remove(values[i - kWindowSize]);
+        }
+
+        auto windowBegin = values.begin() + (i >= kWindowSize ? i - kWindowSize + 1 : 0);
+        auto windowEnd = values.begin() + i + 1;
+        ASSERT_VALUE_EQ(min.getValue(),
+                        *std::min_element(windowBegin, windowEnd, comparator.getLessThan()));
+        ASSERT_VALUE_EQ(max.getValue(),
+                        *std::max_element(windowBegin, windowEnd, comparator.getLessThan()));
+    }
+
+    min.reset();
+    max.reset();
+    ASSERT_VALUE_EQ(min.getValue(), Value{BSONNULL});
+    ASSERT_VALUE_EQ(max.getValue(), Value{BSONNULL});
+    ASSERT_EQ(min.getApproximateSize(), sizeof(WindowFunctionMin));
+}
+
 }  // namespace
 }  // namespace mongo
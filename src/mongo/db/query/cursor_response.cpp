@@ -97,6 +97,7 @@ void CursorResponseBuilder::abandon() {
     _bodyBuilder.reset();
     _replyBuilder->reset();
     _numDocs = 0;
+    _referencedBytes = 0;
     _active = false;
 }
 
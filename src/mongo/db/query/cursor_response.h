@@ -77,13 +77,13 @@ public:
 
     size_t bytesUsed() const {
         invariant(_active);
-        return _batch->len();
+        return _batch->len() + _referencedBytes;
     }
 
     void append(const BSONObj& obj) {
         invariant(_active);
 
-        _batch->append(obj);
+        _referencedBytes += _replyBuilder->appendDocumentToArray(_batch.get_ptr(), obj);
         _numDocs++;
     }
 
@@ -126,6 +126,9 @@ private:
 
     bool _active = true;
     long long _numDocs = 0;
+    // Bytes of documents which the reply sends from their own buffers rather than copying them
+    // into the batch.
+    size_t _referencedBytes = 0;
     BSONObj _postBatchResumeToken;
     bool _partialResultsReturned = false;
     bool _invalidated = false;
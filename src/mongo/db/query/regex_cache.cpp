@@ -0,0 +1,165 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/regex_cache.h"
+
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace {
+
+Counter64 regexCacheHits;
+Counter64 regexCacheMisses;
+Counter64 regexCacheEvictions;
+
+ServerStatusMetricField<Counter64> regexCacheHitsMetric("query.regexCache.hits", &regexCacheHits);
+ServerStatusMetricField<Counter64> regexCacheMissesMetric("query.regexCache.misses",
+                                                          &regexCacheMisses);
+ServerStatusMetricField<Counter64> regexCacheEvictionsMetric("query.regexCache.evictions",
+                                                             &regexCacheEvictions);
+
+// The options are a prefix of digits followed by a delimiter, so no two pairs of pattern and
+// options produce the same key.
+std::string makeCacheKey(const std::string& pattern, int pcreOptions) {
+    return str::stream() << pcreOptions << '/' << pattern;
+}
+
+}  // namespace
+
+StatusWith<std::unique_ptr<CompiledRegex>> CompiledRegex::compile(const std::string& pattern,
+                                                                 int pcreOptions) {
+    const char* compileError;
+    int errorOffset;
+    pcre* code = pcre_compile(pattern.c_str(), pcreOptions, &compileError, &errorOffset, nullptr);
+    if (!code) {
+        return Status(ErrorCodes::BadValue, compileError);
+    }
+
+    // Studying the pattern finds the bytes a match can start with, and JIT-compiles it if the PCRE
+    // library was built with JIT support. Otherwise the JIT option is ignored. A study failure only
+    // means the program is run without the extra data, so it is not an error.
+    const char* studyError;
+    pcre_extra* extra = pcre_study(code, PCRE_STUDY_JIT_COMPILE, &studyError);
+    return std::unique_ptr<CompiledRegex>(new CompiledRegex(code, extra));
+}
+
+CompiledRegex::CompiledRegex(pcre* code, pcre_extra* extra) : _code(code), _extra(extra) {
+    const int fullInfoResult = pcre_fullinfo(_code, _extra, PCRE_INFO_CAPTURECOUNT, &_numCaptures);
+    invariant(fullInfoResult == 0);
+}
+
+CompiledRegex::~CompiledRegex() {
+    if (_extra) {
+        pcre_free_study(_extra);
+    }
+    pcre_free(_code);
+}
+
+int CompiledRegex::exec(StringData input, int startBytePos, int* ovector, int ovectorSize) const {
+    int result = pcre_exec(
+        _code, _extra, input.rawData(), input.size(), startBytePos, 0, ovector, ovectorSize);
+    if (result == PCRE_ERROR_JIT_STACKLIMIT && _extra) {
+        // The JIT-compiled program runs on a small fixed-size stack, which deeply recursive
+        // patterns can exhaust. The interpreter is not subject to that limit.
+        pcre_extra interpreted = *_extra;
+        interpreted.flags &= ~PCRE_EXTRA_EXECUTABLE_JIT;
+        result = pcre_exec(_code,
+                           &interpreted,
+                           input.rawData(),
+                           input.size(),
+                           startBytePos,
+                           0,
+                           ovector,
+                           ovectorSize);
+    }
+    return result;
+}
+
+bool CompiledRegex::partialMatch(StringData input) const {
+    // pcre_exec() needs an output vector of at least three entries to report the extent of a
+    // match, even though only whether there was one is needed here.
+    int ovector[3];
+    return exec(input, 0, ovector, 3) >= 0;
+}
+
+RegexCache& RegexCache::get() {
+    static auto& cache = *new RegexCache();
+    return cache;
+}
+
+StatusWith<std::shared_ptr<const CompiledRegex>> RegexCache::getOrCompile(
+    const std::string& pattern, int pcreOptions) {
+    const size_t maxEntries = internalQueryRegexCacheMaxEntries.load();
+    auto key = makeCacheKey(pattern, pcreOptions);
+    if (maxEntries > 0) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (auto it = _cache.find(key); it != _cache.end()) {
+            regexCacheHits.increment();
+            return it->second;
+        }
+    }
+    regexCacheMisses.increment();
+
+    // Compile without holding the lock, so that a slow compilation does not block lookups of
+    // other patterns. Concurrent misses on the same pattern may each compile it, and the last one
+    // to finish replaces the others in the cache.
+    auto swCompiled = CompiledRegex::compile(pattern, pcreOptions);
+    if (!swCompiled.isOK()) {
+        return swCompiled.getStatus();
+    }
+    std::shared_ptr<const CompiledRegex> compiled = std::move(swCompiled.getValue());
+    if (maxEntries == 0) {
+        return compiled;
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    _cache.add(key, compiled);
+    while (_cache.size() > maxEntries) {
+        _cache.erase(std::prev(_cache.end()));
+        regexCacheEvictions.increment();
+    }
+    return compiled;
+}
+
+size_t RegexCache::size() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _cache.size();
+}
+
+void RegexCache::clear() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    _cache.clear();
+}
+
+}  // namespace mongo
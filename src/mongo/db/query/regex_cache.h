@@ -0,0 +1,119 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <pcre.h>
+#include <string>
+
+#include "mongo/base/status_with.h"
+#include "mongo/base/string_data.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/util/lru_cache.h"
+
+namespace mongo {
+
+/**
+ * A PCRE program compiled and studied for a pattern and set of options. It is immutable after
+ * construction, so a single instance may be used by any number of threads at once.
+ */
+class CompiledRegex {
+public:
+    /**
+     * Compiles 'pattern' with the given PCRE options, requesting JIT compilation when the linked
+     * PCRE library supports it. Returns an error whose reason is PCRE's error message if the
+     * pattern is invalid.
+     */
+    static StatusWith<std::unique_ptr<CompiledRegex>> compile(const std::string& pattern,
+                                                             int pcreOptions);
+
+    CompiledRegex(const CompiledRegex&) = delete;
+    CompiledRegex& operator=(const CompiledRegex&) = delete;
+
+    ~CompiledRegex();
+
+    /**
+     * Runs the program against 'input' starting at 'startBytePos', with the same semantics and
+     * return value as pcre_exec(). Falls back to the interpreter if the JIT-compiled program runs
+     * out of stack.
+     */
+    int exec(StringData input, int startBytePos, int* ovector, int ovectorSize) const;
+
+    /**
+     * Returns whether 'input' contains a match for the pattern, like pcrecpp::RE::PartialMatch().
+     */
+    bool partialMatch(StringData input) const;
+
+    int numCaptures() const {
+        return _numCaptures;
+    }
+
+private:
+    CompiledRegex(pcre* code, pcre_extra* extra);
+
+    pcre* _code;
+    pcre_extra* _extra;
+    int _numCaptures = 0;
+};
+
+/**
+ * A process-wide, bounded LRU cache of compiled regular expressions keyed by pattern and PCRE
+ * options. Queries using the same constant pattern share a single compiled program rather than
+ * each compiling their own. The number of entries is limited by
+ * 'internalQueryRegexCacheMaxEntries', and lookups are reported in serverStatus under
+ * 'metrics.query.regexCache'.
+ */
+class RegexCache {
+public:
+    static RegexCache& get();
+
+    /**
+     * Returns the compiled program for 'pattern' and 'pcreOptions', compiling and caching it if it
+     * is not already cached. Invalid patterns are not cached.
+     */
+    StatusWith<std::shared_ptr<const CompiledRegex>> getOrCompile(const std::string& pattern,
+                                                                  int pcreOptions);
+
+    size_t size() const;
+
+    void clear();
+
+private:
+    using Cache = LRUCache<std::string, std::shared_ptr<const CompiledRegex>>;
+
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("RegexCache::_mutex");
+
+    // The capacity is enforced against 'internalQueryRegexCacheMaxEntries' on each insertion so
+    // that changes to the parameter take effect at runtime.
+    Cache _cache{std::numeric_limits<size_t>::max()};
+};
+
+}  // namespace mongo
@@ -0,0 +1,118 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/regex_cache.h"
+
+#include "mongo/idl/server_parameter_test_util.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+class RegexCacheTest : public unittest::Test {
+protected:
+    void setUp() override {
+        RegexCache::get().clear();
+    }
+
+    void tearDown() override {
+        RegexCache::get().clear();
+    }
+
+    std::shared_ptr<const CompiledRegex> getOrCompile(const std::string& pattern,
+                                                      int options = 0) {
+        return uassertStatusOK(RegexCache::get().getOrCompile(pattern, options));
+    }
+};
+
+TEST_F(RegexCacheTest, SamePatternAndOptionsShareProgram) {
+    auto first = getOrCompile("^a.*b$");
+    auto second = getOrCompile("^a.*b$");
+    ASSERT_EQ(first.get(), second.get());
+    ASSERT_EQ(RegexCache::get().size(), 1U);
+
+    auto caseInsensitive = getOrCompile("^a.*b$", PCRE_CASELESS);
+    ASSERT_NE(first.get(), caseInsensitive.get());
+    ASSERT_EQ(RegexCache::get().size(), 2U);
+
+    ASSERT_FALSE(first->partialMatch("AxB"));
+    ASSERT_TRUE(caseInsensitive->partialMatch("AxB"));
+}
+
+TEST_F(RegexCacheTest, InvalidPatternIsNotCached) {
+    auto swCompiled = RegexCache::get().getOrCompile("(unclosed", 0);
+    ASSERT_NOT_OK(swCompiled.getStatus());
+    ASSERT_STRING_CONTAINS(swCompiled.getStatus().reason(), "missing )");
+    ASSERT_EQ(RegexCache::get().size(), 0U);
+}
+
+TEST_F(RegexCacheTest, EvictsLeastRecentlyUsedEntries) {
+    RAIIServerParameterControllerForTest maxEntries("internalQueryRegexCacheMaxEntries", 2);
+    auto a = getOrCompile("a");
+    getOrCompile("b");
+
+    // Using "a" again makes "b" the least recently used entry.
+    ASSERT_EQ(getOrCompile("a").get(), a.get());
+    getOrCompile("c");
+    ASSERT_EQ(RegexCache::get().size(), 2U);
+    ASSERT_EQ(getOrCompile("a").get(), a.get());
+
+    // The evicted program stays valid for as long as it is referenced.
+    ASSERT_TRUE(a->partialMatch("xax"));
+}
+
+TEST_F(RegexCacheTest, ZeroMaxEntriesDisablesCaching) {
+    RAIIServerParameterControllerForTest maxEntries("internalQueryRegexCacheMaxEntries", 0);
+    auto first = getOrCompile("a+");
+    auto second = getOrCompile("a+");
+    ASSERT_NE(first.get(), second.get());
+    ASSERT_EQ(RegexCache::get().size(), 0U);
+}
+
+TEST_F(RegexCacheTest, ExecReportsMatchAndCaptures) {
+    auto compiled = getOrCompile("(b+)(x)?");
+    ASSERT_EQ(compiled->numCaptures(), 2);
+
+    std::vector<int> ovector(9);
+    ASSERT_EQ(compiled->exec("abbc", 0, ovector.data(), ovector.size()), 2);
+    ASSERT_EQ(ovector[0], 1);
+    ASSERT_EQ(ovector[1], 3);
+    ASSERT_EQ(compiled->exec("abbc", 3, ovector.data(), ovector.size()), PCRE_ERROR_NOMATCH);
+}
+
+TEST_F(RegexCacheTest, PartialMatchSeesPastEmbeddedNull) {
+    auto compiled = getOrCompile("b");
+    ASSERT_TRUE(compiled->partialMatch(StringData("a\0b", 3)));
+    ASSERT_FALSE(compiled->partialMatch(StringData("a\0c", 3)));
+}
+
+}  // namespace
+}  // namespace mongo
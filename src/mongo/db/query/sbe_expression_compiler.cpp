@@ -0,0 +1,414 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/sbe_expression_compiler.h"
+
+#include "mongo/base/init.h"
+#include "mongo/db/exec/sbe/expressions/expression.h"
+#include "mongo/db/exec/sbe/values/bson.h"
+#include "mongo/db/exec/sbe/vm/vm.h"
+#include "mongo/db/query/sbe_stage_builder_expression.h"
+#include "mongo/db/query/sbe_stage_builder_helpers.h"
+
+namespace mongo::stage_builder {
+namespace {
+// The code of the error raised by the bytecode when a document has to be evaluated by the classic
+// Expression instead.
+constexpr ErrorCodes::Error kFallBackToClassic{5933204};
+
+const uint32_t kIntegralTypesMask =
+    getBSONTypeMask(BSONType::NumberInt) | getBSONTypeMask(BSONType::NumberLong);
+const uint32_t kIntOrDoubleTypesMask =
+    getBSONTypeMask(BSONType::NumberInt) | getBSONTypeMask(BSONType::NumberDouble);
+const uint32_t kNonDecimalNumberTypesMask = kIntegralTypesMask | kIntOrDoubleTypesMask;
+
+std::unique_ptr<sbe::EExpression> makeFallBack() {
+    return sbe::makeE<sbe::EFail>(kFallBackToClassic, "expression must be evaluated as classic");
+}
+
+std::unique_ptr<sbe::EExpression> makeTypeMatch(const sbe::EVariable& var, uint32_t typeMask) {
+    return sbe::makeE<sbe::ETypeMatch>(var.clone(), typeMask);
+}
+
+/**
+ * Returns an expression which is true if both operands are numbers that SBE arithmetic and
+ * comparisons treat exactly like the classic engine: either both are integral, or neither is a
+ * long. A long mixed with a double would be converted to a double by SBE, losing precision, and
+ * decimals are converted differently.
+ */
+std::unique_ptr<sbe::EExpression> makeExactNumericPairCheck(const sbe::EVariable& lhs,
+                                                           const sbe::EVariable& rhs) {
+    return makeBinaryOp(sbe::EPrimBinary::logicOr,
+                        makeBinaryOp(sbe::EPrimBinary::logicAnd,
+                                     makeTypeMatch(lhs, kIntegralTypesMask),
+                                     makeTypeMatch(rhs, kIntegralTypesMask)),
+                        makeBinaryOp(sbe::EPrimBinary::logicAnd,
+                                     makeTypeMatch(lhs, kIntOrDoubleTypesMask),
+                                     makeTypeMatch(rhs, kIntOrDoubleTypesMask)));
+}
+
+/**
+ * Translates the supported subset of Expressions into EExpressions which read the document being
+ * evaluated from 'rootSlot'. Every translation method returns nullptr if any part of its input is
+ * not supported.
+ */
+class ExpressionTranslator {
+public:
+    explicit ExpressionTranslator(sbe::value::SlotId rootSlot) : _rootSlot(rootSlot) {}
+
+    std::unique_ptr<sbe::EExpression> translate(const Expression& expr) {
+        if (auto constant = dynamic_cast<const ExpressionConstant*>(&expr)) {
+            return translateConstant(constant->getValue());
+        } else if (auto fieldPath = dynamic_cast<const ExpressionFieldPath*>(&expr)) {
+            return translateFieldPath(*fieldPath);
+        } else if (auto compare = dynamic_cast<const ExpressionCompare*>(&expr)) {
+            return translateCompare(*compare);
+        } else if (dynamic_cast<const ExpressionAnd*>(&expr)) {
+            return translateLogic(expr, sbe::EPrimBinary::logicAnd, true);
+        } else if (dynamic_cast<const ExpressionOr*>(&expr)) {
+            return translateLogic(expr, sbe::EPrimBinary::logicOr, false);
+        } else if (dynamic_cast<const ExpressionNot*>(&expr)) {
+            return translateNot(expr);
+        } else if (dynamic_cast<const ExpressionCond*>(&expr)) {
+            return translateCond(expr);
+        } else if (dynamic_cast<const ExpressionAdd*>(&expr)) {
+            return translateArithmetic(expr, sbe::EPrimBinary::add);
+        } else if (dynamic_cast<const ExpressionSubtract*>(&expr)) {
+            return translateArithmetic(expr, sbe::EPrimBinary::sub);
+        } else if (dynamic_cast<const ExpressionMultiply*>(&expr)) {
+            return translateArithmetic(expr, sbe::EPrimBinary::mul);
+        }
+        return nullptr;
+    }
+
+private:
+    /**
+     * Translates every child of 'expr', or returns an empty vector if any of them is unsupported.
+     */
+    std::vector<std::unique_ptr<sbe::EExpression>> translateChildren(const Expression& expr) {
+        std::vector<std::unique_ptr<sbe::EExpression>> children;
+        for (auto&& child : expr.getChildren()) {
+            auto translated = translate(*child);
+            if (!translated) {
+                return {};
+            }
+            children.push_back(std::move(translated));
+        }
+        return children;
+    }
+
+    std::unique_ptr<sbe::EExpression> translateConstant(const Value& value) {
+        if (value.missing()) {
+            return makeConstant(sbe::value::TypeTags::Nothing, 0);
+        }
+        auto [tag, val] = makeValue(value);
+        return sbe::makeE<sbe::EConstant>(tag, val);
+    }
+
+    std::unique_ptr<sbe::EExpression> translateFieldPath(const ExpressionFieldPath& expr) {
+        const auto& path = expr.getFieldPath();
+        if (expr.getVariableId() != Variables::kRootId || path.getPathLength() < 2) {
+            return nullptr;
+        }
+
+        auto result = makeFunction(
+            "getField", makeVariable(_rootSlot), makeConstant(path.getFieldName(1)));
+        for (size_t i = 2; i < path.getPathLength(); ++i) {
+            // Descend into objects, and treat any other scalar as missing. Traversing an array
+            // builds an array of the nested values, which is left to the classic engine.
+            auto frameId = _frameIdGenerator.generate();
+            sbe::EVariable parent{frameId, 0};
+            auto descend = buildMultiBranchConditional(
+                CaseValuePair{makeFunction("isObject", parent.clone()),
+                              makeFunction("getField",
+                                           parent.clone(),
+                                           makeConstant(path.getFieldName(i)))},
+                CaseValuePair{makeFunction("isArray", parent.clone()), makeFallBack()},
+                makeConstant(sbe::value::TypeTags::Nothing, 0));
+            result = sbe::makeE<sbe::ELocalBind>(
+                frameId, sbe::makeEs(std::move(result)), std::move(descend));
+        }
+        return result;
+    }
+
+    std::unique_ptr<sbe::EExpression> translateCompare(const ExpressionCompare& expr) {
+        if (expr.getExpressionContext()->getCollator()) {
+            return nullptr;
+        }
+        auto children = translateChildren(expr);
+        if (children.empty()) {
+            return nullptr;
+        }
+
+        // Computes the three-way comparison of the operands. Missing sorts before everything else,
+        // and otherwise only pairs of operands which SBE compares exactly like Value::compare() are
+        // handled here.
+        auto frameId = _frameIdGenerator.generate();
+        sbe::EVariable lhs{frameId, 0};
+        sbe::EVariable rhs{frameId, 1};
+        auto makeCmpResult = [](int32_t result) {
+            return makeConstant(sbe::value::TypeTags::NumberInt32, result);
+        };
+        auto comparable = makeBinaryOp(
+            sbe::EPrimBinary::logicOr,
+            makeExactNumericPairCheck(lhs, rhs),
+            makeBinaryOp(sbe::EPrimBinary::logicOr,
+                         makeBinaryOp(sbe::EPrimBinary::logicAnd,
+                                      makeFunction("isString", lhs.clone()),
+                                      makeFunction("isString", rhs.clone())),
+                         makeBinaryOp(sbe::EPrimBinary::logicOr,
+                                      makeBinaryOp(sbe::EPrimBinary::logicAnd,
+                                                   makeTypeMatch(lhs, getBSONTypeMask(Bool)),
+                                                   makeTypeMatch(rhs, getBSONTypeMask(Bool))),
+                                      makeBinaryOp(sbe::EPrimBinary::logicAnd,
+                                                   makeFunction("isDate", lhs.clone()),
+                                                   makeFunction("isDate", rhs.clone())))));
+        auto cmp = sbe::makeE<sbe::ELocalBind>(
+            frameId,
+            std::move(children),
+            buildMultiBranchConditional(
+                CaseValuePair{makeNot(makeFunction("exists", lhs.clone())),
+                              sbe::makeE<sbe::EIf>(makeFunction("exists", rhs.clone()),
+                                                   makeCmpResult(-1),
+                                                   makeCmpResult(0))},
+                CaseValuePair{makeNot(makeFunction("exists", rhs.clone())), makeCmpResult(1)},
+                CaseValuePair{std::move(comparable),
+                              makeBinaryOp(sbe::EPrimBinary::cmp3w, lhs.clone(), rhs.clone())},
+                makeFallBack()));
+
+        static const stdx::unordered_map<ExpressionCompare::CmpOp, sbe::EPrimBinary::Op> kOps = {
+            {ExpressionCompare::EQ, sbe::EPrimBinary::eq},
+            {ExpressionCompare::NE, sbe::EPrimBinary::neq},
+            {ExpressionCompare::GT, sbe::EPrimBinary::greater},
+            {ExpressionCompare::GTE, sbe::EPrimBinary::greaterEq},
+            {ExpressionCompare::LT, sbe::EPrimBinary::less},
+            {ExpressionCompare::LTE, sbe::EPrimBinary::lessEq}};
+        if (expr.getOp() == ExpressionCompare::CMP) {
+            return cmp;
+        }
+        return makeBinaryOp(kOps.at(expr.getOp()), std::move(cmp), makeCmpResult(0));
+    }
+
+    /**
+     * Translates $and or $or, which coerce each operand to a boolean and short-circuit.
+     */
+    std::unique_ptr<sbe::EExpression> translateLogic(const Expression& expr,
+                                                     sbe::EPrimBinary::Op op,
+                                                     bool emptyResult) {
+        std::unique_ptr<sbe::EExpression> result;
+        for (auto&& child : expr.getChildren()) {
+            auto operand = translateCoerceToBool(*child);
+            if (!operand) {
+                return nullptr;
+            }
+            result = result ? makeBinaryOp(op, std::move(result), std::move(operand))
+                            : std::move(operand);
+        }
+        return result ? std::move(result)
+                      : makeConstant(sbe::value::TypeTags::Boolean, emptyResult);
+    }
+
+    std::unique_ptr<sbe::EExpression> translateNot(const Expression& expr) {
+        auto operand = translateCoerceToBool(*expr.getChildren()[0]);
+        return operand ? makeNot(std::move(operand)) : nullptr;
+    }
+
+    std::unique_ptr<sbe::EExpression> translateCond(const Expression& expr) {
+        auto cond = translateCoerceToBool(*expr.getChildren()[0]);
+        auto thenBranch = translate(*expr.getChildren()[1]);
+        auto elseBranch = translate(*expr.getChildren()[2]);
+        if (!cond || !thenBranch || !elseBranch) {
+            return nullptr;
+        }
+        return sbe::makeE<sbe::EIf>(std::move(cond), std::move(thenBranch), std::move(elseBranch));
+    }
+
+    std::unique_ptr<sbe::EExpression> translateCoerceToBool(const Expression& expr) {
+        auto operand = translate(expr);
+        if (!operand) {
+            return nullptr;
+        }
+        auto frameId = _frameIdGenerator.generate();
+        return sbe::makeE<sbe::ELocalBind>(frameId,
+                                           sbe::makeEs(std::move(operand)),
+                                           generateCoerceToBoolExpression({frameId, 0}));
+    }
+
+    /**
+     * Translates two-operand $add, $subtract or $multiply. Nullish operands produce null, and
+     * numbers are computed here when SBE arithmetic produces the same result as the classic engine.
+     */
+    std::unique_ptr<sbe::EExpression> translateArithmetic(const Expression& expr,
+                                                          sbe::EPrimBinary::Op op) {
+        if (expr.getChildren().size() != 2) {
+            return nullptr;
+        }
+        auto children = translateChildren(expr);
+        if (children.empty()) {
+            return nullptr;
+        }
+
+        auto frameId = _frameIdGenerator.generate();
+        sbe::EVariable lhs{frameId, 0};
+        sbe::EVariable rhs{frameId, 1};
+
+        // $subtract returns null if either operand is nullish. $add and $multiply check their
+        // operands in order, so a nullish right operand only produces null after a number.
+        auto nullish = op == sbe::EPrimBinary::sub
+            ? makeBinaryOp(
+                  sbe::EPrimBinary::logicOr, generateNullOrMissing(lhs), generateNullOrMissing(rhs))
+            : makeBinaryOp(sbe::EPrimBinary::logicOr,
+                           generateNullOrMissing(lhs),
+                           makeBinaryOp(sbe::EPrimBinary::logicAnd,
+                                        makeTypeMatch(lhs, kNonDecimalNumberTypesMask),
+                                        generateNullOrMissing(rhs)));
+
+        // SBE widens an overflowing long to a decimal where the classic engine produces a double.
+        // The classic $add also sums two negative zeros to positive zero, and SBE does not.
+        auto resultFrameId = _frameIdGenerator.generate();
+        sbe::EVariable result{resultFrameId, 0};
+        auto needsClassic = makeTypeMatch(result, getBSONTypeMask(BSONType::NumberDecimal));
+        if (op == sbe::EPrimBinary::add) {
+            needsClassic = makeBinaryOp(
+                sbe::EPrimBinary::logicOr,
+                std::move(needsClassic),
+                makeBinaryOp(sbe::EPrimBinary::logicAnd,
+                             makeTypeMatch(result, getBSONTypeMask(BSONType::NumberDouble)),
+                             makeBinaryOp(sbe::EPrimBinary::eq,
+                                          result.clone(),
+                                          makeConstant(sbe::value::TypeTags::NumberDouble, 0.0))));
+        }
+        auto compute = sbe::makeE<sbe::ELocalBind>(
+            resultFrameId,
+            sbe::makeEs(makeBinaryOp(op, lhs.clone(), rhs.clone())),
+            sbe::makeE<sbe::EIf>(std::move(needsClassic), makeFallBack(), result.clone()));
+
+        return sbe::makeE<sbe::ELocalBind>(
+            frameId,
+            std::move(children),
+            buildMultiBranchConditional(
+                CaseValuePair{std::move(nullish), makeConstant(sbe::value::TypeTags::Null, 0)},
+                CaseValuePair{makeExactNumericPairCheck(lhs, rhs), std::move(compute)},
+                makeFallBack()));
+    }
+
+    const sbe::value::SlotId _rootSlot;
+    sbe::value::FrameIdGenerator _frameIdGenerator;
+};
+
+Value toValue(sbe::value::TypeTags tag, sbe::value::Value val) {
+    switch (tag) {
+        case sbe::value::TypeTags::Nothing:
+            return Value();
+        case sbe::value::TypeTags::Null:
+            return Value(BSONNULL);
+        case sbe::value::TypeTags::Boolean:
+            return Value(sbe::value::bitcastTo<bool>(val));
+        case sbe::value::TypeTags::NumberInt32:
+            return Value(sbe::value::bitcastTo<int32_t>(val));
+        case sbe::value::TypeTags::NumberInt64:
+            return Value(static_cast<long long>(sbe::value::bitcastTo<int64_t>(val)));
+        case sbe::value::TypeTags::NumberDouble:
+            return Value(sbe::value::bitcastTo<double>(val));
+        default: {
+            BSONObjBuilder builder;
+            sbe::bson::appendValueToBsonObj(builder, ""_sd, tag, val);
+            return Value(builder.done().firstElement());
+        }
+    }
+}
+
+class SbeCompiledExpression final : public CompiledExpression {
+public:
+    SbeCompiledExpression(boost::intrusive_ptr<Expression> expr,
+                          std::unique_ptr<sbe::EExpression> sbeExpr,
+                          std::unique_ptr<sbe::RuntimeEnvironment> env,
+                          sbe::value::SlotId rootSlot)
+        : _expr(std::move(expr)),
+          _ctx(std::move(env)),
+          _rootAccessor(_ctx.getRuntimeEnvAccessor(rootSlot)),
+          _code(sbeExpr->compile(_ctx)) {}
+
+    Value evaluate(const Document& root, Variables* variables) final {
+        // Documents which were modified by an earlier stage would have to be serialized first,
+        // which costs more than the bytecode saves.
+        auto bson = root.toBsonIfTriviallyConvertible();
+        if (!bson) {
+            return _expr->evaluate(root, variables);
+        }
+
+        _rootAccessor->reset(false,
+                             sbe::value::TypeTags::bsonObject,
+                             sbe::value::bitcastFrom<const char*>(bson->objdata()));
+        try {
+            auto [owned, tag, val] = _vm.run(_code.get());
+            sbe::value::ValueGuard guard{owned ? tag : sbe::value::TypeTags::Nothing, val};
+            return toValue(tag, val);
+        } catch (const DBException& ex) {
+            if (ex.code() != kFallBackToClassic) {
+                throw;
+            }
+            return _expr->evaluate(root, variables);
+        }
+    }
+
+private:
+    boost::intrusive_ptr<Expression> _expr;
+    sbe::CompileCtx _ctx;
+    sbe::RuntimeEnvironment::Accessor* _rootAccessor;
+    std::unique_ptr<sbe::vm::CodeFragment> _code;
+    sbe::vm::ByteCode _vm;
+};
+
+MONGO_INITIALIZER(RegisterSbeExpressionCompiler)(InitializerContext*) {
+    CompiledExpression::registerCompiler(compileExpression);
+}
+}  // namespace
+
+std::unique_ptr<CompiledExpression> compileExpression(boost::intrusive_ptr<Expression> expr) {
+    // A lone constant or field path is already as cheap to evaluate as the bytecode would be.
+    if (dynamic_cast<ExpressionConstant*>(expr.get()) ||
+        dynamic_cast<ExpressionFieldPath*>(expr.get())) {
+        return nullptr;
+    }
+
+    sbe::value::SlotIdGenerator slotIdGenerator;
+    auto env = std::make_unique<sbe::RuntimeEnvironment>();
+    auto rootSlot =
+        env->registerSlot(sbe::value::TypeTags::Nothing, 0, false, &slotIdGenerator);
+    auto sbeExpr = ExpressionTranslator{rootSlot}.translate(*expr);
+    if (!sbeExpr) {
+        return nullptr;
+    }
+    return std::make_unique<SbeCompiledExpression>(
+        std::move(expr), std::move(sbeExpr), std::move(env), rootSlot);
+}
+}  // namespace mongo::stage_builder
@@ -0,0 +1,53 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <memory>
+
+#include "mongo/db/pipeline/compiled_expression.h"
+#include "mongo/db/pipeline/expression.h"
+
+namespace mongo::stage_builder {
+/**
+ * Translates 'expr' into SBE bytecode which the classic engine can run in place of walking the
+ * Expression tree. Returns nullptr unless 'expr' is an operator built only from the following:
+ *   - constants and field paths on $$ROOT/$$CURRENT,
+ *   - $eq, $ne, $gt, $gte, $lt, $lte and $cmp without a collation,
+ *   - $and, $or, $not and $cond,
+ *   - $add, $subtract and $multiply with two operands.
+ *
+ * The bytecode only computes results for the common input types, where it is known to match the
+ * classic engine exactly. For anything else, such as traversing an array in a field path or adding
+ * a date, it bails out and the document is evaluated with 'expr' instead, so the results and errors
+ * are always those of 'expr'.
+ */
+std::unique_ptr<CompiledExpression> compileExpression(boost::intrusive_ptr<Expression> expr);
+}  // namespace mongo::stage_builder
@@ -0,0 +1,155 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/json.h"
+#include "mongo/db/exec/document_value/document_value_test_util.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/db/query/sbe_expression_compiler.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo::stage_builder {
+namespace {
+
+class SbeExpressionCompilerTest : public unittest::Test {
+protected:
+    boost::intrusive_ptr<Expression> parse(const char* json) {
+        auto spec = fromjson(json);
+        return Expression::parseOperand(
+                   _expCtx.get(), spec.firstElement(), _expCtx->variablesParseState)
+            ->optimize();
+    }
+
+    /**
+     * Compiles the expression {expr: <json>} and asserts that it produces the same result as the
+     * classic engine for each of the 'inputs'.
+     */
+    void assertMatchesClassic(const char* json, const std::vector<BSONObj>& inputs) {
+        auto expr = parse(json);
+        auto compiled = compileExpression(expr);
+        ASSERT(compiled) << json;
+
+        for (auto&& input : inputs) {
+            Document doc{input};
+            auto expected = expr->evaluate(doc, &_expCtx->variables);
+            auto actual = compiled->evaluate(doc, &_expCtx->variables);
+            ASSERT_VALUE_EQ(actual, expected);
+            ASSERT_EQ(actual.getType(), expected.getType()) << json << " on " << input;
+        }
+    }
+
+    boost::intrusive_ptr<ExpressionContextForTest> _expCtx = new ExpressionContextForTest();
+};
+
+const std::vector<BSONObj> kInputs = {
+    fromjson("{a: 1, b: 2}"),
+    fromjson("{a: 1, b: 2.5}"),
+    fromjson("{a: -3.5, b: 2}"),
+    fromjson("{a: {$numberLong: '9223372036854775807'}, b: 1}"),
+    fromjson("{a: {$numberLong: '5'}, b: 2.5}"),
+    fromjson("{a: 2147483647, b: 2147483647}"),
+    fromjson("{a: -0.0, b: -0.0}"),
+    fromjson("{a: NaN, b: 1}"),
+    fromjson("{a: {$numberDecimal: '1.5'}, b: 1}"),
+    fromjson("{a: null, b: 1}"),
+    fromjson("{a: 1, b: null}"),
+    fromjson("{a: 1}"),
+    fromjson("{b: 1}"),
+    fromjson("{}"),
+    fromjson("{a: 'abc', b: 'abd'}"),
+    fromjson("{a: 'abc', b: 1}"),
+    fromjson("{a: true, b: false}"),
+    fromjson("{a: [1, 2], b: 1}"),
+    fromjson("{a: {c: 1}, b: {c: 1}}"),
+    fromjson("{a: {$date: 1000}, b: {$date: 2000}}"),
+    fromjson("{a: {$date: 1000}, b: 5}"),
+};
+
+TEST_F(SbeExpressionCompilerTest, ComparisonsMatchClassic) {
+    for (auto op : {"$eq", "$ne", "$gt", "$gte", "$lt", "$lte", "$cmp"}) {
+        auto json = std::string{"{expr: {"} + op + ": ['$a', '$b']}}";
+        assertMatchesClassic(json.c_str(), kInputs);
+    }
+    assertMatchesClassic("{expr: {$gt: ['$a', 1]}}", kInputs);
+    assertMatchesClassic("{expr: {$eq: ['$a', null]}}", kInputs);
+}
+
+TEST_F(SbeExpressionCompilerTest, ArithmeticMatchesClassic) {
+    for (auto op : {"$add", "$subtract", "$multiply"}) {
+        auto json = std::string{"{expr: {"} + op + ": ['$a', '$b']}}";
+        assertMatchesClassic(json.c_str(), kInputs);
+    }
+    assertMatchesClassic("{expr: {$add: ['$a', 1]}}", kInputs);
+    assertMatchesClassic("{expr: {$multiply: [2, {$subtract: ['$b', '$a']}]}}", kInputs);
+}
+
+TEST_F(SbeExpressionCompilerTest, LogicalExpressionsMatchClassic) {
+    assertMatchesClassic("{expr: {$and: ['$a', '$b']}}", kInputs);
+    assertMatchesClassic("{expr: {$or: ['$a', '$b']}}", kInputs);
+    assertMatchesClassic("{expr: {$not: ['$a']}}", kInputs);
+    assertMatchesClassic("{expr: {$and: [{$gt: ['$a', 0]}, {$lt: ['$b', 2]}]}}", kInputs);
+    assertMatchesClassic("{expr: {$cond: [{$gte: ['$a', 1]}, '$a', '$b']}}", kInputs);
+}
+
+TEST_F(SbeExpressionCompilerTest, DottedFieldPathsMatchClassic) {
+    std::vector<BSONObj> inputs = {fromjson("{a: {b: {c: 1}}}"),
+                                   fromjson("{a: {b: 1}}"),
+                                   fromjson("{a: 1}"),
+                                   fromjson("{a: [{b: {c: 1}}, {b: {c: 2}}]}"),
+                                   fromjson("{a: {b: [{c: 1}, {c: 2}]}}"),
+                                   fromjson("{}")};
+    assertMatchesClassic("{expr: {$add: ['$a.b.c', 1]}}", inputs);
+    assertMatchesClassic("{expr: {$eq: ['$a.b', '$$CURRENT.a.b']}}", inputs);
+}
+
+TEST_F(SbeExpressionCompilerTest, ErrorsMatchClassic) {
+    auto expr = parse("{expr: {$add: ['$a', '$b']}}");
+    auto compiled = compileExpression(expr);
+    ASSERT(compiled);
+
+    Document doc{fromjson("{a: 'abc', b: 1}")};
+    ASSERT_THROWS_CODE(compiled->evaluate(doc, &_expCtx->variables), AssertionException, 16554);
+}
+
+TEST_F(SbeExpressionCompilerTest, DoesNotCompileUnsupportedExpressions) {
+    ASSERT_FALSE(compileExpression(parse("{expr: '$a'}")));
+    ASSERT_FALSE(compileExpression(parse("{expr: {$const: 1}}")));
+    ASSERT_FALSE(compileExpression(parse("{expr: {$add: ['$a', '$b', '$c']}}")));
+    ASSERT_FALSE(compileExpression(parse("{expr: {$concat: ['$a', '$b']}}")));
+    ASSERT_FALSE(compileExpression(parse("{expr: {$eq: ['$$NOW', '$a']}}")));
+    ASSERT_FALSE(compileExpression(parse("{expr: {$and: ['$a', {$size: '$b'}]}}")));
+
+    _expCtx->setCollator(
+        std::make_unique<CollatorInterfaceMock>(CollatorInterfaceMock::MockType::kAlwaysEqual));
+    ASSERT_FALSE(compileExpression(parse("{expr: {$eq: ['$a', '$b']}}")));
+}
+}  // namespace
+}  // namespace mongo::stage_builder
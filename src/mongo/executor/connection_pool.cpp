@@ -130,13 +130,18 @@ void ConnectionPool::ControllerInterface::init(ConnectionPool* pool) {
     _pool = pool;
 }
 
+Date_t ConnectionPool::ControllerInterface::now() const {
+    return _pool->_factory->now();
+}
+
 std::string ConnectionPool::ConnectionControls::toString() const {
     return "{{ maxPending: {}, target: {}, }}"_format(maxPendingConnections, targetConnections);
 }
 
 std::string ConnectionPool::HostState::toString() const {
-    return "{{ requests: {}, ready: {}, pending: {}, active: {}, isExpired: {} }}"_format(
-        requests, ready, pending, active, health.isExpired);
+    return "{{ requests: {}, ready: {}, pending: {}, active: {}, queueTime: {}, "
+           "isExpired: {} }}"_format(
+               requests, ready, pending, active, queueTime.toString(), health.isExpired);
 }
 
 /**
@@ -215,6 +220,38 @@ auto ConnectionPool::makeLimitController() noexcept -> std::shared_ptr<Controlle
     return std::make_shared<LimitController>();
 }
 
+void ConnectionPool::AdaptiveTarget::seed(size_t target) {
+    _target = std::max(_target, target);
+}
+
+size_t ConnectionPool::AdaptiveTarget::update(const HostState& stats,
+                                              Date_t now,
+                                              const Parameters& params,
+                                              size_t minConns,
+                                              size_t maxConns) {
+    // The pool keeps at least minConns regardless, so that is where growth starts from
+    _target = std::max(_target, minConns);
+
+    if (now - _lastAdjusted >= params.adjustmentInterval) {
+        const auto demand = stats.requests + stats.active;
+        const auto open = stats.pending + stats.ready + stats.active;
+
+        if (stats.requests && stats.queueTime > params.queueTimeTarget) {
+            // Requests are backing up, so add connections, but no more than there is work for
+            _target = std::max(_target, std::min(_target + params.additiveIncrease, demand));
+            _lastAdjusted = now;
+        } else if (!stats.requests && stats.active < params.lowUtilization * open) {
+            // Connections are sitting idle, so let some of them lapse
+            auto decreased = static_cast<size_t>(_target * params.decreaseFactor);
+            _target = std::max(stats.active, std::min(_target, decreased));
+            _lastAdjusted = now;
+        }
+    }
+
+    _target = std::max(minConns, std::min(_target, maxConns));
+    return _target;
+}
+
 /**
  * A pool for a specific HostAndPort
  *
@@ -354,10 +391,14 @@ private:
     using OwnedConnection = std::shared_ptr<ConnectionInterface>;
     using OwnershipPool = stdx::unordered_map<ConnectionInterface*, OwnedConnection>;
     using LRUOwnershipPool = LRUCache<OwnershipPool::key_type, OwnershipPool::mapped_type>;
-    using Request = std::pair<Date_t, Promise<ConnectionHandle>>;
+    struct Request {
+        Date_t expiration;
+        Date_t enqueued;
+        Promise<ConnectionHandle> promise;
+    };
     struct RequestComparator {
         bool operator()(const Request& a, const Request& b) {
-            return a.first > b.first;
+            return a.expiration > b.expiration;
         }
     };
 
@@ -411,6 +452,9 @@ private:
     std::vector<Request> _requests;
     Date_t _lastActiveTime;
 
+    // The longest a fulfilled request waited for a connection since the last updateController()
+    Milliseconds _maxQueueTime{0};
+
     std::shared_ptr<TimerInterface> _eventTimer;
     Date_t _eventTimerExpiration;
     Date_t _hostExpiration;
@@ -673,7 +717,7 @@ Future<ConnectionPool::ConnectionHandle> ConnectionPool::SpecificPool::getConnec
     const auto expiration = now + timeout;
     auto pf = makePromiseFuture<ConnectionHandle>();
 
-    _requests.push_back(make_pair(expiration, std::move(pf.promise)));
+    _requests.push_back(Request{expiration, now, std::move(pf.promise)});
     std::push_heap(begin(_requests), end(_requests), RequestComparator{});
 
     return std::move(pf.future);
@@ -950,7 +994,7 @@ void ConnectionPool::SpecificPool::processFailure(const Status& status) {
     }
 
     for (auto& request : _requests) {
-        request.second.setError(status);
+        request.promise.setError(status);
     }
 
     LOGV2_DEBUG(22573,
@@ -965,7 +1009,8 @@ void ConnectionPool::SpecificPool::processFailure(const Status& status) {
 void ConnectionPool::SpecificPool::fulfillRequests() {
     while (_requests.size()) {
         // Marking this as our newest active time
-        _lastActiveTime = _parent->_factory->now();
+        const auto now = _parent->_factory->now();
+        _lastActiveTime = now;
 
         // Caution: If this returns with a value, it's important that we not throw until we've
         // emplaced the promise (as returning a connection would attempt to take the lock and would
@@ -979,7 +1024,8 @@ void ConnectionPool::SpecificPool::fulfillRequests() {
         }
 
         // Grab the request and callback
-        auto promise = std::move(_requests.front().second);
+        _maxQueueTime = std::max(_maxQueueTime, now - _requests.front().enqueued);
+        auto promise = std::move(_requests.front().promise);
         std::pop_heap(begin(_requests), end(_requests), RequestComparator{});
         _requests.pop_back();
 
@@ -1112,8 +1158,8 @@ void ConnectionPool::SpecificPool::updateEventTimer() {
     }
 
     // If a request would timeout before the next event, then it is the next event
-    if (_requests.size() && (_requests.front().first < nextEventTime)) {
-        nextEventTime = _requests.front().first;
+    if (_requests.size() && (_requests.front().expiration < nextEventTime)) {
+        nextEventTime = _requests.front().expiration;
     }
 
     // If our timer is already set to the next event, then we're done
@@ -1133,11 +1179,11 @@ void ConnectionPool::SpecificPool::updateEventTimer() {
 
         _health.isFailed = false;
 
-        while (_requests.size() && (_requests.front().first <= now)) {
+        while (_requests.size() && (_requests.front().expiration <= now)) {
             std::pop_heap(begin(_requests), end(_requests), RequestComparator{});
 
             auto& request = _requests.back();
-            request.second.setError(Status(ErrorCodes::NetworkInterfaceExceededTimeLimit,
+            request.promise.setError(Status(ErrorCodes::NetworkInterfaceExceededTimeLimit,
                                            "Couldn't get a connection within the time limit"));
             _requests.pop_back();
 
@@ -1155,6 +1201,15 @@ void ConnectionPool::SpecificPool::updateController() {
 
     auto& controller = *_parent->_controller;
 
+    // The requests are a heap ordered by expiration, so find the longest waiting one by scanning
+    auto queueTime = std::exchange(_maxQueueTime, Milliseconds{0});
+    if (!_requests.empty()) {
+        const auto now = _parent->_factory->now();
+        for (const auto& request : _requests) {
+            queueTime = std::max(queueTime, now - request.enqueued);
+        }
+    }
+
     // Update our own state
     HostState state{
         _health,
@@ -1162,6 +1217,7 @@ void ConnectionPool::SpecificPool::updateController() {
         refreshingConnections(),
         availableConnections(),
         inUseConnections(),
+        queueTime,
     };
     LOGV2_DEBUG(22578,
                 kDiagnosticLogLevel,
@@ -1209,11 +1265,16 @@ void ConnectionPool::SpecificPool::updateController() {
     }
 
 
-    // Make sure all related hosts exist
+    // Make sure all related hosts exist, and have them spawn their connections now if asked to
     for (const auto& host : hostGroup.hosts) {
-        if (auto& pool = _parent->_pools[host]; !pool) {
+        auto& pool = _parent->_pools[host];
+        if (!pool) {
             pool = SpecificPool::make(_parent, host, _sslMode);
         }
+
+        if (hostGroup.warmHosts && pool.get() != this) {
+            pool->updateState();
+        }
     }
 
     spawnConnections();
@@ -71,6 +71,7 @@ class ConnectionPool : public EgressTagCloser, public std::enable_shared_from_th
 public:
     class SpecificPool;
 
+    class AdaptiveTarget;
     class ConnectionInterface;
     class DependentTypeFactoryInterface;
     class TimerInterface;
@@ -152,6 +153,15 @@ public:
          */
         bool skipAuthentication = false;
 
+        /**
+         * The number of requests a NetworkInterfaceTL may pipeline over one connection at once.
+         * Above one, its ordinary commands share connections that have room, and new connections
+         * are only checked out when every shared connection to the host is full. Commands which
+         * may wait for other operations or be waited for, such as getMores and the statements of
+         * transactions, still get connections of their own.
+         */
+        size_t maxRequestsPerConnection = 1;
+
 #ifdef MONGO_CONFIG_SSL
         /**
          * Provides SSL params if the egress cluster connection requires custom SSL certificates
@@ -211,6 +221,12 @@ public:
         size_t ready = 0;
         size_t active = 0;
 
+        /**
+         * The longest any request waited for a connection since the previous update, including
+         * the requests that are still waiting.
+         */
+        Milliseconds queueTime{0};
+
         std::string toString() const;
     };
 
@@ -234,6 +250,12 @@ public:
     struct HostGroupState {
         std::vector<HostAndPort> hosts;
         bool canShutdown = false;
+
+        /**
+         * Whether the pools for 'hosts' should spawn connections up to their targets now rather
+         * than on their first request, e.g. because the group's topology changed.
+         */
+        bool warmHosts = false;
     };
 
     explicit ConnectionPool(std::shared_ptr<DependentTypeFactoryInterface> impl,
@@ -495,9 +517,61 @@ public:
     virtual void updateConnectionPoolStats([[maybe_unused]] ConnectionPoolStats* cps) const = 0;
 
 protected:
+    /**
+     * Returns the current time according to the pool's clock
+     */
+    Date_t now() const;
+
     ConnectionPool* _pool = nullptr;
 };
 
+/**
+ * Sizes a single host's pool from how long requests wait for a connection and how many of its
+ * connections are in use, rather than from the instantaneous number of requests.
+ *
+ * At most once per adjustmentInterval, the target grows additively by additiveIncrease while
+ * requests wait longer than queueTimeTarget, and shrinks multiplicatively by decreaseFactor while
+ * no request waits and fewer than lowUtilization of the open connections are in use. Growth never
+ * takes the target past the number of requests and in use connections, so a burst can't open more
+ * connections than it has work for, and shrinking never takes it below the in use connections.
+ *
+ * This should only be used by a ControllerInterface, under its own synchronization.
+ */
+class ConnectionPool::AdaptiveTarget {
+public:
+    struct Parameters {
+        Milliseconds queueTimeTarget{5};
+        Milliseconds adjustmentInterval{50};
+        size_t additiveIncrease = 2;
+        double decreaseFactor = 0.5;
+        double lowUtilization = 0.5;
+    };
+
+    /**
+     * Raises the target to at least 'target', e.g. to give the new primary of a replica set the
+     * pool size its predecessor had grown to.
+     */
+    void seed(size_t target);
+
+    /**
+     * Adjusts the target given the latest state of the pool and returns it, clamped to
+     * [minConns, maxConns].
+     */
+    size_t update(const HostState& stats,
+                  Date_t now,
+                  const Parameters& params,
+                  size_t minConns,
+                  size_t maxConns);
+
+    size_t target() const {
+        return _target;
+    }
+
+private:
+    size_t _target = 0;
+    Date_t _lastAdjusted;
+};
+
 /**
  * Implementation interface for the connection pool
  *
@@ -1530,6 +1530,127 @@ TEST_F(ConnectionPoolTest, ReturnAfterShutdown) {
     pool->shutdown();
 }
 
+/**
+ * A controller that puts every host in one group, targets a single connection per host, and asks
+ * for the group to be warmed on its first update.
+ */
+class WarmingController final : public ConnectionPool::ControllerInterface {
+public:
+    explicit WarmingController(std::vector<HostAndPort> hosts) : _hosts(std::move(hosts)) {}
+
+    void addHost(PoolId id, const HostAndPort& host) override {}
+    HostGroupState updateHost(PoolId id, const HostState& stats) override {
+        return {_hosts, false, std::exchange(_warm, false)};
+    }
+    void removeHost(PoolId id) override {}
+
+    ConnectionControls getControls(PoolId id) override {
+        return {1, 1};
+    }
+
+    Milliseconds hostTimeout() const override {
+        return ConnectionPool::kDefaultHostTimeout;
+    }
+    Milliseconds pendingTimeout() const override {
+        return ConnectionPool::kDefaultRefreshTimeout;
+    }
+    Milliseconds toRefreshTimeout() const override {
+        return ConnectionPool::kDefaultRefreshRequirement;
+    }
+
+    StringData name() const override {
+        return "WarmingController"_sd;
+    }
+
+    void updateConnectionPoolStats(ConnectionPoolStats* cps) const override {}
+
+private:
+    const std::vector<HostAndPort> _hosts;
+    bool _warm = true;
+};
+
+TEST_F(ConnectionPoolTest, WarmHostsSpawnsConnectionsForRelatedHosts) {
+    const HostAndPort requested("requested", 27017);
+    const HostAndPort related("related", 27017);
+
+    ConnectionPool::Options options;
+    options.controllerFactory = [&] {
+        return std::make_shared<WarmingController>(std::vector<HostAndPort>{requested, related});
+    };
+    auto pool = makePool(options);
+
+    ConnectionImpl::pushSetup(Status::OK());
+    ConnectionImpl::pushSetup(Status::OK());
+    auto conn = getFromPool(requested, transport::kGlobalSSLMode, Seconds(1)).get();
+
+    // The related host was never requested, but its pool was created and warmed up to its target
+    ASSERT_EQ(pool->getNumConnectionsPerHost(related), 1u);
+    doneWith(conn);
+}
+
+TEST(ConnectionPoolAdaptiveTarget, GrowsAdditivelyWhileRequestsQueue) {
+    ConnectionPool::AdaptiveTarget target;
+    ConnectionPool::AdaptiveTarget::Parameters params;
+    auto now = Date_t::fromMillisSinceEpoch(1000);
+
+    ConnectionPool::HostState stats;
+    stats.requests = 10;
+    stats.active = 1;
+    stats.queueTime = params.queueTimeTarget + Milliseconds(1);
+    ASSERT_EQ(target.update(stats, now, params, 1, 100), 1u + params.additiveIncrease);
+
+    // Nothing changes until the adjustment interval has passed
+    ASSERT_EQ(target.update(stats, now + Milliseconds(1), params, 1, 100),
+              1u + params.additiveIncrease);
+
+    now += params.adjustmentInterval;
+    ASSERT_EQ(target.update(stats, now, params, 1, 100), 1u + 2 * params.additiveIncrease);
+
+    // Requests that are served quickly enough don't grow the pool
+    now += params.adjustmentInterval;
+    stats.queueTime = params.queueTimeTarget;
+    ASSERT_EQ(target.update(stats, now, params, 1, 100), 1u + 2 * params.additiveIncrease);
+
+    // Growth stops at the demand, and at the maximum
+    now += params.adjustmentInterval;
+    stats.requests = 5;
+    stats.queueTime = params.queueTimeTarget + Milliseconds(1);
+    ASSERT_EQ(target.update(stats, now, params, 1, 100), 6u);
+    now += params.adjustmentInterval;
+    ASSERT_EQ(target.update(stats, now, params, 1, 100), 6u);
+    ASSERT_EQ(target.update(stats, now, params, 1, 4), 4u);
+}
+
+TEST(ConnectionPoolAdaptiveTarget, ShrinksMultiplicativelyWhenIdle) {
+    ConnectionPool::AdaptiveTarget target;
+    ConnectionPool::AdaptiveTarget::Parameters params;
+    auto now = Date_t::fromMillisSinceEpoch(1000);
+    target.seed(40);
+
+    ConnectionPool::HostState stats;
+    stats.ready = 38;
+    stats.active = 2;
+    ASSERT_EQ(target.update(stats, now, params, 1, 100), 20u);
+
+    // A well utilized pool keeps its size
+    now += params.adjustmentInterval;
+    stats.ready = 8;
+    stats.active = 12;
+    ASSERT_EQ(target.update(stats, now, params, 1, 100), 20u);
+
+    // It never shrinks below what is in use, or below the minimum
+    now += params.adjustmentInterval;
+    stats.ready = 30;
+    stats.active = 12;
+    ASSERT_EQ(target.update(stats, now, params, 1, 100), 12u);
+    now += params.adjustmentInterval;
+    stats.ready = 12;
+    stats.active = 0;
+    ASSERT_EQ(target.update(stats, now, params, 3, 100), 6u);
+    now += params.adjustmentInterval;
+    ASSERT_EQ(target.update(stats, now, params, 3, 100), 3u);
+}
+
 }  // namespace connection_pool_test_details
 }  // namespace executor
 }  // namespace mongo
@@ -0,0 +1,145 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/executor/host_latency_tracker.h"
+
+#include "mongo/platform/bits.h"
+
+namespace mongo {
+namespace executor {
+
+namespace {
+const auto getHostLatencyTracker = ServiceContext::declareDecoration<HostLatencyTracker>();
+
+size_t bucketFor(Microseconds latency) {
+    const auto micros =
+        static_cast<uint64_t>(std::max<int64_t>(durationCount<Microseconds>(latency), 1));
+    return std::min<size_t>(63 - countLeadingZeros64(micros), HostLatencyTracker::kNumBuckets - 1);
+}
+}  // namespace
+
+HostLatencyTracker::HostLatencyTracker() : _random(SecureRandom().nextInt64()) {}
+
+HostLatencyTracker* HostLatencyTracker::get(ServiceContext* service) {
+    return &getHostLatencyTracker(service);
+}
+
+HostLatencyTracker* HostLatencyTracker::get(OperationContext* opCtx) {
+    return get(opCtx->getServiceContext());
+}
+
+void HostLatencyTracker::recordLatency(const HostAndPort& host, Microseconds latency) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    auto& stats = _hosts[host];
+    ++stats.buckets[bucketFor(latency)];
+    if (++stats.numSamples < kDecayThreshold) {
+        return;
+    }
+
+    stats.numSamples = 0;
+    for (auto& bucket : stats.buckets) {
+        bucket /= 2;
+        stats.numSamples += bucket;
+    }
+}
+
+void HostLatencyTracker::onRequestStarted(const HostAndPort& host) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    ++_hosts[host].numInFlight;
+}
+
+void HostLatencyTracker::onRequestFinished(const HostAndPort& host) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    auto& stats = _hosts[host];
+    stats.numInFlight = std::max(stats.numInFlight - 1, int64_t{0});
+}
+
+boost::optional<Microseconds> HostLatencyTracker::getLatencyPercentile(const HostAndPort& host,
+                                                                       double percentile) const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    auto it = _hosts.find(host);
+    if (it == _hosts.end()) {
+        return boost::none;
+    }
+    return _percentile(it->second, percentile);
+}
+
+size_t HostLatencyTracker::selectTarget(const std::vector<HostAndPort>& hosts) {
+    invariant(!hosts.empty());
+    if (hosts.size() == 1) {
+        return 0;
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    const auto numHosts = static_cast<int32_t>(hosts.size());
+    const size_t first = _random.nextInt32(numHosts);
+    // Draw the second candidate from the remaining hosts so that the two are always distinct.
+    const size_t second = (first + 1 + _random.nextInt32(numHosts - 1)) % hosts.size();
+    return _expectedCost(lk, hosts[second]) < _expectedCost(lk, hosts[first]) ? second : first;
+}
+
+boost::optional<Microseconds> HostLatencyTracker::_percentile(const HostStats& stats,
+                                                              double percentile) {
+    if (stats.numSamples < kMinSamples) {
+        return boost::none;
+    }
+
+    // Find the bucket containing the requested rank and interpolate linearly within it.
+    const double rank = std::clamp(percentile, 0.0, 100.0) / 100.0 * stats.numSamples;
+    double samplesBelow = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+        const auto count = stats.buckets[i];
+        if (count == 0 || samplesBelow + count < rank) {
+            samplesBelow += count;
+            continue;
+        }
+        const double lower = i == 0 ? 0 : static_cast<double>(1ull << i);
+        const double upper = static_cast<double>(1ull << (i + 1));
+        const double fraction = (rank - samplesBelow) / count;
+        return Microseconds(static_cast<long long>(lower + (upper - lower) * fraction));
+    }
+    return Microseconds(1ll << kNumBuckets);
+}
+
+double HostLatencyTracker::_expectedCost(WithLock, const HostAndPort& host) const {
+    auto it = _hosts.find(host);
+    if (it == _hosts.end()) {
+        return 0;
+    }
+    auto median = _percentile(it->second, 50);
+    if (!median) {
+        return 0;
+    }
+    return durationCount<Microseconds>(*median) * (1.0 + it->second.numInFlight);
+}
+
+}  // namespace executor
+}  // namespace mongo
@@ -0,0 +1,121 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "mongo/db/operation_context.h"
+#include "mongo/db/service_context.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/platform/random.h"
+#include "mongo/stdx/unordered_map.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/duration.h"
+#include "mongo/util/net/hostandport.h"
+
+namespace mongo {
+namespace executor {
+
+/**
+ * Server-wide record of the round-trip latencies and in-flight request counts observed by
+ * NetworkInterfaceTL for each remote host. Used to order the targets of hedge-eligible reads and
+ * to decide how long to wait before hedging them.
+ *
+ * Latencies are kept in a log2-bucketed histogram per host. Once a host accumulates
+ * 'kDecayThreshold' samples every bucket is halved, so that the histogram follows the recent
+ * behaviour of the host rather than its entire history.
+ */
+class HostLatencyTracker {
+    HostLatencyTracker(const HostLatencyTracker&) = delete;
+    HostLatencyTracker& operator=(const HostLatencyTracker&) = delete;
+
+public:
+    // Bucket 'i' holds latencies in [2^i, 2^(i+1)) microseconds, with bucket 0 also holding zero.
+    static constexpr size_t kNumBuckets = 32;
+
+    // Number of samples a host needs before percentiles are reported for it.
+    static constexpr uint64_t kMinSamples = 20;
+
+    // Number of samples at which a host's histogram is aged by halving every bucket.
+    static constexpr uint64_t kDecayThreshold = 1024;
+
+    HostLatencyTracker();
+
+    static HostLatencyTracker* get(ServiceContext* service);
+    static HostLatencyTracker* get(OperationContext* opCtx);
+
+    /**
+     * Records a completed round trip to 'host' which took 'latency'.
+     */
+    void recordLatency(const HostAndPort& host, Microseconds latency);
+
+    /**
+     * Track the number of requests currently outstanding to 'host'.
+     */
+    void onRequestStarted(const HostAndPort& host);
+    void onRequestFinished(const HostAndPort& host);
+
+    /**
+     * Returns the estimated 'percentile' (in [0, 100]) latency of 'host', or boost::none if fewer
+     * than 'kMinSamples' round trips to it have been recorded.
+     */
+    boost::optional<Microseconds> getLatencyPercentile(const HostAndPort& host,
+                                                       double percentile) const;
+
+    /**
+     * Chooses the index of the host in 'hosts' that a request should be sent to first, using the
+     * power of two choices: two distinct candidates are drawn at random and the one with the lower
+     * expected wait (median latency scaled by its outstanding requests) wins. Hosts without enough
+     * samples are treated as free, so that every host keeps being measured. 'hosts' must not be
+     * empty.
+     */
+    size_t selectTarget(const std::vector<HostAndPort>& hosts);
+
+private:
+    struct HostStats {
+        std::array<uint64_t, kNumBuckets> buckets{};
+        uint64_t numSamples = 0;
+        int64_t numInFlight = 0;
+    };
+
+    static boost::optional<Microseconds> _percentile(const HostStats& stats, double percentile);
+
+    double _expectedCost(WithLock, const HostAndPort& host) const;
+
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("HostLatencyTracker::_mutex");
+
+    stdx::unordered_map<HostAndPort, HostStats> _hosts;
+
+    PseudoRandom _random;
+};
+
+}  // namespace executor
+}  // namespace mongo
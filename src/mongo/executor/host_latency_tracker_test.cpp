@@ -0,0 +1,123 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/executor/host_latency_tracker.h"
+
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace executor {
+namespace {
+
+const HostAndPort kFastHost("fast", 27017);
+const HostAndPort kSlowHost("slow", 27017);
+const HostAndPort kNewHost("new", 27017);
+
+void recordSamples(HostLatencyTracker& tracker,
+                   const HostAndPort& host,
+                   Microseconds latency,
+                   uint64_t count) {
+    for (uint64_t i = 0; i < count; ++i) {
+        tracker.recordLatency(host, latency);
+    }
+}
+
+TEST(HostLatencyTrackerTest, NoPercentileUntilEnoughSamples) {
+    HostLatencyTracker tracker;
+    ASSERT_FALSE(tracker.getLatencyPercentile(kFastHost, 95));
+
+    recordSamples(tracker, kFastHost, Microseconds(1000), HostLatencyTracker::kMinSamples - 1);
+    ASSERT_FALSE(tracker.getLatencyPercentile(kFastHost, 95));
+
+    tracker.recordLatency(kFastHost, Microseconds(1000));
+    ASSERT_TRUE(tracker.getLatencyPercentile(kFastHost, 95));
+}
+
+TEST(HostLatencyTrackerTest, PercentilesFollowRecordedLatencies) {
+    HostLatencyTracker tracker;
+    recordSamples(tracker, kFastHost, Microseconds(1000), 90);
+    recordSamples(tracker, kFastHost, Microseconds(100000), 10);
+
+    // Percentiles are estimated within the power-of-two bucket holding the sample.
+    auto p50 = *tracker.getLatencyPercentile(kFastHost, 50);
+    ASSERT_GTE(p50, Microseconds(512));
+    ASSERT_LT(p50, Microseconds(1024));
+
+    auto p95 = *tracker.getLatencyPercentile(kFastHost, 95);
+    ASSERT_GTE(p95, Microseconds(65536));
+    ASSERT_LT(p95, Microseconds(131072));
+}
+
+TEST(HostLatencyTrackerTest, OldSamplesDecay) {
+    HostLatencyTracker tracker;
+    recordSamples(tracker, kFastHost, Microseconds(100), HostLatencyTracker::kDecayThreshold);
+    recordSamples(tracker, kFastHost, Microseconds(10000), 2 * HostLatencyTracker::kDecayThreshold);
+
+    auto p50 = *tracker.getLatencyPercentile(kFastHost, 50);
+    ASSERT_GTE(p50, Microseconds(8192));
+    ASSERT_LT(p50, Microseconds(16384));
+}
+
+TEST(HostLatencyTrackerTest, SelectTargetPrefersLowerLatency) {
+    HostLatencyTracker tracker;
+    recordSamples(tracker, kFastHost, Microseconds(100), HostLatencyTracker::kMinSamples);
+    recordSamples(tracker, kSlowHost, Microseconds(100000), HostLatencyTracker::kMinSamples);
+
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(0U, tracker.selectTarget({kFastHost, kSlowHost}));
+        ASSERT_EQ(1U, tracker.selectTarget({kSlowHost, kFastHost}));
+    }
+}
+
+TEST(HostLatencyTrackerTest, SelectTargetAccountsForRequestsInFlight) {
+    HostLatencyTracker tracker;
+    recordSamples(tracker, kFastHost, Microseconds(1000), HostLatencyTracker::kMinSamples);
+    recordSamples(tracker, kSlowHost, Microseconds(1000), HostLatencyTracker::kMinSamples);
+
+    tracker.onRequestStarted(kFastHost);
+    ASSERT_EQ(1U, tracker.selectTarget({kFastHost, kSlowHost}));
+
+    tracker.onRequestFinished(kFastHost);
+    tracker.onRequestStarted(kSlowHost);
+    ASSERT_EQ(0U, tracker.selectTarget({kFastHost, kSlowHost}));
+}
+
+TEST(HostLatencyTrackerTest, SelectTargetPrefersUnmeasuredHost) {
+    HostLatencyTracker tracker;
+    recordSamples(tracker, kFastHost, Microseconds(100), HostLatencyTracker::kMinSamples);
+
+    ASSERT_EQ(1U, tracker.selectTarget({kFastHost, kNewHost}));
+    ASSERT_EQ(0U, tracker.selectTarget({kNewHost}));
+}
+
+}  // namespace
+}  // namespace executor
+}  // namespace mongo
@@ -37,7 +37,9 @@
 
 #include "mongo/base/status_with.h"
 #include "mongo/client/connection_string.h"
+#include "mongo/db/service_context.h"
 #include "mongo/executor/connection_pool_stats.h"
+#include "mongo/executor/host_latency_tracker.h"
 #include "mongo/executor/network_connection_hook.h"
 #include "mongo/executor/network_interface_integration_fixture.h"
 #include "mongo/executor/test_network_connection_hook.h"
@@ -307,6 +309,37 @@ public:
         NetworkInterfaceTest::tearDown();
         resetIsInternalClient(false);
     }
+
+    /**
+     * Makes 'latency' the median round trip time of 'host' known to the HostLatencyTracker, which
+     * the network interface shares with every other test. Returns the resulting median.
+     */
+    Microseconds seedMedianLatency(const HostAndPort& host, Microseconds latency) {
+        auto tracker = HostLatencyTracker::get(getGlobalServiceContext());
+        for (uint64_t i = 0; i < HostLatencyTracker::kDecayThreshold / 2; ++i) {
+            tracker->recordLatency(host, latency);
+        }
+        return *tracker->getLatencyPercentile(host, 50);
+    }
+
+    /**
+     * Returns a request for 'cmdObj' which is hedged once to the same host, after the median
+     * latency of that host.
+     */
+    RemoteCommandRequestOnAny makeDelayedHedgeRequest(const HostAndPort& host, BSONObj cmdObj) {
+        RemoteCommandRequestBase::HedgeOptions ho;
+        ho.count = 1;
+        ho.maxTimeMSForHedgedReads = 10;
+        ho.delayPercentile = 50;
+
+        return RemoteCommandRequestOnAny({host, host},
+                                         "admin",
+                                         std::move(cmdObj),
+                                         BSONObj(),
+                                         nullptr,
+                                         RemoteCommandRequest::kNoTimeout,
+                                         ho);
+    }
 };
 
 TEST_F(NetworkInterfaceTest, CancelMissingOperation) {
@@ -694,6 +727,50 @@ TEST_F(NetworkInterfaceInternalClientTest, StartCommandOnAny) {
     assertNumOps(0u, 0u, 0u, 1u);
 }
 
+TEST_F(NetworkInterfaceInternalClientTest, DelayedHedgeIsSentAfterTheLatencyPercentile) {
+    FailPointEnableBlock fpb("networkInterfaceShouldNotKillPendingRequests");
+
+    const auto host = fixture().getServers().front();
+    const auto delay = seedMedianLatency(host, Milliseconds(200));
+
+    // The first request outlives the delay, so that the hedge has a reason to be sent.
+    ClockSource::StopWatch stopwatch;
+    auto deferred = runCommandOnAny(makeCallbackHandle(),
+                                    makeDelayedHedgeRequest(host,
+                                                            BSON("sleep" << 1 << "lock"
+                                                                         << "none"
+                                                                         << "millis" << 1000)));
+
+    // Only the first request goes out before the delay has passed.
+    while (net().getCounters().sent < 2) {
+        ASSERT_FALSE(deferred.isReady());
+        sleepmillis(5);
+    }
+    ASSERT_GTE(stopwatch.elapsed(), duration_cast<Milliseconds>(delay));
+
+    auto res = deferred.get();
+    ASSERT_OK(res.status);
+    ASSERT_OK(getStatusFromCommandResult(res.data));
+    ASSERT_EQ(2u, net().getCounters().sent);
+}
+
+TEST_F(NetworkInterfaceInternalClientTest, DelayedHedgeIsCancelledWhenTheFirstResponseWins) {
+    FailPointEnableBlock fpb("networkInterfaceShouldNotKillPendingRequests");
+
+    const auto host = fixture().getServers().front();
+    const auto delay = seedMedianLatency(host, Milliseconds(200));
+
+    auto request = makeDelayedHedgeRequest(host, makeEchoCmdObj());
+    auto res = runCommandOnAny(makeCallbackHandle(), std::move(request)).get();
+    ASSERT_OK(res.status);
+    ASSERT_EQ(1, res.data.getIntField("ok"));
+
+    // The hedge timer would have fired by now, had the response not cancelled it.
+    sleepFor(delay * 2);
+    ASSERT_EQ(1u, net().getCounters().sent);
+    assertNumOps(0u, 0u, 0u, 1u);
+}
+
 TEST_F(NetworkInterfaceTest, SetAlarm) {
     // set a first alarm, to execute after "expiration"
     Date_t expiration = net().now() + Milliseconds(100);
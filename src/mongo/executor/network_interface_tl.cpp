@@ -38,6 +38,7 @@
 #include "mongo/db/wire_version.h"
 #include "mongo/executor/connection_pool_tl.h"
 #include "mongo/executor/hedging_metrics.h"
+#include "mongo/executor/host_latency_tracker.h"
 #include "mongo/logv2/log.h"
 #include "mongo/rpc/get_status_from_command_result.h"
 #include "mongo/transport/transport_layer_manager.h"
@@ -51,6 +52,38 @@ namespace executor {
 
 namespace {
 static inline const std::string kMaxTimeMSOpOnlyField = "maxTimeMSOpOnly";
+
+/**
+ * Returns whether 'cmdObj' may share a connection with other requests. The remote host runs the
+ * requests on a connection one after another, so a command which may wait for other operations,
+ * or which other operations may be waiting for, gets a connection of its own. Queued behind a
+ * request which waits for it, such a command would never run.
+ */
+bool canMultiplexCommand(const BSONObj& cmdObj) {
+    // The statements of transactions and retryable writes, as well as commitTransaction and the
+    // other commands which decide a transaction that other operations may be blocked on.
+    if (cmdObj.hasField("txnNumber")) {
+        return false;
+    }
+
+    // A getMore may wait for new data. The other commands end operations, cursors and sessions.
+    const auto cmdName = cmdObj.firstElementFieldNameStringData();
+    for (auto exclusiveCmdName : {"getMore"_sd,
+                                  "killCursors"_sd,
+                                  "killOp"_sd,
+                                  "_killOperations"_sd,
+                                  "killSessions"_sd,
+                                  "killAllSessions"_sd,
+                                  "killAllSessionsByPattern"_sd,
+                                  "endSessions"_sd,
+                                  "abortTransaction"_sd,
+                                  "commitTransaction"_sd}) {
+        if (cmdName == exclusiveCmdName) {
+            return false;
+        }
+    }
+    return true;
+}
 }  // unnamed namespace
 
 /**
@@ -382,6 +415,13 @@ void NetworkInterfaceTL::RequestState::returnConnection(Status status) noexcept
 
     auto connToReturn = std::exchange(conn, {});
 
+    if (multiplexedMsgId) {
+        // Other requests may still be using the connection, so this request's own status does not
+        // decide whether it is healthy.
+        interface()->_releaseMultiplexedConnection(host, connToReturn);
+        return;
+    }
+
     if (!status.isOK()) {
         connToReturn->indicateFailure(std::move(status));
         return;
@@ -399,6 +439,9 @@ void NetworkInterfaceTL::CommandStateBase::tryFinish(Status status) noexcept {
 
     // The command has resolved one way or another.
     timer->cancel(baton);
+    if (hedgeTimer) {
+        hedgeTimer->cancel(baton);
+    }
 
     if (interface->_counters) {
         // Increment our counters for the integration test
@@ -444,6 +487,12 @@ void NetworkInterfaceTL::CommandStateBase::tryFinish(Status status) noexcept {
 void NetworkInterfaceTL::RequestState::cancel() noexcept {
     auto connToCancel = weakConn.lock();
     if (auto clientPtr = getClient(connToCancel)) {
+        if (multiplexedMsgId) {
+            // Leave the other requests on the shared connection alone.
+            clientPtr->cancelMultiplexedRequest(*multiplexedMsgId);
+            return;
+        }
+
         // If we have a client, cancel it
         clientPtr->cancel(cmdState->baton);
     }
@@ -488,11 +537,26 @@ Status NetworkInterfaceTL::startCommand(const TaskExecutor::CallbackHandle& cbHa
                   });
     }
 
+    // A hedge-eligible read may be targeted and hedged according to the latencies observed for
+    // each host: the preferred host is moved to the front of the targets, and the hedged requests
+    // are held back until the first request has been outstanding for longer than that host's
+    // configured latency percentile. Until the host has enough samples, hedge immediately.
+    boost::optional<Microseconds> hedgeDelay;
+    if (_svcCtx && request.hedgeOptions && request.hedgeOptions->delayPercentile > 0 &&
+        request.target.size() > 1 && !targetHostsInAlphabeticalOrder) {
+        auto tracker = HostLatencyTracker::get(_svcCtx);
+        std::swap(request.target[0], request.target[tracker->selectTarget(request.target)]);
+        hedgeDelay =
+            tracker->getLatencyPercentile(request.target[0], request.hedgeOptions->delayPercentile);
+    }
+
     auto [cmdState, future] = CommandState::make(this, request, cbHandle);
     if (cmdState->requestOnAny.timeout != cmdState->requestOnAny.kNoTimeout) {
         cmdState->deadline = cmdState->stopwatch.start() + cmdState->requestOnAny.timeout;
     }
     cmdState->baton = baton;
+    cmdState->multiplexed =
+        _connPoolOpts.maxRequestsPerConnection > 1 && canMultiplexCommand(request.cmdObj);
 
     if (_svcCtx && cmdState->requestOnAny.hedgeOptions) {
         auto hm = HedgingMetrics::get(_svcCtx);
@@ -531,8 +595,23 @@ Status NetworkInterfaceTL::startCommand(const TaskExecutor::CallbackHandle& cbHa
         return Status::OK();
     }
 
-    // Attempt to get a connection to every target host
-    for (size_t idx = 0; idx < request.target.size(); ++idx) {
+    // Create the hedge timer before any request can be sent, so that it is always visible to
+    // tryFinish().
+    if (hedgeDelay) {
+        cmdState->hedgeTimer = _reactor->makeTimer();
+    }
+
+    // Attempt to get a connection to every target host, or only to the first one if hedging is
+    // delayed.
+    const size_t numImmediateTargets = hedgeDelay ? 1 : request.target.size();
+    for (size_t idx = 0; idx < numImmediateTargets; ++idx) {
+        if (cmdState->multiplexed) {
+            if (auto conn = _leaseMultiplexedConnection(request.target[idx])) {
+                cmdState->requestManager->trySend(std::move(conn), idx);
+                continue;
+            }
+        }
+
         auto connFuture = _pool->get(request.target[idx], request.sslMode, request.timeout);
 
         // If connection future is ready or requests should be sent in order, send the request
@@ -548,6 +627,52 @@ Status NetworkInterfaceTL::startCommand(const TaskExecutor::CallbackHandle& cbHa
         });
     }
 
+    if (hedgeDelay) {
+        LOGV2_DEBUG(5932901,
+                    2,
+                    "Delaying hedged requests",
+                    "requestId"_attr = cmdState->requestOnAny.id,
+                    "target"_attr = request.target[0],
+                    "delay"_attr = *hedgeDelay);
+
+        // Timers have millisecond resolution, so round the delay up rather than letting a
+        // sub-millisecond latency truncate to hedging immediately.
+        const auto delay =
+            duration_cast<Milliseconds>(*hedgeDelay + Milliseconds(1) - Microseconds(1));
+        cmdState->hedgeTimer->waitUntil(now() + delay, baton)
+            .getAsync([cmdState = cmdState, numImmediateTargets](Status status) {
+                if (status.isOK() && cmdState->finishLine.isReady()) {
+                    status =
+                        Status(ErrorCodes::CallbackCanceled, "Command finished before hedging");
+                }
+
+                const auto& request = cmdState->requestOnAny;
+                for (size_t idx = numImmediateTargets; idx < request.target.size(); ++idx) {
+                    if (!status.isOK()) {
+                        // Account for the connections that will no longer be requested, so that
+                        // the command still fails if the first request could not be sent.
+                        cmdState->requestManager->trySend(status, idx);
+                        continue;
+                    }
+
+                    const auto& target = request.target[idx];
+                    auto interface = cmdState->interface;
+                    if (cmdState->multiplexed) {
+                        if (auto conn = interface->_leaseMultiplexedConnection(target)) {
+                            cmdState->requestManager->trySend(std::move(conn), idx);
+                            continue;
+                        }
+                    }
+
+                    interface->_pool->get(target, request.sslMode, request.timeout)
+                        .thenRunOn(interface->_reactor)
+                        .getAsync([cmdState = cmdState, idx](auto swConn) {
+                            cmdState->requestManager->trySend(std::move(swConn), idx);
+                        });
+                }
+            });
+    }
+
     return Status::OK();
 } catch (const DBException& ex) {
     return ex.toStatus();
@@ -569,8 +694,13 @@ Future<RemoteCommandResponse> NetworkInterfaceTL::CommandState::sendRequest(
     std::shared_ptr<RequestState> requestState) {
     return makeReadyFutureWith([this, requestState] {
                setTimer();
-               return RequestState::getClient(requestState->conn)
-                   ->runCommandRequest(*requestState->request, baton);
+               auto client = RequestState::getClient(requestState->conn);
+               if (requestState->multiplexedMsgId) {
+                   return client->runMultiplexedCommandRequest(*requestState->request,
+                                                               *requestState->multiplexedMsgId,
+                                                               interface->_reactor);
+               }
+               return client->runCommandRequest(*requestState->request, baton);
            })
         .then([this, requestState](RemoteCommandResponse response) {
             doMetadataHook(RemoteCommandOnAnyResponse(requestState->host, response));
@@ -664,7 +794,7 @@ void NetworkInterfaceTL::RequestManager::killOperationsForPendingRequests() {
 }
 
 void NetworkInterfaceTL::RequestManager::trySend(
-    StatusWith<ConnectionPool::ConnectionHandle> swConn, size_t idx) noexcept {
+    StatusWith<std::shared_ptr<ConnectionPool::ConnectionInterface>> swConn, size_t idx) noexcept {
     // Our connection wasn't any good
     if (!swConn.isOK()) {
         {
@@ -714,7 +844,12 @@ void NetworkInterfaceTL::RequestManager::trySend(
         if (haveSentAll || isLocked) {
             // Our command has already been satisfied or we have already sent out all
             // the requests.
-            swConn.getValue()->indicateSuccess();
+            if (cmdState->multiplexed) {
+                cmdState->interface->_releaseMultiplexedConnection(
+                    cmdState->requestOnAny.target[idx], swConn.getValue());
+            } else {
+                swConn.getValue()->indicateSuccess();
+            }
             return;
         }
 
@@ -730,6 +865,12 @@ void NetworkInterfaceTL::RequestManager::trySend(
         requestState->request = RemoteCommandRequest(cmdState->requestOnAny, idx);
         requestState->host = requestState->request->target;
 
+        if (cmdState->multiplexed) {
+            requestState->multiplexedMsgId = nextMessageId();
+            cmdState->interface->_shareMultiplexedConnection(requestState->host,
+                                                             requestState->conn);
+        }
+
         requests.at(currentSentIdx) = requestState;
     }
 
@@ -793,6 +934,11 @@ void NetworkInterfaceTL::RequestManager::trySend(
         counters->recordSent();
     }
 
+    if (cmdState->interface->_svcCtx && request->hedgeOptions) {
+        HostLatencyTracker::get(cmdState->interface->_svcCtx)->onRequestStarted(request->target);
+        requestState->sendTimer.reset();
+    }
+
     requestState->resolve(cmdState->sendRequest(requestState));
 }
 
@@ -820,6 +966,14 @@ void NetworkInterfaceTL::RequestState::resolve(Future<RemoteCommandResponse> fut
 
             returnConnection(status);
 
+            if (auto svcCtx = cmdState->interface->_svcCtx; svcCtx && request->hedgeOptions) {
+                auto tracker = HostLatencyTracker::get(svcCtx);
+                tracker->onRequestFinished(host);
+                if (status.isOK()) {
+                    tracker->recordLatency(host, Microseconds(sendTimer.micros()));
+                }
+            }
+
             const auto commandStatus = getStatusFromCommandResult(response.data);
             if (isHedge) {
                 // Ignore maxTimeMS expiration, StaleDbVersion or any error belonging to
@@ -1053,6 +1207,87 @@ void NetworkInterfaceTL::cancelCommand(const TaskExecutor::CallbackHandle& cbHan
                        << redact(cmdStateToCancel->requestOnAny.toString())});
 }
 
+std::shared_ptr<ConnectionPool::ConnectionInterface>
+NetworkInterfaceTL::_leaseMultiplexedConnection(const HostAndPort& host) {
+    stdx::lock_guard lk(_multiplexedMutex);
+    auto it = _multiplexedConns.find(host);
+    if (it == _multiplexedConns.end()) {
+        return nullptr;
+    }
+
+    // Lease the least loaded connection, so that a request waits behind as few others as possible.
+    MultiplexedConnection* leased = nullptr;
+    std::shared_ptr<ConnectionPool::ConnectionInterface> leasedConn;
+    for (auto& multiplexedConn : it->second) {
+        auto conn = multiplexedConn.conn.lock();
+        if (!conn || multiplexedConn.inFlight >= _connPoolOpts.maxRequestsPerConnection ||
+            (leased && multiplexedConn.inFlight >= leased->inFlight) ||
+            !RequestState::getClient(conn)->canMultiplexMoreRequests()) {
+            continue;
+        }
+        leased = &multiplexedConn;
+        leasedConn = std::move(conn);
+    }
+
+    if (leased) {
+        ++leased->inFlight;
+    }
+    return leasedConn;
+}
+
+void NetworkInterfaceTL::_shareMultiplexedConnection(
+    const HostAndPort& host, const std::shared_ptr<ConnectionPool::ConnectionInterface>& conn) {
+    stdx::lock_guard lk(_multiplexedMutex);
+    auto& conns = _multiplexedConns[host];
+    for (auto& multiplexedConn : conns) {
+        if (multiplexedConn.conn.lock() == conn) {
+            // The request leased the connection, which counted it.
+            return;
+        }
+    }
+    conns.push_back({conn, 1});
+}
+
+void NetworkInterfaceTL::_releaseMultiplexedConnection(
+    const HostAndPort& host, const std::shared_ptr<ConnectionPool::ConnectionInterface>& conn) {
+    // Requests on the same connection finish on different threads, so the connection's status is
+    // only ever set under the mutex. The last request to release it decides its fate.
+    stdx::lock_guard lk(_multiplexedMutex);
+    auto client = RequestState::getClient(conn);
+    if (auto it = _multiplexedConns.find(host); it != _multiplexedConns.end()) {
+        auto& conns = it->second;
+        auto connIt = std::find_if(conns.begin(), conns.end(), [&](const auto& multiplexedConn) {
+            return multiplexedConn.conn.lock() == conn;
+        });
+        if (connIt != conns.end()) {
+            if (--connIt->inFlight > 0) {
+                return;
+            }
+            conns.erase(connIt);
+            if (conns.empty()) {
+                _multiplexedConns.erase(it);
+            }
+        }
+    }
+
+    auto status = client->getMultiplexingStatus();
+    if (status.isOK() && client->hasMultiplexedRequestsInFlight()) {
+        status = Status(ErrorCodes::OperationFailed,
+                        "Connection still has multiplexed requests in flight");
+    }
+
+    if (status.isOK()) {
+        conn->indicateUsed();
+        conn->indicateSuccess();
+        return;
+    }
+
+    // Nothing else can use the connection, so whatever it still has in flight was abandoned. End
+    // the session so that the outstanding reads do not outlive it.
+    client->end();
+    conn->indicateFailure(std::move(status));
+}
+
 Status NetworkInterfaceTL::_killOperation(std::shared_ptr<RequestState> requestStateToKill) try {
     auto [target, sslMode] = [&] {
         invariant(requestStateToKill->request);
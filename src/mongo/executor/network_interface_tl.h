@@ -44,6 +44,7 @@
 #include "mongo/transport/transport_layer.h"
 #include "mongo/util/hierarchical_acquisition.h"
 #include "mongo/util/strong_weak_finish_line.h"
+#include "mongo/util/timer.h"
 
 
 namespace mongo {
@@ -172,6 +173,9 @@ private:
         BatonHandle baton;
         std::unique_ptr<transport::ReactorTimer> timer;
 
+        // Holds back the hedged requests of a command whose hedging is delayed by observed latency.
+        std::unique_ptr<transport::ReactorTimer> hedgeTimer;
+
         std::unique_ptr<RequestManager> requestManager;
 
         // TODO replace the finishLine with an atomic bool. It is no longer tracking allowed
@@ -179,6 +183,9 @@ private:
         StrongWeakFinishLine finishLine;
 
         boost::optional<UUID> operationKey;
+
+        // Set if this command's requests may share a connection with other requests in flight.
+        bool multiplexed{false};
     };
 
     struct CommandState final : public CommandStateBase {
@@ -233,7 +240,8 @@ private:
     struct RequestManager {
         RequestManager(CommandStateBase* cmdState);
 
-        void trySend(StatusWith<ConnectionPool::ConnectionHandle> swConn, size_t idx) noexcept;
+        void trySend(StatusWith<std::shared_ptr<ConnectionPool::ConnectionInterface>> swConn,
+                     size_t idx) noexcept;
         void cancelRequests();
         void killOperationsForPendingRequests();
 
@@ -300,6 +308,9 @@ private:
         // Internal id of this request as tracked by the RequestManager.
         size_t reqId;
 
+        // Measures the round trip of a hedge-eligible request for the HostLatencyTracker.
+        Timer sendTimer;
+
         // True if this request is an additional request sent to hedge the operation.
         bool isHedge{false};
 
@@ -307,6 +318,9 @@ private:
         // promise (i.e. arrives before the responses to all other requests and is not
         // a MaxTimeMSExpired error response if this is a hedged request).
         bool fulfilledPromise{false};
+
+        // The id the request was sent with if it is multiplexed over a shared connection.
+        boost::optional<int32_t> multiplexedMsgId;
     };
 
     struct AlarmState {
@@ -334,6 +348,29 @@ private:
 
     Status _killOperation(std::shared_ptr<RequestState> requestStateToKill);
 
+    /**
+     * Returns the least loaded connection to 'host' that fewer than maxRequestsPerConnection
+     * requests are already multiplexed over and that can take more, counting the caller as one of
+     * them. Returns nullptr if a new connection should be acquired from the pool.
+     */
+    std::shared_ptr<ConnectionPool::ConnectionInterface> _leaseMultiplexedConnection(
+        const HostAndPort& host);
+
+    /**
+     * Makes 'conn' available to the requests multiplexed to 'host' for as long as any of them uses
+     * it. A connection which did not come from _leaseMultiplexedConnection() counts the caller as
+     * its first request.
+     */
+    void _shareMultiplexedConnection(
+        const HostAndPort& host, const std::shared_ptr<ConnectionPool::ConnectionInterface>& conn);
+
+    /**
+     * Releases a multiplexed request's lease of 'conn'. When the last request releases it, the
+     * connection goes back to the pool, healthy only if nothing is left in flight on it.
+     */
+    void _releaseMultiplexedConnection(
+        const HostAndPort& host, const std::shared_ptr<ConnectionPool::ConnectionInterface>& conn);
+
     std::string _instanceName;
     ServiceContext* _svcCtx = nullptr;
     transport::TransportLayer* _tl = nullptr;
@@ -366,6 +403,17 @@ private:
         MONGO_MAKE_LATCH(HierarchicalAcquisitionLevel(0), "NetworkInterfaceTL::_inProgressMutex");
     stdx::unordered_map<TaskExecutor::CallbackHandle, std::weak_ptr<CommandStateBase>> _inProgress;
 
+    // A connection which requests are currently multiplexed over, and the number of them that
+    // have leased it and not yet released it.
+    struct MultiplexedConnection {
+        std::weak_ptr<ConnectionPool::ConnectionInterface> conn;
+        size_t inFlight;
+    };
+
+    // The connections that requests are currently multiplexed over, by host.
+    Mutex _multiplexedMutex = MONGO_MAKE_LATCH("NetworkInterfaceTL::_multiplexedMutex");
+    stdx::unordered_map<HostAndPort, std::vector<MultiplexedConnection>> _multiplexedConns;
+
     bool _inProgressAlarmsInShutdown = false;
     stdx::unordered_map<TaskExecutor::CallbackHandle, std::shared_ptr<AlarmState>>
         _inProgressAlarms;
@@ -183,6 +183,9 @@ std::string RemoteCommandRequestImpl<T>::toString() const {
     if (hedgeOptions) {
         invariant(operationKey);
         out << " hedgeOptions.count: " << hedgeOptions->count;
+        if (hedgeOptions->delayPercentile) {
+            out << " hedgeOptions.delayPercentile: " << hedgeOptions->delayPercentile;
+        }
         out << " operationKey: " << operationKey.get();
     }
 
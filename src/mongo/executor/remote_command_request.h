@@ -47,6 +47,10 @@ struct RemoteCommandRequestBase {
     struct HedgeOptions {
         size_t count = 0;
         int maxTimeMSForHedgedReads = 0;
+        // When non-zero, the first target is chosen by observed latency and the hedged requests
+        // are held back until the first one has been outstanding for longer than this percentile
+        // of the latencies observed for its target. When zero, all requests are sent at once.
+        int delayPercentile = 0;
     };
 
     enum FireAndForgetMode { kOn, kOff };
@@ -31,6 +31,7 @@
 
 #include "mongo/rpc/message.h"
 
+#include <cstring>
 #include <fmt/format.h>
 
 #include "mongo/platform/atomic_word.h"
@@ -46,6 +47,35 @@ int32_t nextMessageId() {
     return NextMsgId.fetchAndAdd(1);
 }
 
+void Message::setSegments(std::vector<ConstDataRange> segments,
+                          std::vector<ConstSharedBuffer> owners) {
+    invariant(!empty());
+    invariant(!segments.empty());
+    invariant(segments.front().data() == _buf.get());
+
+    size_t totalSize = 0;
+    for (const auto& segment : segments) {
+        totalSize += segment.length();
+    }
+    invariant(totalSize == static_cast<size_t>(size()));
+
+    _segments = std::move(segments);
+    _segmentOwners = std::move(owners);
+}
+
+void Message::_doCoalesceSegments() const {
+    auto coalesced = SharedBuffer::allocate(size());
+    char* out = coalesced.get();
+    for (const auto& segment : _segments) {
+        std::memcpy(out, segment.data(), segment.length());
+        out += segment.length();
+    }
+
+    _buf = std::move(coalesced);
+    _segments.clear();
+    _segmentOwners.clear();
+}
+
 std::string Message::opMsgDebugString() const {
     MsgData::ConstView headerView = header();
     auto opMsgRequest = OpMsgRequest::parse(*this);
@@ -30,11 +30,15 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
+#include "mongo/base/data_range.h"
 #include "mongo/base/data_type_endian.h"
 #include "mongo/base/data_view.h"
 #include "mongo/base/encoded_value_storage.h"
 #include "mongo/base/static_assert.h"
+#include "mongo/platform/compiler.h"
+#include "mongo/util/shared_buffer.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
@@ -395,6 +399,10 @@ public:
     Message() = default;
     explicit Message(SharedBuffer data) : _buf(std::move(data)) {}
 
+    /**
+     * The header always lives at the front of this message's own buffer, so it can be read and
+     * updated without coalescing a segmented message (see setSegments()).
+     */
     MsgData::View header() const {
         verify(!empty());
         return _buf.get();
@@ -406,6 +414,7 @@ public:
 
     MsgData::View singleData() const {
         massert(13273, "single data buffer expected", _buf);
+        _coalesceSegments();
         return header();
     }
 
@@ -425,15 +434,19 @@ public:
     }
 
     size_t capacity() const {
+        _coalesceSegments();
         return _buf.capacity();
     }
 
     void realloc(size_t size) {
+        _coalesceSegments();
         _buf.reallocOrCopy(size);
     }
 
     void reset() {
         _buf = {};
+        _segments.clear();
+        _segmentOwners.clear();
     }
 
     // use to set first buffer if empty
@@ -456,25 +469,61 @@ public:
     }
 
     char* buf() {
+        _coalesceSegments();
         return _buf.get();
     }
 
     const char* buf() const {
+        _coalesceSegments();
         return _buf.get();
     }
 
     SharedBuffer sharedBuffer() {
+        _coalesceSegments();
         return _buf;
     }
 
     ConstSharedBuffer sharedBuffer() const {
+        _coalesceSegments();
         return _buf;
     }
 
+    /**
+     * Describes the contents of this message as the concatenation of 'segments', so that large
+     * documents which are already owned elsewhere can be written to the network with a single
+     * gather write instead of first being copied into this message's buffer. The segments may
+     * point into this message's own buffer, which must begin with the header of the complete
+     * message, or into buffers kept alive by 'owners' for as long as the segments are held.
+     *
+     * Accessing the raw bytes of a segmented message through buf(), singleData() or
+     * sharedBuffer() first coalesces the segments into a single buffer.
+     */
+    void setSegments(std::vector<ConstDataRange> segments, std::vector<ConstSharedBuffer> owners);
+
+    bool hasSegments() const {
+        return !_segments.empty();
+    }
+
+    const std::vector<ConstDataRange>& segments() const {
+        return _segments;
+    }
+
     std::string opMsgDebugString() const;
 
 private:
-    SharedBuffer _buf;
+    void _coalesceSegments() const {
+        if (MONGO_unlikely(hasSegments())) {
+            _doCoalesceSegments();
+        }
+    }
+
+    void _doCoalesceSegments() const;
+
+    // Coalescing a segmented message is invisible to callers, so it is allowed from const
+    // accessors.
+    mutable SharedBuffer _buf;
+    mutable std::vector<ConstDataRange> _segments;
+    mutable std::vector<ConstSharedBuffer> _segmentOwners;
 };
 
 /**
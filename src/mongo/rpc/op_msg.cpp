@@ -41,6 +41,7 @@
 #include "mongo/db/bson/dotted_path_support.h"
 #include "mongo/logv2/log.h"
 #include "mongo/rpc/object_check.h"
+#include "mongo/rpc/op_msg_parameters_gen.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/hex.h"
 
@@ -77,14 +78,67 @@ uint32_t calculateChecksum(const Message& message) {
     return wiredtiger_crc32c_func()(message.singleData().view2ptr(), message.size() - kCrc32Size);
 }
 #endif  // MONGO_CONFIG_WIREDTIGER_ENABLED
+
+// Size of the empty document written into the builder in place of each referenced document.
+constexpr int kPlaceholderSize = 5;
+
+struct LengthPatch {
+    char* lengthField;
+    int length;
+};
+
+/**
+ * Walks the object at 'objData', which must lie within the buffer starting at 'base', and records
+ * in 'patches' the new length of it and of every object nested in it that encloses one of the
+ * placeholders in ['it', 'end'). Placeholders must be ordered by offset and 'it' is advanced past
+ * those within the object. Returns how many bytes the object grows by.
+ */
+template <typename Iterator>
+int growObjectsEnclosingPlaceholders(
+    char* base, char* objData, Iterator& it, Iterator end, std::vector<LengthPatch>* patches) {
+    const BSONObj obj(objData);
+    const int objEnd = (objData - base) + obj.objsize();
+    int growth = 0;
+
+    for (auto&& elem : obj) {
+        if (it == end || it->placeholderOffset >= objEnd) {
+            break;
+        }
+        if (!elem.isABSONObj()) {
+            continue;
+        }
+
+        const int valueOffset = elem.value() - base;
+        if (it->placeholderOffset >= valueOffset + elem.valuesize()) {
+            continue;
+        }
+
+        if (it->placeholderOffset == valueOffset) {
+            growth += it->obj.objsize() - kPlaceholderSize;
+            ++it;
+        } else {
+            growth += growObjectsEnclosingPlaceholders(
+                base, const_cast<char*>(elem.value()), it, end, patches);
+        }
+    }
+
+    invariant(it == end || it->placeholderOffset >= objEnd);
+    if (growth) {
+        // Patches are applied once the walk is done, since iterating an object reads the lengths
+        // of the objects nested in it.
+        patches->push_back({objData, obj.objsize() + growth});
+    }
+    return growth;
+}
 }  // namespace
 
 uint32_t OpMsg::flags(const Message& message) {
     if (message.operation() != dbMsg)
         return 0;  // Other command protocols are the same as no flags set.
 
-    return BufReader(message.singleData().data(), message.dataSize())
-        .read<LittleEndian<uint32_t>>();
+    // The flags directly follow the header, so reading them through header() rather than
+    // singleData() avoids coalescing a segmented message.
+    return BufReader(message.header().data(), message.dataSize()).read<LittleEndian<uint32_t>>();
 }
 
 void OpMsg::replaceFlags(Message* message, uint32_t flags) {
@@ -92,7 +146,7 @@ void OpMsg::replaceFlags(Message* message, uint32_t flags) {
     invariant(message->operation() == dbMsg);
     invariant(message->dataSize() >= static_cast<int>(sizeof(uint32_t)));
 
-    DataView(message->singleData().data()).write<LittleEndian<uint32_t>>(flags);
+    DataView(message->header().data()).write<LittleEndian<uint32_t>>(flags);
 }
 
 uint32_t OpMsg::getChecksum(const Message& message) {
@@ -306,8 +360,58 @@ BSONObjBuilder OpMsgBuilder::resumeBody() {
 
 AtomicWord<bool> OpMsgBuilder::disableDupeFieldCheck_forTest{false};
 
+int OpMsgBuilder::appendDocumentToArray(BSONArrayBuilder* array, const BSONObj& obj) {
+    invariant(_state == kBody);
+    invariant(_openBuilder);
+    invariant(&array->bb() == &_buf);
+
+    const auto minBytes = gOpMsgReplyReferenceDocumentMinBytes.load();
+    if (minBytes <= 0 || !obj.isOwned() || obj.objsize() < minBytes) {
+        array->append(obj);
+        return 0;
+    }
+
+    array->append(BSONObj());
+    _referencedDocuments.push_back({_buf.len() - kPlaceholderSize, obj});
+
+    const int extraBytes = obj.objsize() - kPlaceholderSize;
+    _referencedBytes += extraBytes;
+    return extraBytes;
+}
+
+void OpMsgBuilder::spliceReferencedDocuments(Message* message) {
+    char* const base = message->buf();
+    const int headSize = _buf.len();
+    invariant(_referencedDocuments.front().placeholderOffset > _bodyStart);
+
+    std::vector<LengthPatch> patches;
+    auto it = _referencedDocuments.begin();
+    growObjectsEnclosingPlaceholders(
+        base, base + _bodyStart, it, _referencedDocuments.end(), &patches);
+    invariant(it == _referencedDocuments.end());
+    for (const auto& patch : patches) {
+        DataView(patch.lengthField).write<LittleEndian<int32_t>>(patch.length);
+    }
+
+    std::vector<ConstDataRange> segments;
+    std::vector<ConstSharedBuffer> owners;
+    segments.reserve(2 * _referencedDocuments.size() + 1);
+    owners.reserve(_referencedDocuments.size());
+
+    int offset = 0;
+    for (const auto& doc : _referencedDocuments) {
+        segments.emplace_back(base + offset, base + doc.placeholderOffset);
+        segments.emplace_back(doc.obj.objdata(), doc.obj.objsize());
+        owners.push_back(doc.obj.sharedBuffer());
+        offset = doc.placeholderOffset + kPlaceholderSize;
+    }
+    segments.emplace_back(base + offset, base + headSize);
+
+    message->setSegments(std::move(segments), std::move(owners));
+}
+
 Message OpMsgBuilder::finish() {
-    const auto size = _buf.len();
+    const auto size = _buf.len() + _referencedBytes;
     uassert(ErrorCodes::BSONObjectTooLarge,
             str::stream() << "BSON size limit hit while building Message. Size: " << size << " (0x"
                           << unsignedHex(size) << "); maxSize: " << BSONObjMaxInternalSize << "("
@@ -338,11 +442,16 @@ Message OpMsgBuilder::finishWithoutSizeChecking() {
 
     const auto size = _buf.len();
     MSGHEADER::View header(_buf.buf());
-    header.setMessageLength(size);
+    header.setMessageLength(size + _referencedBytes);
     // header.setRequestMsgId(...); // These are currently filled in by the networking layer.
     // header.setResponseToMsgId(...);
     header.setOpCode(dbMsg);
-    return Message(_buf.release());
+
+    Message message(_buf.release());
+    if (!_referencedDocuments.empty()) {
+        spliceReferencedDocuments(&message);
+    }
+    return message;
 }
 
 BSONObj OpMsgBuilder::releaseBody() {
@@ -350,6 +459,13 @@ BSONObj OpMsgBuilder::releaseBody() {
     invariant(_bodyStart);
     invariant(_bodyStart == sizeof(MSGHEADER::Layout) + 4 /*flags*/ + 1 /*body kind byte*/);
     invariant(!_openBuilder);
+
+    if (!_referencedDocuments.empty()) {
+        // The body only holds placeholders for the referenced documents, so it needs to be
+        // materialized into a single buffer.
+        return OpMsg::parseOwned(finishWithoutSizeChecking()).body;
+    }
+
     _state = kDone;
 
     auto bson = BSONObj(_buf.buf() + _bodyStart);
@@ -263,8 +263,21 @@ public:
         _bodyStart = 0;
         _state = kEmpty;
         _openBuilder = false;
+        _referencedDocuments.clear();
+        _referencedBytes = 0;
     }
 
+    /**
+     * Appends 'obj' as the next element of 'array', which must be building an array nested in the
+     * body. Owned documents of at least 'opMsgReplyReferenceDocumentMinBytes' are not copied into
+     * this builder: an empty placeholder document is written in their place, and the finished
+     * Message sends the document straight from its own buffer as a separate segment.
+     *
+     * Returns the number of bytes the document adds to the finished message in excess of what was
+     * written into this builder.
+     */
+    int appendDocumentToArray(BSONArrayBuilder* array, const BSONObj& obj);
+
     /**
      * Set to true in tests that need to be able to generate duplicate top-level fields to see how
      * the server handles them. Is false by default, although the check only happens in debug
@@ -309,11 +322,24 @@ private:
         _buf.appendNum(uint32_t(0));           // flags (currently always 0).
     }
 
+    /**
+     * Splices the documents recorded by appendDocumentToArray() into 'message', which holds the
+     * finished buffer with placeholders in their place.
+     */
+    void spliceReferencedDocuments(Message* message);
+
+    struct ReferencedDocument {
+        int placeholderOffset;
+        BSONObj obj;
+    };
+
     // When adding members, remember to update reset().
     BufBuilder _buf;
     int _bodyStart = 0;
     State _state = kEmpty;
     bool _openBuilder = false;
+    std::vector<ReferencedDocument> _referencedDocuments;
+    int _referencedBytes = 0;
 };
 
 /**
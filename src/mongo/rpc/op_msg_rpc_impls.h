@@ -78,6 +78,9 @@ public:
     void reserveBytes(const std::size_t bytes) override {
         _builder.reserveBytes(bytes);
     }
+    int appendDocumentToArray(BSONArrayBuilder* array, const BSONObj& obj) override {
+        return _builder.appendDocumentToArray(array, obj);
+    }
     BSONObj releaseBody() {
         return _builder.releaseBody();
     }
@@ -37,6 +37,7 @@
 #include "mongo/bson/json.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/idl/server_parameter_test_util.h"
 #include "mongo/logv2/log.h"
 #include "mongo/rpc/op_msg.h"
 #include "mongo/unittest/log_test.h"
@@ -823,6 +824,53 @@ TEST(OpMsgSerializer, BodyAndInPlaceSequenceInPlaceWithReset) {
                    });
 }
 
+TEST(OpMsgSerializer, ReferencedDocumentsInPlace) {
+    RAIIServerParameterControllerForTest minBytes("opMsgReplyReferenceDocumentMinBytes", 20);
+    const auto big0 = BSON("s" << std::string(32, 'x'));
+    const auto big1 = BSON("s" << std::string(64, 'y'));
+    const auto small = fromjson("{a: 1}");
+    const auto expectedBody = BSON("cursor" << BSON("nextBatch" << BSON_ARRAY(big0 << small << big1)
+                                                                << "id" << 0LL)
+                                            << "ok" << 1);
+
+    auto buildBody = [&](OpMsgBuilder* builder) {
+        auto body = builder->beginBody();
+        {
+            BSONObjBuilder cursor(body.subobjStart("cursor"));
+            {
+                BSONArrayBuilder batch(cursor.subarrayStart("nextBatch"));
+                ASSERT_EQ(builder->appendDocumentToArray(&batch, big0), big0.objsize() - 5);
+                ASSERT_EQ(builder->appendDocumentToArray(&batch, small), 0);
+                ASSERT_EQ(builder->appendDocumentToArray(&batch, big1), big1.objsize() - 5);
+            }
+            cursor.append("id", 0LL);
+        }
+        body.append("ok", 1);
+    };
+
+    OpMsgBuilder builder;
+    buildBody(&builder);
+    auto message = builder.finish();
+
+    // The large documents are sent straight from their own buffers.
+    ASSERT(message.hasSegments());
+    const auto& segments = message.segments();
+    ASSERT_EQ(segments.size(), 5u);
+    ASSERT_EQ(static_cast<const void*>(segments[1].data()), big0.objdata());
+    ASSERT_EQ(static_cast<const void*>(segments[3].data()), big1.objdata());
+
+    testSerializer(message,
+                   OpMsgBytes{
+                       kNoFlags,  //
+                       kBodySection,
+                       expectedBody,
+                   });
+
+    OpMsgBuilder releasingBuilder;
+    buildBody(&releasingBuilder);
+    ASSERT_BSONOBJ_EQ(releasingBuilder.releaseBody(), expectedBody);
+}
+
 TEST(OpMsgSerializer, ReplaceFlagsWorks) {
     {
         auto msg = OpMsgBytes{~0u}.done();
@@ -106,6 +106,11 @@ ReplyBuilderInterface& ReplyBuilderInterface::setCommandReply(Status nonOKStatus
     return setRawCommandReply(augmentReplyWithStatus(nonOKStatus, std::move(extraErrorInfo)));
 }
 
+int ReplyBuilderInterface::appendDocumentToArray(BSONArrayBuilder* array, const BSONObj& obj) {
+    array->append(obj);
+    return 0;
+}
+
 bool ReplyBuilderInterface::shouldRunAgainForExhaust() const {
     return _shouldRunAgainForExhaust;
 }
@@ -37,6 +37,7 @@
 #include "mongo/rpc/protocol.h"
 
 namespace mongo {
+class BSONArrayBuilder;
 class BSONObj;
 class BSONObjBuilder;
 class Message;
@@ -138,6 +139,14 @@ public:
      */
     virtual void reserveBytes(const std::size_t bytes) = 0;
 
+    /**
+     * Appends 'obj' as the next element of 'array', which must be building an array nested in the
+     * reply body. Implementations may send large owned documents from their own buffers rather
+     * than copying them into the reply. Returns the number of bytes the document adds to the
+     * reply in excess of what was written through 'array'.
+     */
+    virtual int appendDocumentToArray(BSONArrayBuilder* array, const BSONObj& obj);
+
     /**
      * For exhaust commands, returns whether the command should be run again.
      */
@@ -111,6 +111,19 @@ std::vector<std::shared_ptr<ChunkInfo>> flatten(const std::vector<ChunkType>& ch
     return flattened;
 }
 
+// Packs the leading bytes of "keyString" into an integer, padding short KeyStrings with zeroes, so
+// that the integer order of two prefixes matches the order of the KeyStrings whenever they differ.
+uint64_t makeKeyStringPrefix(const std::string& keyString) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < sizeof(prefix); ++i) {
+        prefix <<= 8;
+        if (i < keyString.size()) {
+            prefix |= static_cast<unsigned char>(keyString[i]);
+        }
+    }
+    return prefix;
+}
+
 }  // namespace
 
 ShardVersionMap ChunkMap::constructShardVersionMap() const {
@@ -194,10 +207,29 @@ ShardVersionMap ChunkMap::constructShardVersionMap() const {
 void ChunkMap::appendChunk(const std::shared_ptr<ChunkInfo>& chunk) {
     appendChunkTo(_chunkMap, chunk);
 
+    // Keep the max key prefixes in step with the chunks, the last of which may have been replaced
+    if (_maxKeyStringPrefixes.size() == _chunkMap.size() && _chunkMap.back() == chunk) {
+        _maxKeyStringPrefixes.pop_back();
+    }
+    if (_maxKeyStringPrefixes.size() < _chunkMap.size()) {
+        _maxKeyStringPrefixes.push_back(makeKeyStringPrefix(chunk->getMaxKeyString()));
+    }
+
     if (_collectionVersion.isOlderThan(chunk->getLastmod()))
         _collectionVersion = chunk->getLastmod();
 }
 
+void ChunkMap::_pushBack(const ChunkMap& other, size_t begin, size_t end) {
+    if (begin >= end)
+        return;
+
+    _chunkMap.insert(
+        _chunkMap.end(), other._chunkMap.begin() + begin, other._chunkMap.begin() + end);
+    _maxKeyStringPrefixes.insert(_maxKeyStringPrefixes.end(),
+                                 other._maxKeyStringPrefixes.begin() + begin,
+                                 other._maxKeyStringPrefixes.begin() + end);
+}
+
 std::shared_ptr<ChunkInfo> ChunkMap::findIntersectingChunk(const BSONObj& shardKey) const {
     const auto it = _findIntersectingChunk(shardKey);
 
@@ -218,41 +250,42 @@ void validateChunk(const std::shared_ptr<ChunkInfo>& chunk, const ChunkVersion&
 
 ChunkMap ChunkMap::createMerged(
     const std::vector<std::shared_ptr<ChunkInfo>>& changedChunks) const {
-    size_t chunkMapIndex = 0;
-    size_t changedChunkIndex = 0;
-
     ChunkMap updatedChunkMap(
         getVersion().epoch(), getVersion().getTimestamp(), _chunkMap.size() + changedChunks.size());
-
-    while (chunkMapIndex < _chunkMap.size() || changedChunkIndex < changedChunks.size()) {
-        if (chunkMapIndex >= _chunkMap.size()) {
-            validateChunk(changedChunks[changedChunkIndex], getVersion());
-            updatedChunkMap.appendChunk(changedChunks[changedChunkIndex++]);
-            continue;
-        }
-
-        if (changedChunkIndex >= changedChunks.size()) {
-            updatedChunkMap.appendChunk(_chunkMap[chunkMapIndex++]);
-            continue;
+    updatedChunkMap._collectionVersion = _collectionVersion;
+
+    // Position of the first chunk of this map, which has not yet been copied to or replaced in the
+    // updated map
+    size_t nextChunkIndex = 0;
+
+    for (const auto& changedChunk : changedChunks) {
+        validateChunk(changedChunk, getVersion());
+
+        // The first chunk which ends after the start of the changed chunk is the first one which
+        // can overlap with it. Everything before it is unaffected by the change.
+        const auto firstOverlapIndex =
+            _upperBound(ShardKeyPattern::toKeyString(changedChunk->getMin()));
+        if (firstOverlapIndex < _chunkMap.size() &&
+            _chunkMap[firstOverlapIndex]->getRange().overlaps(changedChunk->getRange())) {
+            auto bytesInReplacedChunk =
+                _chunkMap[firstOverlapIndex]->getWritesTracker()->getBytesWritten();
+            changedChunk->getWritesTracker()->addBytesWritten(bytesInReplacedChunk);
         }
 
-        auto overlap = _chunkMap[chunkMapIndex]->getRange().overlaps(
-            changedChunks[changedChunkIndex]->getRange());
-
-        if (overlap) {
-            auto& changedChunk = changedChunks[changedChunkIndex++];
-            auto& chunkInfo = _chunkMap[chunkMapIndex];
-
-            auto bytesInReplacedChunk = chunkInfo->getWritesTracker()->getBytesWritten();
-            changedChunk->getWritesTracker()->addBytesWritten(bytesInReplacedChunk);
+        updatedChunkMap._pushBack(*this, nextChunkIndex, firstOverlapIndex);
+        updatedChunkMap.appendChunk(changedChunk);
 
-            validateChunk(changedChunk, getVersion());
-            updatedChunkMap.appendChunk(changedChunk);
-        } else {
-            updatedChunkMap.appendChunk(_chunkMap[chunkMapIndex++]);
+        // Skip the chunks which end inside of the changed chunk and the one which straddles its
+        // max bound, if any, since they have all been replaced by it
+        nextChunkIndex = std::max(nextChunkIndex, _lowerBound(changedChunk->getMaxKeyString()));
+        if (nextChunkIndex < _chunkMap.size() &&
+            _chunkMap[nextChunkIndex]->getRange().overlaps(changedChunk->getRange())) {
+            ++nextChunkIndex;
         }
     }
 
+    updatedChunkMap._pushBack(*this, nextChunkIndex, _chunkMap.size());
+
     return updatedChunkMap;
 }
 
@@ -277,22 +310,45 @@ ChunkMap::ChunkVector::const_iterator ChunkMap::_findIntersectingChunk(const BSO
     auto shardKeyString = ShardKeyPattern::toKeyString(shardKey);
 
     if (!isMaxInclusive) {
-        return std::lower_bound(_chunkMap.begin(),
-                                _chunkMap.end(),
-                                shardKey,
-                                [&shardKeyString](const auto& chunkInfo, const BSONObj& shardKey) {
-                                    return chunkInfo->getMaxKeyString() < shardKeyString;
-                                });
+        return _chunkMap.begin() + _lowerBound(shardKeyString);
     } else {
-        return std::upper_bound(_chunkMap.begin(),
-                                _chunkMap.end(),
-                                shardKey,
-                                [&shardKeyString](const BSONObj& shardKey, const auto& chunkInfo) {
-                                    return shardKeyString < chunkInfo->getMaxKeyString();
-                                });
+        return _chunkMap.begin() + _upperBound(shardKeyString);
     }
 }
 
+std::pair<size_t, size_t> ChunkMap::_equalPrefixRange(const std::string& keyString) const {
+    const auto prefix = makeKeyStringPrefix(keyString);
+    const auto first =
+        std::lower_bound(_maxKeyStringPrefixes.begin(), _maxKeyStringPrefixes.end(), prefix);
+    const auto last = std::upper_bound(first, _maxKeyStringPrefixes.end(), prefix);
+
+    return {first - _maxKeyStringPrefixes.begin(), last - _maxKeyStringPrefixes.begin()};
+}
+
+size_t ChunkMap::_upperBound(const std::string& keyString) const {
+    const auto [first, last] = _equalPrefixRange(keyString);
+
+    const auto it = std::upper_bound(_chunkMap.begin() + first,
+                                     _chunkMap.begin() + last,
+                                     keyString,
+                                     [](const std::string& keyString, const auto& chunkInfo) {
+                                         return keyString < chunkInfo->getMaxKeyString();
+                                     });
+    return it - _chunkMap.begin();
+}
+
+size_t ChunkMap::_lowerBound(const std::string& keyString) const {
+    const auto [first, last] = _equalPrefixRange(keyString);
+
+    const auto it = std::lower_bound(_chunkMap.begin() + first,
+                                     _chunkMap.begin() + last,
+                                     keyString,
+                                     [](const auto& chunkInfo, const std::string& keyString) {
+                                         return chunkInfo->getMaxKeyString() < keyString;
+                                     });
+    return it - _chunkMap.begin();
+}
+
 std::pair<ChunkMap::ChunkVector::const_iterator, ChunkMap::ChunkVector::const_iterator>
 ChunkMap::_overlappingBounds(const BSONObj& min, const BSONObj& max, bool isMaxInclusive) const {
     const auto itMin = _findIntersectingChunk(min);
@@ -71,17 +71,29 @@ using ShardVersionMap = stdx::unordered_map<ShardId, ShardVersionTargetingInfo,
  * This class serves as a Facade around how the mapping of ranges to chunks is represented. It also
  * provides a simpler, high-level interface for domain specific operations without exposing the
  * underlying implementation.
+ *
+ * Next to the chunks themselves, the map keeps a contiguous array with the leading bytes of each
+ * chunk's max KeyString. Lookups binary search this array first and only dereference the chunks
+ * whose prefix is equal to the one of the searched key, which keeps the search cache friendly even
+ * for routing tables with hundreds of thousands of chunks.
  */
 class ChunkMap {
     // Vector of chunks ordered by max key.
     using ChunkVector = std::vector<std::shared_ptr<ChunkInfo>>;
 
+    // Big-endian leading bytes of the max KeyString of each chunk, in the same order as the chunks.
+    // Comparing two prefixes as integers gives the same result as comparing the full KeyStrings,
+    // unless the prefixes are equal.
+    using KeyStringPrefix = uint64_t;
+    using KeyStringPrefixVector = std::vector<KeyStringPrefix>;
+
 public:
     explicit ChunkMap(OID epoch,
                       const boost::optional<Timestamp>& timestamp,
                       size_t initialCapacity = 0)
         : _collectionVersion(0, 0, epoch, timestamp) {
         _chunkMap.reserve(initialCapacity);
+        _maxKeyStringPrefixes.reserve(initialCapacity);
     }
 
     size_t size() const {
@@ -120,6 +132,12 @@ public:
 
     void appendChunk(const std::shared_ptr<ChunkInfo>& chunk);
 
+    /**
+     * Returns a new map, in which the chunks overlapping with any of the "changedChunks" have been
+     * replaced by them. The "changedChunks" must be sorted by max key and must not overlap. The
+     * chunks in between the changed ranges are copied over in bulk, without being compared
+     * against each other.
+     */
     ChunkMap createMerged(const std::vector<std::shared_ptr<ChunkInfo>>& changedChunks) const;
 
     BSONObj toBSON() const;
@@ -130,8 +148,28 @@ private:
     std::pair<ChunkVector::const_iterator, ChunkVector::const_iterator> _overlappingBounds(
         const BSONObj& min, const BSONObj& max, bool isMaxInclusive) const;
 
+    /**
+     * Returns the position of the first chunk whose max KeyString is greater than (upper bound) or
+     * greater than or equal to (lower bound) "keyString".
+     */
+    size_t _upperBound(const std::string& keyString) const;
+    size_t _lowerBound(const std::string& keyString) const;
+
+    /**
+     * Returns the range of positions whose max KeyString has the same prefix as "keyString". All
+     * chunks before the range sort before "keyString" and all chunks after it sort after it.
+     */
+    std::pair<size_t, size_t> _equalPrefixRange(const std::string& keyString) const;
+
+    /**
+     * Appends the chunks at positions [begin, end) of "other" without checking them for overlap.
+     */
+    void _pushBack(const ChunkMap& other, size_t begin, size_t end);
+
     ChunkVector _chunkMap;
 
+    KeyStringPrefixVector _maxKeyStringPrefixes;
+
     // Max version across all chunks
     ChunkVersion _collectionVersion;
 };
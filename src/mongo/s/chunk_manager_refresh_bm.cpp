@@ -413,6 +413,20 @@ MONGO_INITIALIZER(RegisterBenchmarks)(InitializerContext* context) {
             ->Args({1000, 50000})
             ->Args({2, 2});
     }
+
+    // Lookups in very large routing tables, where the memory locality of the search matters most
+    std::initializer_list<benchmark::internal::Benchmark*> largeBmCases{
+        REGISTER_BENCHMARK_CAPTURE(BM_FindIntersectingChunk,
+                                   PessimalLarge,
+                                   makeChunkManagerWithPessimalBalancedDistribution),
+        REGISTER_BENCHMARK_CAPTURE(BM_FindIntersectingChunk,
+                                   OptimalLarge,
+                                   makeChunkManagerWithOptimalBalancedDistribution),
+    };
+
+    for (auto bmCase : largeBmCases) {
+        bmCase->Args({2, 500000})->Args({100, 1000000});
+    }
 }
 
 }  // namespace
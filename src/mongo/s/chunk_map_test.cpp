@@ -165,4 +165,90 @@ TEST_F(ChunkMapTest, TestEnumerateOverlappingChunks) {
     ASSERT_EQ(count, 3);
 }
 
+TEST_F(ChunkMapTest, TestMergeReplacesOnlyOverlappingChunks) {
+    const OID epoch = OID::gen();
+    ChunkMap chunkMap{epoch, boost::none /* timestamp */};
+
+    auto makeChunk = [&](BSONObj min, BSONObj max, uint32_t major) {
+        return std::make_shared<ChunkInfo>(
+            ChunkType{kNss,
+                      ChunkRange{std::move(min), std::move(max)},
+                      ChunkVersion{major, 0, epoch, boost::none /* timestamp */},
+                      kThisShard});
+    };
+
+    chunkMap = chunkMap.createMerged(
+        {makeChunk(getShardKeyPattern().globalMin(), BSON("a" << 0), 1),
+         makeChunk(BSON("a" << 0), BSON("a" << 100), 2),
+         makeChunk(BSON("a" << 100), BSON("a" << 200), 3),
+         makeChunk(BSON("a" << 200), BSON("a" << 300), 4),
+         makeChunk(BSON("a" << 300), getShardKeyPattern().globalMax(), 5)});
+    ASSERT_EQ(chunkMap.size(), 5);
+
+    // Split the second chunk and merge the third and fourth chunk
+    auto newChunkMap =
+        chunkMap.createMerged({makeChunk(BSON("a" << 0), BSON("a" << 50), 6),
+                               makeChunk(BSON("a" << 50), BSON("a" << 100), 7),
+                               makeChunk(BSON("a" << 100), BSON("a" << 300), 8)});
+
+    ASSERT_EQ(newChunkMap.size(), 5);
+    ASSERT_EQ(newChunkMap.getVersion().majorVersion(), 8U);
+
+    std::vector<uint32_t> majorVersions;
+    newChunkMap.forEach([&](const auto& chunkInfo) {
+        majorVersions.push_back(chunkInfo->getLastmod().majorVersion());
+        return true;
+    });
+    ASSERT(majorVersions == std::vector<uint32_t>({1, 6, 7, 8, 5}));
+
+    ASSERT_EQ(newChunkMap.findIntersectingChunk(BSON("a" << 25))->getLastmod().majorVersion(), 6U);
+    ASSERT_EQ(newChunkMap.findIntersectingChunk(BSON("a" << 50))->getLastmod().majorVersion(), 7U);
+    ASSERT_EQ(newChunkMap.findIntersectingChunk(BSON("a" << 250))->getLastmod().majorVersion(), 8U);
+    ASSERT_EQ(newChunkMap.findIntersectingChunk(BSON("a" << 300))->getLastmod().majorVersion(), 5U);
+
+    // The original map is left untouched
+    ASSERT_EQ(chunkMap.findIntersectingChunk(BSON("a" << 250))->getLastmod().majorVersion(), 4U);
+}
+
+TEST_F(ChunkMapTest, TestIntersectingChunkWithCommonKeyPrefix) {
+    const OID epoch = OID::gen();
+    ChunkMap chunkMap{epoch, boost::none /* timestamp */};
+    ChunkVersion version{1, 0, epoch, boost::none /* timestamp */};
+
+    // All bounds share a prefix which is longer than the packed KeyString prefixes of the map
+    const std::string commonPrefix = "aaaaaaaaaaaaaaaaaaaaaaaa";
+    auto key = [&](int i) {
+        return BSON("a" << (commonPrefix + std::to_string(100 + i)));
+    };
+
+    std::vector<std::shared_ptr<ChunkInfo>> chunks;
+    auto lastMax = getShardKeyPattern().globalMin();
+    for (int i = 0; i < 10; ++i) {
+        chunks.push_back(std::make_shared<ChunkInfo>(
+            ChunkType{kNss, ChunkRange{lastMax, key(i * 10)}, version, kThisShard}));
+        lastMax = key(i * 10);
+    }
+    chunks.push_back(std::make_shared<ChunkInfo>(ChunkType{
+        kNss, ChunkRange{lastMax, getShardKeyPattern().globalMax()}, version, kThisShard}));
+
+    auto newChunkMap = chunkMap.createMerged(chunks);
+    ASSERT_EQ(newChunkMap.size(), 11);
+
+    for (int i = 0; i < 90; ++i) {
+        auto intersectingChunk = newChunkMap.findIntersectingChunk(key(i));
+        ASSERT(intersectingChunk);
+        ASSERT(SimpleBSONObjComparator::kInstance.evaluate(intersectingChunk->getMin() ==
+                                                           key(i - i % 10)));
+        ASSERT(SimpleBSONObjComparator::kInstance.evaluate(intersectingChunk->getMax() ==
+                                                           key(i - i % 10 + 10)));
+    }
+
+    int count = 0;
+    newChunkMap.forEachOverlappingChunk(key(15), key(35), false, [&](const auto& chunk) {
+        count++;
+        return true;
+    });
+    ASSERT_EQ(count, 3);
+}
+
 }  // namespace mongo
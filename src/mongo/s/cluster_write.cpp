@@ -38,6 +38,7 @@
 #include "mongo/db/lasterror.h"
 #include "mongo/s/chunk_manager_targeter.h"
 #include "mongo/s/grid.h"
+#include "mongo/s/write_ops/batch_write_coalescer.h"
 
 namespace mongo {
 namespace cluster {
@@ -49,6 +50,23 @@ void write(OperationContext* opCtx,
            boost::optional<OID> targetEpoch) {
     LastError::Disabled disableLastError(&LastError::get(opCtx->getClient()));
 
+    if (!targetEpoch && BatchWriteCoalescer::isEligible(opCtx, request)) {
+        BatchWriteCoalescer::get(opCtx)->executeBatch(
+            opCtx,
+            request,
+            response,
+            stats,
+            [](OperationContext* opCtx,
+               const BatchedCommandRequest& mergedRequest,
+               BatchWriteExecStats* mergedStats,
+               BatchedCommandResponse* mergedResponse) {
+                ChunkManagerTargeter targeter(opCtx, mergedRequest.getNS());
+                BatchWriteExec::executeBatch(
+                    opCtx, targeter, mergedRequest, mergedResponse, mergedStats);
+            });
+        return;
+    }
+
     ChunkManagerTargeter targeter(opCtx, request.getNS(), targetEpoch);
 
     LOGV2_DEBUG_OPTIONS(
@@ -43,7 +43,9 @@
 #include "mongo/db/query/query_feature_flags_gen.h"
 #include "mongo/executor/remote_command_request.h"
 #include "mongo/executor/remote_command_response.h"
+#include "mongo/logv2/log.h"
 #include "mongo/s/catalog/type_shard.h"
+#include "mongo/s/query/cluster_query_knobs_gen.h"
 #include "mongo/util/assert_util.h"
 
 namespace mongo {
@@ -363,7 +365,7 @@ StatusWith<ClusterQueryResult> AsyncResultsMerger::nextReady() {
     return _params.getSort() ? _nextReadySorted(lk) : _nextReadyUnsorted(lk);
 }
 
-ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock) {
+ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock lk) {
     // Tailable non-awaitData cursors cannot have a sort.
     invariant(_tailableMode != TailableModeEnum::kTailable);
 
@@ -377,14 +379,14 @@ ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock) {
     invariant(!_remotes[smallestRemote].docBuffer.empty());
     invariant(_remotes[smallestRemote].status.isOK());
 
-    ClusterQueryResult front = _remotes[smallestRemote].docBuffer.front();
-    _remotes[smallestRemote].docBuffer.pop();
+    ClusterQueryResult front = _popNextResult(lk, smallestRemote);
 
     // Re-populate the merging queue with the next result from 'smallestRemote', if it has a
     // next result.
     if (!_remotes[smallestRemote].docBuffer.empty()) {
         _mergeQueue.push(smallestRemote);
     }
+    _readAheadIfNeeded(lk, smallestRemote);
 
     // For sorted tailable awaitData cursors, update the high water mark to the document's sort key.
     if (_tailableMode == TailableModeEnum::kTailableAndAwaitData) {
@@ -397,15 +399,14 @@ ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock) {
     return front;
 }
 
-ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock) {
+ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock lk) {
     size_t remotesAttempted = 0;
     while (remotesAttempted < _remotes.size()) {
         // It is illegal to call this method if there is an error received from any shard.
         invariant(_remotes[_gettingFromRemote].status.isOK());
 
         if (_remotes[_gettingFromRemote].hasNext()) {
-            ClusterQueryResult front = _remotes[_gettingFromRemote].docBuffer.front();
-            _remotes[_gettingFromRemote].docBuffer.pop();
+            ClusterQueryResult front = _popNextResult(lk, _gettingFromRemote);
 
             if (_tailableMode == TailableModeEnum::kTailable &&
                 !_remotes[_gettingFromRemote].hasNext()) {
@@ -415,6 +416,7 @@ ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock) {
                 _eofNext = true;
             }
 
+            _readAheadIfNeeded(lk, _gettingFromRemote);
             return front;
         }
 
@@ -428,6 +430,58 @@ ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock) {
     return {};
 }
 
+ClusterQueryResult AsyncResultsMerger::_popNextResult(WithLock, size_t remoteIndex) {
+    auto& remote = _remotes[remoteIndex];
+    ClusterQueryResult front = std::move(remote.docBuffer.front());
+    remote.docBuffer.pop();
+    if (auto obj = front.getResult()) {
+        remote.bufferedBytes -= obj->objsize();
+    }
+    return front;
+}
+
+void AsyncResultsMerger::_readAheadIfNeeded(WithLock lk, size_t remoteIndex) {
+    // Tailable cursors pass their batches through to the client as-is, and awaitData getMores
+    // block on the shard, so there is nothing to gain by reading ahead on them. A getMore in a
+    // session or transaction could still be running on the shard once the client's getMore has
+    // returned, and so hold up or fail the client's next statement or commit.
+    const long long watermarkPercent = internalQueryARMReadAheadWatermarkPercent.load();
+    if (watermarkPercent == 0 || _tailableMode != TailableModeEnum::kNormal ||
+        _params.getSessionId() || _lifecycleState != kAlive || !_opCtx) {
+        return;
+    }
+
+    // A remote whose buffer is already empty is refilled through the regular nextEvent() path.
+    auto& remote = _remotes[remoteIndex];
+    if (!remote.status.isOK() || remote.exhausted() || remote.cbHandle.isValid() ||
+        !remote.hasNext() || remote.lastBatchCount == 0) {
+        return;
+    }
+
+    // The watermark scales with the size of the batches this remote actually returns, so that
+    // small batches are refilled early and large batches are not fetched too eagerly.
+    const long long buffered = remote.docBuffer.size();
+    if (buffered * 100 > remote.lastBatchCount * watermarkPercent) {
+        return;
+    }
+
+    // Assume the next batch will be about as large as the last one, and do not let the bytes held
+    // for this cursor grow past the configured bound.
+    if (remote.bufferedBytes + remote.lastBatchBytes >
+        internalQueryARMReadAheadMaxBufferedBytes.load()) {
+        return;
+    }
+
+    LOGV2_DEBUG(5932900,
+                5,
+                "Reading ahead on remote cursor",
+                "shardId"_attr = remote.shardId,
+                "cursorId"_attr = remote.cursorId,
+                "bufferedDocs"_attr = buffered,
+                "bufferedBytes"_attr = remote.bufferedBytes);
+    remote.status = _askForNextBatch(lk, remoteIndex);
+}
+
 Status AsyncResultsMerger::_askForNextBatch(WithLock, size_t remoteIndex) {
     invariant(_opCtx, "Cannot schedule a getMore without an OperationContext");
     auto& remote = _remotes[remoteIndex];
@@ -732,10 +786,10 @@ void AsyncResultsMerger::_cleanUpFailedBatch(WithLock lk, Status status, size_t
     // the error to the user. In order to avoid polluting the user's error message, we ignore such
     // errors with the expectation that all outstanding cursors will be closed promptly.
     if (_params.getAllowPartialResults() || remote.status == ErrorCodes::ExchangePassthrough) {
-        // Clear the results buffer and cursor id, and set 'partialResultsReturned' if appropriate.
+        // Clear the cursor id, and set 'partialResultsReturned' if appropriate. If the failed
+        // request was a read-ahead, results from earlier batches may still be buffered; those are
+        // valid and the remote may already be on the merge queue, so they are left in place.
         remote.partialResultsReturned = (remote.status != ErrorCodes::ExchangePassthrough);
-        std::queue<ClusterQueryResult> emptyBuffer;
-        std::swap(remote.docBuffer, emptyBuffer);
         remote.status = Status::OK();
         remote.cursorId = 0;
     }
@@ -790,7 +844,10 @@ bool AsyncResultsMerger::_addBatchToBuffer(WithLock lk,
                                            size_t remoteIndex,
                                            const CursorResponse& response) {
     auto& remote = _remotes[remoteIndex];
+    const bool wasBufferEmpty = remote.docBuffer.empty();
     _updateRemoteMetadata(lk, remoteIndex, response);
+    remote.lastBatchCount = 0;
+    remote.lastBatchBytes = 0;
     for (const auto& obj : response.getBatch()) {
         // If there's a sort, we're expecting the remote node to have given us back a sort key.
         if (_params.getSort()) {
@@ -813,11 +870,15 @@ bool AsyncResultsMerger::_addBatchToBuffer(WithLock lk,
         ClusterQueryResult result(obj);
         remote.docBuffer.push(result);
         ++remote.fetchedCount;
+        ++remote.lastBatchCount;
+        remote.lastBatchBytes += obj.objsize();
     }
+    remote.bufferedBytes += remote.lastBatchBytes;
 
     // If we're doing a sorted merge, then we have to make sure to put this remote onto the merge
-    // queue.
-    if (_params.getSort() && !response.getBatch().empty()) {
+    // queue. A remote which still had results buffered when a read-ahead batch arrived is already
+    // on the queue.
+    if (_params.getSort() && wasBufferEmpty && !response.getBatch().empty()) {
         _mergeQueue.push(remoteIndex);
     }
     return true;
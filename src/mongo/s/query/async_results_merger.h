@@ -319,6 +319,14 @@ private:
 
         // If set to 'true', the cursor on this shard has been invalidated.
         bool invalidated = false;
+
+        // Total size in bytes of the documents currently held in 'docBuffer'.
+        long long bufferedBytes = 0;
+
+        // Number of documents and bytes in the most recent batch received from this remote. Used
+        // to size the read-ahead watermark and to estimate the size of the next batch.
+        long long lastBatchCount = 0;
+        long long lastBatchBytes = 0;
     };
 
     class MergingComparator {
@@ -373,6 +381,18 @@ private:
      */
     Status _askForNextBatch(WithLock, size_t remoteIndex);
 
+    /**
+     * Schedules a getMore for the given remote ahead of its buffer being drained, if read-ahead is
+     * enabled and the remote's buffer has dropped below the configured watermark without exceeding
+     * the per-cursor byte bound. See 'internalQueryARMReadAheadWatermarkPercent'.
+     */
+    void _readAheadIfNeeded(WithLock, size_t remoteIndex);
+
+    /**
+     * Pops the next buffered result for the given remote, keeping its byte accounting up to date.
+     */
+    ClusterQueryResult _popNextResult(WithLock, size_t remoteIndex);
+
     /**
      * Checks whether or not the remote cursors are all exhausted.
      */
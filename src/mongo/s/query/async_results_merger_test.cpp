@@ -39,6 +39,7 @@
 #include "mongo/db/query/cursor_response.h"
 #include "mongo/db/query/getmore_command_gen.h"
 #include "mongo/executor/task_executor.h"
+#include "mongo/idl/server_parameter_test_util.h"
 #include "mongo/s/catalog/type_shard.h"
 #include "mongo/s/client/shard_registry.h"
 #include "mongo/s/query/results_merger_test_fixture.h"
@@ -2035,5 +2036,148 @@ TEST_F(AsyncResultsMergerTest, ShouldNotScheduleGetMoresWithoutAnOperationContex
     killFuture.wait();
 }
 
+TEST_F(AsyncResultsMergerTest, ReadAheadSchedulesGetMoreBelowWatermark) {
+    RAIIServerParameterControllerForTest watermark("internalQueryARMReadAheadWatermarkPercent", 50);
+
+    std::vector<BSONObj> firstBatch = {
+        fromjson("{_id: 1}"), fromjson("{_id: 2}"), fromjson("{_id: 3}"), fromjson("{_id: 4}")};
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(makeRemoteCursor(
+        kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, std::move(firstBatch))));
+    auto arm = makeARMFromExistingCursors(std::move(cursors));
+
+    // Three of four documents are still buffered, which is above the watermark.
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(networkHasReadyRequests());
+
+    // Half of the last batch is left, so the next getMore is sent while results remain buffered.
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 2}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(networkHasReadyRequests());
+    ASSERT_EQ(5, getNthPendingRequest(0).cmdObj["getMore"].numberLong());
+
+    std::vector<CursorResponse> responses;
+    std::vector<BSONObj> batch = {fromjson("{_id: 5}"), fromjson("{_id: 6}")};
+    responses.emplace_back(kTestNss, CursorId(0), batch);
+    scheduleNetworkResponses(std::move(responses));
+
+    // The read-ahead batch is appended behind the results which were already buffered.
+    for (int id = 3; id <= 6; ++id) {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_BSONOBJ_EQ(BSON("_id" << id), *unittest::assertGet(arm->nextReady()).getResult());
+    }
+    ASSERT_TRUE(arm->remotesExhausted());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
+TEST_F(AsyncResultsMergerTest, ReadAheadRespectsBufferedBytesLimit) {
+    RAIIServerParameterControllerForTest watermark("internalQueryARMReadAheadWatermarkPercent",
+                                                   100);
+    RAIIServerParameterControllerForTest maxBytes("internalQueryARMReadAheadMaxBufferedBytes", 1);
+
+    std::vector<BSONObj> firstBatch = {fromjson("{_id: 1}"), fromjson("{_id: 2}")};
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(makeRemoteCursor(
+        kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, std::move(firstBatch))));
+    auto arm = makeARMFromExistingCursors(std::move(cursors));
+
+    // The buffer is below the watermark, but another batch would exceed the byte bound.
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(networkHasReadyRequests());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 2}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(networkHasReadyRequests());
+
+    // Once the buffer is drained the getMore is scheduled as usual.
+    ASSERT_FALSE(arm->ready());
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    std::vector<CursorResponse> responses;
+    std::vector<BSONObj> batch = {fromjson("{_id: 3}")};
+    responses.emplace_back(kTestNss, CursorId(0), batch);
+    scheduleNetworkResponses(std::move(responses));
+    executor()->waitForEvent(readyEvent);
+
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 3}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
+TEST_F(AsyncResultsMergerTest, ReadAheadIsNotScheduledForCursorsInSessions) {
+    RAIIServerParameterControllerForTest watermark("internalQueryARMReadAheadWatermarkPercent",
+                                                   100);
+
+    auto runCursor = [&] {
+        std::vector<BSONObj> firstBatch = {fromjson("{_id: 1}"), fromjson("{_id: 2}")};
+        std::vector<RemoteCursor> cursors;
+        cursors.push_back(makeRemoteCursor(kTestShardIds[0],
+                                           kTestShardHosts[0],
+                                           CursorResponse(kTestNss, 5, std::move(firstBatch))));
+        auto arm = makeARMFromExistingCursors(std::move(cursors));
+
+        // A getMore in the session could still be running on the shard after the client's own
+        // getMore has returned, so the buffer is drained before the next batch is requested.
+        ASSERT_BSONOBJ_EQ(fromjson("{_id: 1}"),
+                          *unittest::assertGet(arm->nextReady()).getResult());
+        ASSERT_FALSE(networkHasReadyRequests());
+        ASSERT_BSONOBJ_EQ(fromjson("{_id: 2}"),
+                          *unittest::assertGet(arm->nextReady()).getResult());
+        ASSERT_FALSE(networkHasReadyRequests());
+
+        ASSERT_FALSE(arm->ready());
+        auto readyEvent = unittest::assertGet(arm->nextEvent());
+        std::vector<CursorResponse> responses;
+        responses.emplace_back(kTestNss, CursorId(0), std::vector<BSONObj>{});
+        scheduleNetworkResponses(std::move(responses));
+        executor()->waitForEvent(readyEvent);
+
+        ASSERT_TRUE(arm->ready());
+        ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+    };
+
+    operationContext()->setLogicalSessionId(makeLogicalSessionIdForTest());
+    runCursor();
+
+    operationContext()->setTxnNumber(5);
+    runCursor();
+}
+
+TEST_F(AsyncResultsMergerTest, ReadAheadSortedMergeDoesNotDuplicateBufferedRemote) {
+    RAIIServerParameterControllerForTest watermark("internalQueryARMReadAheadWatermarkPercent", 50);
+
+    BSONObj findCmd = fromjson("{find: 'testcoll', sort: {_id: 1}}");
+    std::vector<BSONObj> firstBatch0 = {fromjson("{$sortKey: [1]}"), fromjson("{$sortKey: [3]}")};
+    std::vector<BSONObj> firstBatch1 = {fromjson("{$sortKey: [2]}"), fromjson("{$sortKey: [4]}")};
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(makeRemoteCursor(kTestShardIds[0],
+                                       kTestShardHosts[0],
+                                       CursorResponse(kTestNss, 5, std::move(firstBatch0))));
+    cursors.push_back(makeRemoteCursor(kTestShardIds[1],
+                                       kTestShardHosts[1],
+                                       CursorResponse(kTestNss, 6, std::move(firstBatch1))));
+    auto arm = makeARMFromExistingCursors(std::move(cursors), findCmd);
+
+    // Each result popped leaves its remote at the watermark, so both remotes read ahead while they
+    // still have a result on the merge queue.
+    ASSERT_BSONOBJ_EQ(fromjson("{$sortKey: [1]}"),
+                      *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_BSONOBJ_EQ(fromjson("{$sortKey: [2]}"),
+                      *unittest::assertGet(arm->nextReady()).getResult());
+
+    std::vector<CursorResponse> responses;
+    std::vector<BSONObj> batch0 = {fromjson("{$sortKey: [5]}")};
+    responses.emplace_back(kTestNss, CursorId(0), batch0);
+    std::vector<BSONObj> batch1 = {fromjson("{$sortKey: [6]}")};
+    responses.emplace_back(kTestNss, CursorId(0), batch1);
+    scheduleNetworkResponses(std::move(responses));
+
+    for (int key = 3; key <= 6; ++key) {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_BSONOBJ_EQ(BSON("$sortKey" << BSON_ARRAY(key)),
+                          *unittest::assertGet(arm->nextReady()).getResult());
+    }
+    ASSERT_TRUE(arm->remotesExhausted());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
 }  // namespace
 }  // namespace mongo
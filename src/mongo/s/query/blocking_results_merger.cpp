@@ -66,6 +66,16 @@ StatusWith<stdx::cv_status> BlockingResultsMerger::doWaiting(
         CurOp::get(opCtx)->startRemoteOpWaitTimer();
         ON_BLOCK_EXIT([&] { CurOp::get(opCtx)->stopRemoteOpWaitTimer(); });
 
+        // Always account the wait as merger stall time, so that slow query logs and $currentOp
+        // show how long this operation was starved for remote results.
+        const auto stallStart = CurOp::get(opCtx)->elapsedTimeTotal();
+        ON_BLOCK_EXIT([&] {
+            const auto stall =
+                std::max(CurOp::get(opCtx)->elapsedTimeTotal() - stallStart, Microseconds{0});
+            stdx::lock_guard<Client> lk(*opCtx->getClient());
+            CurOp::get(opCtx)->debug().mergerStallTime += stall;
+        });
+
         // This shouldn't throw, but we cannot enforce that.
         result = waitFn();
     } catch (const DBException&) {
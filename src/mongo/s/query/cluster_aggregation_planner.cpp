@@ -370,6 +370,8 @@ BSONObj establishMergingMongosCursor(OperationContext* opCtx,
     return replyBuilder.releaseBody();
 }
 
+}  // namespace
+
 DispatchShardPipelineResults dispatchExchangeConsumerPipeline(
     const boost::intrusive_ptr<ExpressionContext>& expCtx,
     const NamespaceString& executionNss,
@@ -386,6 +388,21 @@ DispatchShardPipelineResults dispatchExchangeConsumerPipeline(
     // For all consumers construct a request with appropriate cursor ids and send to shards.
     std::vector<std::pair<ShardId, BSONObj>> requests;
     auto numConsumers = shardDispatchResults->exchangeSpec->consumerShards.size();
+
+    // The consumers run either the whole merge pipeline or only its leading stages, in which case
+    // the remaining stages are run by the regular merger over the union of the consumers' output.
+    // Those stages are moved out of the original merge pipeline rather than shared with it, since
+    // that pipeline disposes of its stages when it is destroyed.
+    auto oldMergePipeline = shardDispatchResults->splitPipeline->mergePipeline.get();
+    const auto numConsumerStages = shardDispatchResults->exchangeSpec->numConsumerStages.value_or(
+        oldMergePipeline->getSources().size());
+    invariant(numConsumerStages <= oldMergePipeline->getSources().size());
+    Pipeline::SourceContainer remainingSources;
+    while (oldMergePipeline->getSources().size() > numConsumerStages) {
+        remainingSources.push_front(oldMergePipeline->popBack());
+    }
+    const Pipeline::SourceContainer consumerSources = oldMergePipeline->getSources();
+
     std::vector<SplitPipeline> consumerPipelines;
     for (size_t idx = 0; idx < numConsumers; ++idx) {
         // Pick this consumer's cursors from producers.
@@ -396,8 +413,7 @@ DispatchShardPipelineResults dispatchExchangeConsumerPipeline(
         }
 
         // Create a pipeline for a consumer and add the merging stage.
-        auto consumerPipeline = Pipeline::create(
-            shardDispatchResults->splitPipeline->mergePipeline->getSources(), expCtx);
+        auto consumerPipeline = Pipeline::create(consumerSources, expCtx);
 
         sharded_agg_helpers::addMergeCursorsSource(
             consumerPipeline.get(),
@@ -432,9 +448,10 @@ DispatchShardPipelineResults dispatchExchangeConsumerPipeline(
         ownedCursors.emplace_back(OwnedRemoteCursor(opCtx, std::move(cursor), executionNss));
     }
 
-    // The merging pipeline is just a union of the results from each of the shards involved on the
-    // consumer side of the exchange.
-    auto mergePipeline = Pipeline::create({}, expCtx);
+    // The merging pipeline is a union of the results from each of the shards involved on the
+    // consumer side of the exchange, followed by any stages the consumers did not run.
+    const bool consumersRunWholePipeline = remainingSources.empty();
+    auto mergePipeline = Pipeline::create(std::move(remainingSources), expCtx);
     mergePipeline->setSplitState(Pipeline::SplitState::kSplitForMerge);
 
     SplitPipeline splitPipeline{nullptr, std::move(mergePipeline), boost::none};
@@ -446,7 +463,8 @@ DispatchShardPipelineResults dispatchExchangeConsumerPipeline(
             static_cast<DocumentSourceMergeCursors*>(pipeline.shardsPipeline->peekFront());
         mergeCursors->dismissCursorOwnership();
     }
-    return DispatchShardPipelineResults{false,
+    return DispatchShardPipelineResults{!consumersRunWholePipeline &&
+                                            shardDispatchResults->needsPrimaryShardMerge,
                                         std::move(ownedCursors),
                                         {},
                                         std::move(splitPipeline),
@@ -455,6 +473,8 @@ DispatchShardPipelineResults dispatchExchangeConsumerPipeline(
                                         numConsumers};
 }
 
+namespace {
+
 ClusterClientCursorGuard convertPipelineToRouterStages(
     std::unique_ptr<Pipeline, PipelineDeleter> pipeline, ClusterClientCursorParams&& cursorParams) {
     auto* opCtx = pipeline->getContext()->opCtx;
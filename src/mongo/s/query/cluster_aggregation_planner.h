@@ -32,6 +32,7 @@
 #include <memory>
 
 #include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/pipeline/sharded_agg_helpers.h"
 #include "mongo/s/chunk_manager.h"
 #include "mongo/s/query/cluster_aggregate.h"
 #include "mongo/s/query/cluster_client_cursor_guard.h"
@@ -51,6 +52,18 @@ ClusterClientCursorGuard buildClusterCursor(OperationContext* opCtx,
                                             std::unique_ptr<Pipeline, PipelineDeleter> pipeline,
                                             ClusterClientCursorParams&&);
 
+/**
+ * Sends the consumer half of an $exchange to the consumer shards named in the exchange spec of
+ * 'shardDispatchResults', handing each consumer its share of the producer cursors. The stages of
+ * the merge pipeline which the consumers do not run are moved into the merge pipeline of the
+ * returned results, which merges the consumers' cursors.
+ */
+sharded_agg_helpers::DispatchShardPipelineResults dispatchExchangeConsumerPipeline(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    const NamespaceString& executionNss,
+    Document serializedCommand,
+    sharded_agg_helpers::DispatchShardPipelineResults* shardDispatchResults);
+
 /**
  *  Returns the "collation" and "uuid" for the collection given by "nss" with the following
  *  semantics:
@@ -34,11 +34,15 @@
 #include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_merge.h"
+#include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/document_source_out.h"
 #include "mongo/db/pipeline/document_source_project.h"
 #include "mongo/db/pipeline/document_source_sort.h"
 #include "mongo/db/pipeline/sharded_agg_helpers.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/idl/server_parameter_test_util.h"
 #include "mongo/s/catalog/type_shard.h"
+#include "mongo/s/query/cluster_aggregation_planner.h"
 #include "mongo/s/query/sharded_agg_test_fixture.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/scopeguard.h"
@@ -609,5 +613,166 @@ TEST_F(ClusterExchangeTest, CompoundShardKeyThreeShards) {
     future.default_timed_get();
 }
 
+TEST_F(ClusterExchangeTest, GroupMergeIsNotExchangedByDefault) {
+    const std::set<ShardId> shardIds{ShardId("0"), ShardId("1")};
+    auto mergePipe = Pipeline::create(
+        {parseStage("{$group: {_id: '$x', count: {$sum: '$count'}, $doingMerge: true}}")},
+        expCtx());
+    ASSERT_FALSE(sharded_agg_helpers::checkIfEligibleForGroupExchange(mergePipe.get(), shardIds));
+}
+
+TEST_F(ClusterExchangeTest, GroupMergeIsNotExchangedWithoutMultipleShardsOrLeadingMergingGroup) {
+    RAIIServerParameterControllerForTest enableGroupExchange{
+        "internalQueryEnableGroupMergeExchange", true};
+
+    auto mergePipe = Pipeline::create(
+        {parseStage("{$group: {_id: '$x', count: {$sum: '$count'}, $doingMerge: true}}")},
+        expCtx());
+    ASSERT_FALSE(sharded_agg_helpers::checkIfEligibleForGroupExchange(mergePipe.get(),
+                                                                      {ShardId("0")}));
+
+    const std::set<ShardId> shardIds{ShardId("0"), ShardId("1")};
+    mergePipe = Pipeline::create({DocumentSourceLimit::create(expCtx(), 1),
+                                  parseStage("{$group: {_id: '$x', $doingMerge: true}}")},
+                                 expCtx());
+    ASSERT_FALSE(sharded_agg_helpers::checkIfEligibleForGroupExchange(mergePipe.get(), shardIds));
+
+    mergePipe = Pipeline::create({parseStage("{$group: {_id: '$x'}}")}, expCtx());
+    ASSERT_FALSE(sharded_agg_helpers::checkIfEligibleForGroupExchange(mergePipe.get(), shardIds));
+}
+
+TEST_F(ClusterExchangeTest, GroupMergeIsHashPartitionedAcrossTargetedShards) {
+    RAIIServerParameterControllerForTest enableGroupExchange{
+        "internalQueryEnableGroupMergeExchange", true};
+
+    const std::set<ShardId> shardIds{ShardId("0"), ShardId("1"), ShardId("2")};
+    auto mergePipe = Pipeline::create(
+        {parseStage("{$group: {_id: '$x', count: {$sum: '$count'}, $doingMerge: true}}"),
+         parseStage("{$match: {count: {$gt: 1}}}"),
+         parseStage("{$project: {count: 1}}"),
+         DocumentSourceLimit::create(expCtx(), 10)},
+        expCtx());
+
+    auto exchangeSpec =
+        sharded_agg_helpers::checkIfEligibleForGroupExchange(mergePipe.get(), shardIds);
+    ASSERT_TRUE(exchangeSpec);
+    ASSERT(exchangeSpec->exchangeSpec.getPolicy() == ExchangePolicyEnum::kKeyRange);
+    ASSERT_BSONOBJ_EQ(exchangeSpec->exchangeSpec.getKey(),
+                      BSON("_id"
+                           << "hashed"));
+    ASSERT_EQ(exchangeSpec->consumerShards.size(), 3UL);  // One for each targeted shard.
+    ASSERT_EQ(exchangeSpec->exchangeSpec.getConsumers(), 3);
+
+    // The $group, $match and $project are run by the consumers, the $limit needs a single stream.
+    ASSERT_TRUE(exchangeSpec->numConsumerStages);
+    ASSERT_EQ(*exchangeSpec->numConsumerStages, 3UL);
+
+    // The hashed key space is split into evenly sized ascending ranges.
+    const auto& boundaries = exchangeSpec->exchangeSpec.getBoundaries().get();
+    const auto& consumerIds = exchangeSpec->exchangeSpec.getConsumerIds().get();
+    ASSERT_EQ(boundaries.size(), 4UL);
+    ASSERT_EQ(consumerIds.size(), 3UL);
+    ASSERT_BSONOBJ_EQ(boundaries[0], BSON("_id" << MINKEY));
+    ASSERT_EQ(boundaries[1]["_id"].type(), BSONType::NumberLong);
+    ASSERT_EQ(boundaries[2]["_id"].type(), BSONType::NumberLong);
+    ASSERT_LT(boundaries[1]["_id"].numberLong(), boundaries[2]["_id"].numberLong());
+    ASSERT_BSONOBJ_EQ(boundaries[3], BSON("_id" << MAXKEY));
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(consumerIds[i], i);
+    }
+}
+
+TEST_F(ClusterExchangeTest, GroupMergeIsNotExchangedWithNonSimpleCollation) {
+    RAIIServerParameterControllerForTest enableGroupExchange{
+        "internalQueryEnableGroupMergeExchange", true};
+
+    expCtx()->setCollator(
+        std::make_unique<CollatorInterfaceMock>(CollatorInterfaceMock::MockType::kToLowerString));
+    const std::set<ShardId> shardIds{ShardId("0"), ShardId("1")};
+    auto mergePipe = Pipeline::create(
+        {parseStage("{$group: {_id: '$x', count: {$sum: '$count'}, $doingMerge: true}}")},
+        expCtx());
+    ASSERT_FALSE(sharded_agg_helpers::checkIfEligibleForGroupExchange(mergePipe.get(), shardIds));
+}
+
+
+TEST_F(ClusterExchangeTest, DispatchedGroupExchangeMovesStagesAfterTheMergeToTheMerger) {
+    RAIIServerParameterControllerForTest enableGroupExchange{
+        "internalQueryEnableGroupMergeExchange", true};
+    setupNShards(2);
+
+    const std::set<ShardId> shardIds{ShardId("0"), ShardId("1")};
+    auto limit = DocumentSourceLimit::create(expCtx(), 10);
+    auto mock = DocumentSourceMock::createForTest(expCtx());
+    auto mergePipe = Pipeline::create(
+        {parseStage("{$group: {_id: '$x', count: {$sum: '$count'}, $doingMerge: true}}"),
+         limit,
+         mock},
+        expCtx());
+    auto exchangeSpec =
+        sharded_agg_helpers::checkIfEligibleForGroupExchange(mergePipe.get(), shardIds);
+    ASSERT_TRUE(exchangeSpec);
+    ASSERT_EQ(*exchangeSpec->numConsumerStages, 1UL);
+
+    // A single producer with one cursor for each consumer.
+    std::vector<OwnedRemoteCursor> producerCursors;
+    for (int i = 0; i < 2; ++i) {
+        RemoteCursor remoteCursor;
+        remoteCursor.setShardId(ShardId("0"));
+        remoteCursor.setHostAndPort(HostAndPort("Host0:12345"));
+        remoteCursor.setCursorResponse(CursorResponse(kTestAggregateNss, CursorId(i + 1), {}));
+        producerCursors.emplace_back(
+            operationContext(), std::move(remoteCursor), kTestAggregateNss);
+    }
+    sharded_agg_helpers::DispatchShardPipelineResults shardDispatchResults{
+        true,
+        std::move(producerCursors),
+        {},
+        sharded_agg_helpers::SplitPipeline(nullptr, std::move(mergePipe), boost::none),
+        nullptr,
+        BSONObj(),
+        1,
+        std::move(exchangeSpec)};
+
+    auto future = launchAsync([&] {
+        auto consumerResults = cluster_aggregation_planner::dispatchExchangeConsumerPipeline(
+            expCtx(),
+            kTestAggregateNss,
+            Document{{"aggregate", kTestAggregateNss.coll()}},
+            &shardDispatchResults);
+        ASSERT_EQ(consumerResults.remoteCursors.size(), 2UL);
+        ASSERT_TRUE(consumerResults.needsPrimaryShardMerge);
+
+        // The stages the consumers do not run now belong to the merger alone.
+        const auto& mergeSources = consumerResults.splitPipeline->mergePipeline->getSources();
+        ASSERT_EQ(mergeSources.size(), 2UL);
+        ASSERT_EQ(mergeSources.front(), limit);
+        ASSERT_EQ(mergeSources.back(), mock);
+        ASSERT_EQ(shardDispatchResults.splitPipeline->mergePipeline->getSources().size(), 1UL);
+
+        // Replacing the original results, as the planner does, must not dispose of them.
+        shardDispatchResults = std::move(consumerResults);
+        ASSERT_FALSE(mock->isDisposed);
+
+        for (auto&& cursor : shardDispatchResults.remoteCursors) {
+            cursor.releaseCursor();
+        }
+    });
+
+    for (int i = 0; i < 2; ++i) {
+        onCommandForPoolExecutor([&](const executor::RemoteCommandRequest& request) {
+            // Each consumer merges its producer cursor and runs only the merging $group.
+            auto pipeline = request.cmdObj["pipeline"].Array();
+            ASSERT_EQ(pipeline.size(), 2UL);
+            ASSERT_EQ(pipeline[0].Obj().firstElementFieldNameStringData(), "$mergeCursors");
+            ASSERT_EQ(pipeline[1].Obj().firstElementFieldNameStringData(), "$group");
+            return CursorResponse(kTestAggregateNss, CursorId(10 + i), {})
+                .toBSON(CursorResponse::ResponseType::InitialResponse);
+        });
+    }
+
+    future.default_timed_get();
+}
+
 }  // namespace
 }  // namespace mongo
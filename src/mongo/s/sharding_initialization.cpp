@@ -169,6 +169,7 @@ Status initializeGlobalShardingState(OperationContext* opCtx,
     connPoolOptions.controllerFactory = []() noexcept {
         return std::make_shared<ShardingTaskExecutorPoolController>();
     };
+    connPoolOptions.maxRequestsPerConnection = gShardingTaskExecutorPoolMaxRequestsPerConnection;
 
     auto network = executor::makeNetworkInterface(
         "ShardRegistry", std::make_unique<ShardingNetworkConnectionHook>(), hookBuilder());
@@ -33,6 +33,7 @@
 
 #include "mongo/client/replica_set_monitor.h"
 #include "mongo/executor/connection_pool_stats.h"
+#include "mongo/logv2/log.h"
 #include "mongo/s/is_mongos.h"
 #include "mongo/s/sharding_task_executor_pool_controller.h"
 
@@ -135,13 +136,14 @@ void ShardingTaskExecutorPoolController::_addGroup(WithLock,
     emplaceOrInvariant(_groupDatas, state.connStr.getSetName(), std::move(groupData));
 }
 
-void ShardingTaskExecutorPoolController::_removeGroup(WithLock, const std::string& name) {
+auto ShardingTaskExecutorPoolController::_removeGroup(WithLock, const std::string& name)
+    -> std::shared_ptr<GroupData> {
     auto it = _groupDatas.find(name);
     if (it == _groupDatas.end()) {
-        return;
+        return nullptr;
     }
 
-    auto& groupData = it->second;
+    auto groupData = std::move(it->second);
     for (auto& host : groupData->members) {
         auto& groupAndId = getOrInvariant(_groupAndIds, host);
         groupAndId.groupData.reset();
@@ -154,6 +156,44 @@ void ShardingTaskExecutorPoolController::_removeGroup(WithLock, const std::strin
     }
 
     _groupDatas.erase(it);
+    return groupData;
+}
+
+void ShardingTaskExecutorPoolController::_prewarmGroup(WithLock,
+                                                       const GroupData* previous,
+                                                       const std::string& name) {
+    auto& groupData = getOrInvariant(_groupDatas, name);
+    if (previous && previous->members == groupData->members &&
+        previous->primary == groupData->primary) {
+        // Nothing about the topology changed
+        return;
+    }
+
+    LOGV2_DEBUG(5933200,
+                2,
+                "Pre-warming connection pools for replica set members",
+                "replicaSet"_attr = name,
+                "primary"_attr = groupData->primary);
+    groupData->needsWarming = true;
+
+    if (!previous || previous->primary == groupData->primary) {
+        return;
+    }
+
+    // Let the new primary's pool start where the previous primary's pool had grown to, so the
+    // traffic moving to it doesn't queue while the pool ramps up from the minimum
+    auto getPoolData = [&](const HostAndPort& host) -> PoolData* {
+        auto it = _groupAndIds.find(host);
+        if (it == _groupAndIds.end() || !it->second.maybeId) {
+            return nullptr;
+        }
+        return &getOrInvariant(_poolDatas, *it->second.maybeId);
+    };
+    auto previousPrimary = getPoolData(previous->primary);
+    auto primary = getPoolData(groupData->primary);
+    if (previousPrimary && primary) {
+        primary->adaptiveTarget.seed(previousPrimary->target);
+    }
 }
 
 class ShardingTaskExecutorPoolController::ReplicaSetChangeListener final
@@ -169,8 +209,12 @@ public:
     void onConfirmedSet(const State& state) noexcept override {
         stdx::lock_guard lk(_controller->_mutex);
 
-        _controller->_removeGroup(lk, state.connStr.getSetName());
+        const auto& name = state.connStr.getSetName();
+        auto previous = _controller->_removeGroup(lk, name);
         _controller->_addGroup(lk, state);
+        if (gParameters.adaptiveSizing.load()) {
+            _controller->_prewarmGroup(lk, previous.get(), name);
+        }
     }
 
     void onPossibleSet(const State& state) noexcept override {
@@ -224,7 +268,16 @@ auto ShardingTaskExecutorPoolController::updateHost(PoolId id, const HostState&
     const size_t maxConns = gParameters.maxConnections.load();
 
     // Update the target for just the pool first
-    poolData.target = stats.requests + stats.active;
+    if (gParameters.adaptiveSizing.load()) {
+        ConnectionPool::AdaptiveTarget::Parameters params;
+        params.queueTimeTarget = Milliseconds{gParameters.adaptiveQueueTimeTargetMS.load()};
+        params.adjustmentInterval = Milliseconds{gParameters.adaptiveIntervalMS.load()};
+        params.additiveIncrease = gParameters.adaptiveIncrease.load();
+
+        poolData.target = poolData.adaptiveTarget.update(stats, now(), params, minConns, maxConns);
+    } else {
+        poolData.target = stats.requests + stats.active;
+    }
 
     if (poolData.target < minConns) {
         poolData.target = minConns;
@@ -269,7 +322,8 @@ auto ShardingTaskExecutorPoolController::updateHost(PoolId id, const HostState&
         std::all_of(groupData->poolIds.begin(), groupData->poolIds.end(), [&](auto otherId) {
                               return getOrInvariant(_poolDatas, otherId).isAbleToShutdown;
                           });
-    return {groupData->members, shouldShutdown};
+    auto warmHosts = std::exchange(groupData->needsWarming, false);
+    return {groupData->members, shouldShutdown, warmHosts};
 }
 
 void ShardingTaskExecutorPoolController::removeHost(PoolId id) {
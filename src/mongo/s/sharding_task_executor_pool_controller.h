@@ -59,6 +59,11 @@ namespace mongo {
  * When the MatchingStrategy is kMatchBusiestNode, it operates like kMatchPrimaryNode, but any pool
  * can be responsible for increasing the targetConnections of each member of its set.
  *
+ * When adaptiveSizing is enabled, each pool's own target comes from a
+ * ConnectionPool::AdaptiveTarget instead of its current number of requests. Replica set changes
+ * then also pre-warm the set: the pools of its members spawn their connections right away, and a
+ * new primary's pool starts at the size the previous primary's pool had grown to.
+ *
  * Note that, in essence, there are three outside elements that can mutate the state of this class:
  * * The ReplicaSetChangeNotifier can notify the listener which updates the host groups
  * * The ServerParameters can update the Parameters which will used in the next update
@@ -102,6 +107,11 @@ public:
 
         synchronized_value<std::string> matchingStrategyString;
         AtomicWord<MatchingStrategy> matchingStrategy;
+
+        AtomicWord<bool> adaptiveSizing;
+        AtomicWord<int> adaptiveQueueTimeTargetMS;
+        AtomicWord<int> adaptiveIntervalMS;
+        AtomicWord<int> adaptiveIncrease;
     };
 
     static inline Parameters gParameters;
@@ -145,8 +155,16 @@ public:
     void updateConnectionPoolStats(executor::ConnectionPoolStats* cps) const override;
 
 private:
+    struct GroupData;
+
     void _addGroup(WithLock, const ReplicaSetChangeNotifier::State& state);
-    void _removeGroup(WithLock, const std::string& key);
+    std::shared_ptr<GroupData> _removeGroup(WithLock, const std::string& key);
+
+    /**
+     * Marks the group named 'key' to be warmed if it differs from 'previous', and carries the
+     * target of the previous primary's pool over to the new primary's pool.
+     */
+    void _prewarmGroup(WithLock, const GroupData* previous, const std::string& key);
 
     /**
      * GroupData is a shared state for a set of hosts (a replica set).
@@ -173,6 +191,9 @@ private:
 
         // The number of connections that all pools in the group should maintain
         size_t target = 0;
+
+        // Whether the next updateHost() from a pool in the group should warm up all of its members
+        bool needsWarming = false;
     };
 
     /**
@@ -192,6 +213,9 @@ private:
         // The number of connections the host should maintain
         size_t target = 0;
 
+        // Drives the target when adaptiveSizing is enabled
+        executor::ConnectionPool::AdaptiveTarget adaptiveTarget;
+
         // This host is able to shutdown
         bool isAbleToShutdown = false;
     };
@@ -0,0 +1,353 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kSharding
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/write_ops/batch_write_coalescer.h"
+
+#include "mongo/base/counter.h"
+#include "mongo/db/api_parameters.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/service_context.h"
+#include "mongo/logv2/log.h"
+#include "mongo/rpc/metadata/impersonated_user_metadata.h"
+#include "mongo/s/transaction_router.h"
+#include "mongo/s/write_ops/batch_write_coalescer_gen.h"
+#include "mongo/s/write_ops/write_error_detail.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/util/future.h"
+
+namespace mongo {
+namespace {
+
+const auto getBatchWriteCoalescer = ServiceContext::declareDecoration<BatchWriteCoalescer>();
+
+// Tracks the number of merged batches which combined the inserts of more than one request, and the
+// total number of requests which were executed as part of such a batch.
+Counter64 coalescedInsertBatchesCount;
+ServerStatusMetricField<Counter64> coalescedInsertBatchesStats("query.coalescedInsertBatches",
+                                                               &coalescedInsertBatchesCount);
+Counter64 coalescedInsertRequestsCount;
+ServerStatusMetricField<Counter64> coalescedInsertRequestsStats("query.coalescedInsertRequests",
+                                                                &coalescedInsertRequestsCount);
+
+/**
+ * Builds the key which decides whether two batches can be merged. It contains everything apart
+ * from the documents themselves which gets sent along with the child batches to the shards.
+ */
+std::string makeMergeKey(OperationContext* opCtx, const BatchedCommandRequest& request) {
+    BSONObjBuilder builder;
+    builder.append("ns", request.getNS().ns());
+    if (request.hasWriteConcern()) {
+        builder.append("writeConcern", request.getWriteConcern());
+    }
+    builder.append("bypassDocumentValidation", request.getBypassDocumentValidation());
+    APIParameters::get(opCtx).appendInfo(&builder);
+    rpc::writeAuthDataToImpersonatedUserMetadata(opCtx, &builder);
+
+    const auto key = builder.done();
+    return std::string(key.objdata(), key.objsize());
+}
+
+/**
+ * Makes 'client' act on behalf of the same users and roles as the client of 'opCtx', so that the
+ * merged batch is attributed to the shards exactly like the participants' own batches would be.
+ */
+void impersonateUsersOf(OperationContext* opCtx, Client* client) {
+    BSONObjBuilder builder;
+    rpc::writeAuthDataToImpersonatedUserMetadata(opCtx, &builder);
+    const auto obj = builder.done();
+
+    if (const auto elem = obj[rpc::kImpersonationMetadataSectionName]) {
+        const auto metadata = rpc::ImpersonatedUserMetadata::parse(
+            IDLParserErrorContext(rpc::kImpersonationMetadataSectionName), elem.embeddedObject());
+        AuthorizationSession::get(client)->setImpersonatedUserData(metadata.getUsers(),
+                                                                   metadata.getRoles());
+    }
+}
+
+/**
+ * Fills 'response' with the results of the 'count' documents starting at 'offset' of the merged
+ * batch, translating the indexes of the write errors back to the positions in the original request.
+ */
+void extractParticipantResponse(const BatchedCommandResponse& mergedResponse,
+                                size_t offset,
+                                size_t count,
+                                BatchedCommandResponse* response) {
+    if (!mergedResponse.getOk()) {
+        response->setStatus(mergedResponse.getTopLevelStatus());
+        return;
+    }
+
+    response->setStatus(Status::OK());
+
+    size_t numErrors = 0;
+    if (mergedResponse.isErrDetailsSet()) {
+        for (const auto* mergedError : mergedResponse.getErrDetails()) {
+            const auto index = static_cast<size_t>(mergedError->getIndex());
+            if (index < offset || index >= offset + count) {
+                continue;
+            }
+
+            auto error = std::make_unique<WriteErrorDetail>();
+            mergedError->cloneTo(error.get());
+            error->setIndex(index - offset);
+            response->addToErrDetails(error.release());
+            ++numErrors;
+        }
+    }
+
+    // Every insert either succeeded or has a corresponding write error
+    response->setN(count - numErrors);
+
+    if (mergedResponse.isWriteConcernErrorSet()) {
+        auto wcError = std::make_unique<WriteConcernErrorDetail>();
+        mergedResponse.getWriteConcernError()->cloneTo(wcError.get());
+        response->setWriteConcernError(wcError.release());
+    }
+
+    if (mergedResponse.isLastOpSet()) {
+        response->setLastOp(mergedResponse.getLastOp());
+    }
+
+    if (mergedResponse.isElectionIdSet()) {
+        response->setElectionId(mergedResponse.getElectionId());
+    }
+}
+
+}  // namespace
+
+struct BatchWriteCoalescer::MergedBatch {
+    struct Result {
+        BatchedCommandResponse response;
+        BatchWriteExecStats stats;
+    };
+
+    // The documents of all participants, in the order in which they joined
+    std::vector<BSONObj> documents;
+    int sizeBytes{0};
+    int numParticipants{0};
+
+    // Set once the batch no longer accepts new participants, at which point only the leader
+    // accesses the fields above
+    bool sealed{false};
+    stdx::condition_variable sealedCV;
+
+    // Fulfilled by the leader once the merged batch has been executed
+    SharedPromise<std::shared_ptr<const Result>> promise;
+};
+
+BatchWriteCoalescer* BatchWriteCoalescer::get(ServiceContext* serviceContext) {
+    return &getBatchWriteCoalescer(serviceContext);
+}
+
+BatchWriteCoalescer* BatchWriteCoalescer::get(OperationContext* opCtx) {
+    return get(opCtx->getServiceContext());
+}
+
+bool BatchWriteCoalescer::isEligible(OperationContext* opCtx,
+                                     const BatchedCommandRequest& request) {
+    if (gCoalesceUnorderedInsertsWindowMS.load() <= 0) {
+        return false;
+    }
+
+    if (request.getBatchType() != BatchedCommandRequest::BatchType_Insert) {
+        return false;
+    }
+
+    const auto& writeCommandBase = request.getWriteCommandRequestBase();
+    if (writeCommandBase.getOrdered() || writeCommandBase.getStmtId() ||
+        writeCommandBase.getStmtIds()) {
+        return false;
+    }
+
+    if (request.hasShardVersion() || request.hasDbVersion()) {
+        return false;
+    }
+
+    // Retryable writes and transactions rely on the statement ids of the original request
+    if (opCtx->getTxnNumber() || TransactionRouter::get(opCtx)) {
+        return false;
+    }
+
+    // The participants wait for the merged batch without being interruptible, which would not
+    // honour the deadline of the request
+    if (opCtx->hasDeadline()) {
+        return false;
+    }
+
+    return request.sizeWriteOps() <
+        static_cast<size_t>(gCoalesceUnorderedInsertsMaxBatchSize.load());
+}
+
+void BatchWriteCoalescer::executeBatch(OperationContext* opCtx,
+                                       const BatchedCommandRequest& request,
+                                       BatchedCommandResponse* response,
+                                       BatchWriteExecStats* stats,
+                                       const ExecuteBatchFn& executeBatchFn) {
+    const auto& documents = request.getInsertRequest().getDocuments();
+    const auto key = makeMergeKey(opCtx, request);
+    const auto maxBatchSize = static_cast<size_t>(gCoalesceUnorderedInsertsMaxBatchSize.load());
+    const auto maxBatchBytes = gCoalesceUnorderedInsertsMaxBatchBytes.load();
+
+    int requestBytes = 0;
+    for (const auto& doc : documents) {
+        requestBytes += doc.objsize();
+    }
+
+    std::shared_ptr<MergedBatch> batch;
+    bool isLeader = false;
+    size_t offset = 0;
+
+    {
+        stdx::unique_lock<Latch> lk(_mutex);
+
+        auto it = _openBatches.find(key);
+        if (it != _openBatches.end()) {
+            auto openBatch = it->second;
+            if (openBatch->documents.size() + documents.size() <= maxBatchSize &&
+                openBatch->sizeBytes + requestBytes <= maxBatchBytes) {
+                batch = std::move(openBatch);
+            } else {
+                // Dispatch the open batch right away, since it cannot take this request
+                _seal(lk, key, openBatch);
+            }
+        }
+
+        if (!batch) {
+            batch = std::make_shared<MergedBatch>();
+            _openBatches.emplace(key, batch);
+            isLeader = true;
+        }
+
+        // The documents must outlive this request in case it gets interrupted while the leader is
+        // still executing the merged batch
+        offset = batch->documents.size();
+        for (const auto& doc : documents) {
+            batch->documents.push_back(doc.getOwned());
+        }
+        batch->sizeBytes += requestBytes;
+        batch->numParticipants++;
+
+        if (batch->documents.size() >= maxBatchSize || batch->sizeBytes >= maxBatchBytes) {
+            _seal(lk, key, batch);
+        }
+
+        if (isLeader) {
+            // The wait is deliberately not interruptible, because the other participants depend
+            // on the leader to execute their writes. It is bounded by the coalescing window.
+            const auto deadline =
+                Date_t::now() + Milliseconds(gCoalesceUnorderedInsertsWindowMS.load());
+            batch->sealedCV.wait_until(
+                lk, deadline.toSystemTimePoint(), [&] { return batch->sealed; });
+            _seal(lk, key, batch);
+        }
+    }
+
+    if (isLeader) {
+        auto result = std::make_shared<MergedBatch::Result>();
+        const auto numParticipants = batch->numParticipants;
+
+        LOGV2_DEBUG(5932800,
+                    4,
+                    "Executing coalesced insert batch",
+                    "namespace"_attr = request.getNS(),
+                    "numParticipants"_attr = numParticipants,
+                    "size"_attr = batch->documents.size());
+
+        try {
+            write_ops::InsertCommandRequest insertOp(request.getNS());
+            insertOp.setDocuments(std::move(batch->documents));
+            insertOp.setWriteCommandRequestBase([&] {
+                write_ops::WriteCommandRequestBase writeCommandBase;
+                writeCommandBase.setOrdered(false);
+                writeCommandBase.setBypassDocumentValidation(
+                    request.getBypassDocumentValidation());
+                return writeCommandBase;
+            }());
+
+            BatchedCommandRequest mergedRequest(std::move(insertOp));
+            if (request.hasWriteConcern()) {
+                mergedRequest.setWriteConcern(request.getWriteConcern());
+            }
+
+            // The merged batch runs on its own client, so that killOp, a disconnect or the
+            // deadline of the leader's request do not fail the writes of the other participants
+            auto client = opCtx->getServiceContext()->makeClient("BatchWriteCoalescer");
+            impersonateUsersOf(opCtx, client.get());
+
+            AlternativeClientRegion acr(client);
+            auto batchOpCtx = cc().makeOperationContext();
+            APIParameters::get(batchOpCtx.get()) = APIParameters::get(opCtx);
+
+            executeBatchFn(batchOpCtx.get(), mergedRequest, &result->stats, &result->response);
+        } catch (const DBException& ex) {
+            result->response.clear();
+            result->response.setStatus(ex.toStatus());
+        }
+
+        if (numParticipants > 1) {
+            coalescedInsertBatchesCount.increment();
+            coalescedInsertRequestsCount.increment(numParticipants);
+        }
+
+        batch->promise.emplaceValue(std::move(result));
+    }
+
+    // The wait is not interruptible either, since by the time this request gets interrupted its
+    // documents may already have been inserted as part of the merged batch. It is bounded by the
+    // execution of the merged batch, which is not tied to any of the participants.
+    const auto& result = *batch->promise.getFuture().get();
+    extractParticipantResponse(result.response, offset, documents.size(), response);
+    *stats = result.stats;
+}
+
+void BatchWriteCoalescer::_seal(WithLock,
+                                const std::string& key,
+                                const std::shared_ptr<MergedBatch>& batch) {
+    if (batch->sealed) {
+        return;
+    }
+
+    batch->sealed = true;
+
+    auto it = _openBatches.find(key);
+    if (it != _openBatches.end() && it->second == batch) {
+        _openBatches.erase(it);
+    }
+
+    batch->sealedCV.notify_all();
+}
+
+}  // namespace mongo
@@ -0,0 +1,125 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "mongo/platform/mutex.h"
+#include "mongo/s/write_ops/batch_write_exec.h"
+#include "mongo/s/write_ops/batched_command_request.h"
+#include "mongo/s/write_ops/batched_command_response.h"
+#include "mongo/stdx/unordered_map.h"
+#include "mongo/util/concurrency/with_lock.h"
+
+namespace mongo {
+
+class OperationContext;
+class ServiceContext;
+
+/**
+ * The BatchWriteCoalescer merges unordered insert batches which arrive concurrently from different
+ * clients into a single batch write. Thousands of small inserts which would otherwise each be
+ * targeted and dispatched on their own are then sent to the shards as a few large child batches.
+ *
+ * Only batches with identical namespace, write concern, bypassDocumentValidation, API parameters
+ * and impersonated users are merged with each other, so that from the point of view of the shards
+ * the merged batch is indistinguishable from a single client sending all of the documents.
+ *
+ * The first eligible batch for a given key becomes the "leader" and waits for up to
+ * 'coalesceUnorderedInsertsWindowMS' for other batches to join. It then executes the merged batch
+ * and fans the response back out to each participant, with the write error indexes translated
+ * back to the positions in the participant's original request.
+ *
+ * The merged batch executes on a separate client which impersonates the leader's users, so that
+ * interrupting the leader does not fail the other participants. Conversely, a participant which
+ * gets interrupted still waits for the merged batch and reports its actual outcome, because its
+ * documents may already have been inserted.
+ *
+ * Coalescing is disabled by default.
+ */
+class BatchWriteCoalescer {
+    BatchWriteCoalescer(const BatchWriteCoalescer&) = delete;
+    BatchWriteCoalescer& operator=(const BatchWriteCoalescer&) = delete;
+
+public:
+    /**
+     * Function which executes a (possibly merged) batch write, with the same contract as
+     * BatchWriteExec::executeBatch.
+     */
+    using ExecuteBatchFn = std::function<void(OperationContext*,
+                                              const BatchedCommandRequest&,
+                                              BatchWriteExecStats*,
+                                              BatchedCommandResponse*)>;
+
+    BatchWriteCoalescer() = default;
+
+    static BatchWriteCoalescer* get(ServiceContext* serviceContext);
+    static BatchWriteCoalescer* get(OperationContext* opCtx);
+
+    /**
+     * Returns whether coalescing is enabled and 'request' may be merged with the batches of other
+     * clients. Only unordered inserts which are not part of a transaction or a retryable write,
+     * which do not have a deadline and which do not carry explicit statement ids or routing
+     * information are eligible.
+     */
+    static bool isEligible(OperationContext* opCtx, const BatchedCommandRequest& request);
+
+    /**
+     * Executes 'request', which must be eligible for coalescing, as part of a merged batch and
+     * fills 'response' and 'stats' with the part of the merged results which pertain to it. The
+     * stats of the merged batch are reported to every participant.
+     *
+     * This function does not throw, any errors are reported via the response.
+     */
+    void executeBatch(OperationContext* opCtx,
+                      const BatchedCommandRequest& request,
+                      BatchedCommandResponse* response,
+                      BatchWriteExecStats* stats,
+                      const ExecuteBatchFn& executeBatchFn);
+
+private:
+    struct MergedBatch;
+
+    /**
+     * Removes 'batch' from the map of batches which are open for joining, if it is still there.
+     * Must be called with '_mutex' held.
+     */
+    void _seal(WithLock, const std::string& key, const std::shared_ptr<MergedBatch>& batch);
+
+    // Protects the state below
+    Mutex _mutex = MONGO_MAKE_LATCH("BatchWriteCoalescer::_mutex");
+
+    // Batches which are still waiting for their window to expire, keyed by the merge key
+    stdx::unordered_map<std::string, std::shared_ptr<MergedBatch>> _openBatches;
+};
+
+}  // namespace mongo
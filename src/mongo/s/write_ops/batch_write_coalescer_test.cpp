@@ -0,0 +1,256 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/logical_session_id.h"
+#include "mongo/db/service_context_test_fixture.h"
+#include "mongo/idl/server_parameter_test_util.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/s/write_ops/batch_write_coalescer.h"
+#include "mongo/s/write_ops/write_error_detail.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString kNss("TestDB", "TestColl");
+
+BatchedCommandRequest buildInsert(std::vector<BSONObj> docs, bool ordered) {
+    write_ops::InsertCommandRequest insertOp(kNss);
+    insertOp.setDocuments(std::move(docs));
+    insertOp.setWriteCommandRequestBase([&] {
+        write_ops::WriteCommandRequestBase writeCommandBase;
+        writeCommandBase.setOrdered(ordered);
+        return writeCommandBase;
+    }());
+    return BatchedCommandRequest(std::move(insertOp));
+}
+
+/**
+ * Mock batch execution, which reports a write error for every document with a 'fail' field.
+ */
+void executeBatchMock(OperationContext* opCtx,
+                      const BatchedCommandRequest& request,
+                      BatchWriteExecStats* stats,
+                      BatchedCommandResponse* response) {
+    const auto& docs = request.getInsertRequest().getDocuments();
+
+    response->setStatus(Status::OK());
+
+    int numErrors = 0;
+    for (size_t i = 0; i < docs.size(); ++i) {
+        if (docs[i].hasField("fail")) {
+            auto error = std::make_unique<WriteErrorDetail>();
+            error->setStatus({ErrorCodes::DuplicateKey, "mock duplicate key"});
+            error->setIndex(i);
+            response->addToErrDetails(error.release());
+            ++numErrors;
+        }
+    }
+
+    response->setN(docs.size() - numErrors);
+    stats->numRounds = 1;
+}
+
+class BatchWriteCoalescerTest : public ServiceContextTest {
+protected:
+    const ServiceContext::UniqueOperationContext _opCtxHolder{makeOperationContext()};
+    OperationContext* const _opCtx{_opCtxHolder.get()};
+
+    BatchWriteCoalescer _coalescer;
+};
+
+TEST_F(BatchWriteCoalescerTest, DisabledByDefault) {
+    ASSERT_FALSE(BatchWriteCoalescer::isEligible(_opCtx, buildInsert({BSON("x" << 1)}, false)));
+}
+
+TEST_F(BatchWriteCoalescerTest, OnlyUnorderedInsertsAreEligible) {
+    RAIIServerParameterControllerForTest window("coalesceUnorderedInsertsWindowMS", 5);
+
+    ASSERT_TRUE(BatchWriteCoalescer::isEligible(_opCtx, buildInsert({BSON("x" << 1)}, false)));
+    ASSERT_FALSE(BatchWriteCoalescer::isEligible(_opCtx, buildInsert({BSON("x" << 1)}, true)));
+
+    BatchedCommandRequest deleteRequest([&] {
+        write_ops::DeleteCommandRequest deleteOp(kNss);
+        deleteOp.setDeletes({write_ops::DeleteOpEntry(BSON("x" << 1), false /* multi */)});
+        deleteOp.setWriteCommandRequestBase([&] {
+            write_ops::WriteCommandRequestBase writeCommandBase;
+            writeCommandBase.setOrdered(false);
+            return writeCommandBase;
+        }());
+        return deleteOp;
+    }());
+    ASSERT_FALSE(BatchWriteCoalescer::isEligible(_opCtx, deleteRequest));
+}
+
+TEST_F(BatchWriteCoalescerTest, RetryableWritesAreNotEligible) {
+    RAIIServerParameterControllerForTest window("coalesceUnorderedInsertsWindowMS", 5);
+
+    _opCtx->setLogicalSessionId(makeLogicalSessionIdForTest());
+    _opCtx->setTxnNumber(1);
+
+    ASSERT_FALSE(BatchWriteCoalescer::isEligible(_opCtx, buildInsert({BSON("x" << 1)}, false)));
+}
+
+TEST_F(BatchWriteCoalescerTest, RequestsWithDeadlineAreNotEligible) {
+    RAIIServerParameterControllerForTest window("coalesceUnorderedInsertsWindowMS", 5);
+
+    _opCtx->setDeadlineAfterNowBy(Seconds(10), ErrorCodes::MaxTimeMSExpired);
+
+    ASSERT_FALSE(BatchWriteCoalescer::isEligible(_opCtx, buildInsert({BSON("x" << 1)}, false)));
+}
+
+TEST_F(BatchWriteCoalescerTest, BatchesAtMaxSizeAreNotEligible) {
+    RAIIServerParameterControllerForTest window("coalesceUnorderedInsertsWindowMS", 5);
+    RAIIServerParameterControllerForTest maxSize("coalesceUnorderedInsertsMaxBatchSize", 2);
+
+    ASSERT_FALSE(BatchWriteCoalescer::isEligible(
+        _opCtx, buildInsert({BSON("x" << 1), BSON("x" << 2)}, false)));
+}
+
+TEST_F(BatchWriteCoalescerTest, SingleBatchExecutesAfterWindow) {
+    RAIIServerParameterControllerForTest window("coalesceUnorderedInsertsWindowMS", 1);
+
+    auto request = buildInsert({BSON("x" << 1), BSON("x" << 2 << "fail" << true)}, false);
+
+    BatchedCommandResponse response;
+    BatchWriteExecStats stats;
+    _coalescer.executeBatch(_opCtx, request, &response, &stats, executeBatchMock);
+
+    ASSERT_TRUE(response.getOk());
+    ASSERT_EQ(1, response.getN());
+    ASSERT_EQ(1U, response.sizeErrDetails());
+    ASSERT_EQ(1, response.getErrDetailsAt(0)->getIndex());
+    ASSERT_EQ(1, stats.numRounds);
+}
+
+TEST_F(BatchWriteCoalescerTest, ConcurrentBatchesAreMergedAndResponsesSplit) {
+    // The window is long enough that the batch only gets dispatched by reaching its maximum size
+    RAIIServerParameterControllerForTest window("coalesceUnorderedInsertsWindowMS", 1000);
+    RAIIServerParameterControllerForTest maxSize("coalesceUnorderedInsertsMaxBatchSize", 5);
+
+    AtomicWord<int> numExecutions{0};
+    auto executeBatchFn = [&](OperationContext* opCtx,
+                              const BatchedCommandRequest& request,
+                              BatchWriteExecStats* stats,
+                              BatchedCommandResponse* response) {
+        numExecutions.fetchAndAdd(1);
+        ASSERT_EQ(5U, request.sizeWriteOps());
+        ASSERT_FALSE(request.getWriteCommandRequestBase().getOrdered());
+        executeBatchMock(opCtx, request, stats, response);
+    };
+
+    auto requestA = buildInsert({BSON("a" << 1), BSON("a" << 2)}, false);
+    auto requestB =
+        buildInsert({BSON("b" << 1), BSON("b" << 2 << "fail" << true), BSON("b" << 3)}, false);
+
+    BatchedCommandResponse responseA;
+    BatchedCommandResponse responseB;
+
+    auto runParticipant = [&](const BatchedCommandRequest& request,
+                              BatchedCommandResponse* response) {
+        auto client = getServiceContext()->makeClient("participant");
+        auto opCtx = client->makeOperationContext();
+        BatchWriteExecStats stats;
+        _coalescer.executeBatch(opCtx.get(), request, response, &stats, executeBatchFn);
+    };
+
+    stdx::thread threadA([&] { runParticipant(requestA, &responseA); });
+    stdx::thread threadB([&] { runParticipant(requestB, &responseB); });
+    threadA.join();
+    threadB.join();
+
+    ASSERT_EQ(1, numExecutions.load());
+
+    ASSERT_TRUE(responseA.getOk());
+    ASSERT_EQ(2, responseA.getN());
+    ASSERT_FALSE(responseA.isErrDetailsSet());
+
+    ASSERT_TRUE(responseB.getOk());
+    ASSERT_EQ(2, responseB.getN());
+    ASSERT_EQ(1U, responseB.sizeErrDetails());
+    ASSERT_EQ(1, responseB.getErrDetailsAt(0)->getIndex());
+    ASSERT_EQ(ErrorCodes::DuplicateKey, responseB.getErrDetailsAt(0)->toStatus().code());
+}
+
+TEST_F(BatchWriteCoalescerTest, ExecutionErrorIsReportedAsTopLevelError) {
+    RAIIServerParameterControllerForTest window("coalesceUnorderedInsertsWindowMS", 1);
+
+    auto request = buildInsert({BSON("x" << 1)}, false);
+
+    BatchedCommandResponse response;
+    BatchWriteExecStats stats;
+    _coalescer.executeBatch(_opCtx,
+                            request,
+                            &response,
+                            &stats,
+                            [](OperationContext*,
+                               const BatchedCommandRequest&,
+                               BatchWriteExecStats*,
+                               BatchedCommandResponse*) {
+                                uasserted(ErrorCodes::NamespaceNotFound, "mock targeting error");
+                            });
+
+    ASSERT_FALSE(response.getOk());
+    ASSERT_EQ(ErrorCodes::NamespaceNotFound, response.getTopLevelStatus().code());
+}
+
+TEST_F(BatchWriteCoalescerTest, MergedBatchDoesNotExecuteOnTheLeaderOperation) {
+    RAIIServerParameterControllerForTest window("coalesceUnorderedInsertsWindowMS", 1);
+
+    {
+        stdx::lock_guard<Client> lk(*_opCtx->getClient());
+        getServiceContext()->killOperation(lk, _opCtx, ErrorCodes::Interrupted);
+    }
+
+    auto request = buildInsert({BSON("x" << 1)}, false);
+
+    BatchedCommandResponse response;
+    BatchWriteExecStats stats;
+    _coalescer.executeBatch(_opCtx,
+                            request,
+                            &response,
+                            &stats,
+                            [&](OperationContext* opCtx,
+                                const BatchedCommandRequest& request,
+                                BatchWriteExecStats* stats,
+                                BatchedCommandResponse* response) {
+                                ASSERT_NOT_EQUALS(_opCtx, opCtx);
+                                opCtx->checkForInterrupt();
+                                executeBatchMock(opCtx, request, stats, response);
+                            });
+
+    ASSERT_TRUE(response.getOk());
+    ASSERT_EQ(1, response.getN());
+}
+
+}  // namespace
+}  // namespace mongo
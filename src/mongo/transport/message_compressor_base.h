@@ -34,14 +34,19 @@
 #include "mongo/base/string_data.h"
 #include "mongo/platform/atomic_word.h"
 
+#include <memory>
 #include <type_traits>
 
 namespace mongo {
+class BSONObj;
+class BSONObjBuilder;
+
 enum class MessageCompressor : uint8_t {
     kNoop = 0,
     kSnappy = 1,
     kZlib = 2,
     kZstd = 3,
+    kZstdDict = 4,
     kExtended = 255,
 };
 
@@ -89,6 +94,33 @@ public:
      */
     virtual StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) = 0;
 
+    /*
+     * Returns true for compressors which carry state from one message of a session to the next,
+     * such as a streaming context. These are never used directly: a MessageCompressorManager that
+     * negotiates one uses the per-session compressor returned by makeSessionCompressor() for all
+     * the messages of its session, in the order in which they are sent and received.
+     */
+    virtual bool isStateful() const {
+        return false;
+    }
+
+    virtual std::unique_ptr<MessageCompressorBase> makeSessionCompressor() {
+        return nullptr;
+    }
+
+    /*
+     * Called on a server's session compressor once it has been negotiated, to append anything
+     * that the client's session compressor needs to the hello reply.
+     */
+    virtual void appendNegotiationReply(BSONObjBuilder* reply) {}
+
+    /*
+     * Called on a client's session compressor with the hello reply from the server.
+     */
+    virtual Status finishNegotiation(const BSONObj& reply) {
+        return Status::OK();
+    }
+
     /*
      * This returns the number of bytes passed in the input for compressData
      */
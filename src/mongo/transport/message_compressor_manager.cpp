@@ -87,7 +87,11 @@ StatusWith<Message> MessageCompressorManager::compressMessage(
 
     MessageCompressorBase* compressor = nullptr;
     if (compressorId) {
-        compressor = _registry->getCompressor(*compressorId);
+        auto swCompressor = _getCompressor(*compressorId);
+        if (!swCompressor.isOK()) {
+            return swCompressor.getStatus();
+        }
+        compressor = swCompressor.getValue();
         invariant(compressor);
     } else if (!_negotiated.empty()) {
         compressor = _negotiated[0];
@@ -151,11 +155,11 @@ StatusWith<Message> MessageCompressorManager::decompressMessage(const Message& m
     }
     CompressionHeader compressionHeader(&input);
 
-    auto compressor = _registry->getCompressor(compressionHeader.compressorId);
-    if (!compressor) {
-        return {ErrorCodes::InternalError,
-                "Compression algorithm specified in message is not available"};
+    auto swCompressor = _getCompressor(compressionHeader.compressorId);
+    if (!swCompressor.isOK()) {
+        return swCompressor.getStatus();
     }
+    auto compressor = swCompressor.getValue();
 
     if (compressorId) {
         *compressorId = compressor->getId();
@@ -208,6 +212,7 @@ void MessageCompressorManager::clientBegin(BSONObjBuilder* output) {
 
     // We're about to update the compressor list with the negotiation result from the server.
     _negotiated.clear();
+    _sessionCompressors.clear();
 
     auto& compressorList = _registry->getCompressorNames();
     if (compressorList.size() == 0)
@@ -247,6 +252,18 @@ void MessageCompressorManager::clientFinish(const BSONObj& input) {
     for (const auto& e : elem.Obj()) {
         auto algoName = e.checkAndGetStringData();
         auto ret = _registry->getCompressor(algoName);
+        if (ret->isStateful()) {
+            ret = _getOrMakeSessionCompressor(ret);
+            if (auto status = ret->finishNegotiation(input); !status.isOK()) {
+                LOGV2_DEBUG(5933102,
+                            3,
+                            "Skipping compressor {compressor}: {error}",
+                            "Skipping compressor which failed to finish negotiation",
+                            "compressor"_attr = ret->getName(),
+                            "error"_attr = status);
+                continue;
+            }
+        }
         LOGV2_DEBUG(22933,
                     3,
                     "Adding compressor {compressor}",
@@ -280,6 +297,7 @@ void MessageCompressorManager::serverNegotiate(
     // If compression has already been negotiated, then this is a renegotiation, so we should
     // reset the state of the manager.
     _negotiated.clear();
+    _sessionCompressors.clear();
 
     // First we go through all the compressor names that the client has requested support for
     if (clientCompressors->empty()) {
@@ -292,6 +310,9 @@ void MessageCompressorManager::serverNegotiate(
         // If the MessageCompressorRegistry knows about a compressor with that name, then it is
         // valid and we add it to our list of negotiated compressors.
         if ((cur = _registry->getCompressor(curName))) {
+            if (cur->isStateful()) {
+                cur = _getOrMakeSessionCompressor(cur);
+            }
             LOGV2_DEBUG(22937,
                         3,
                         "{compressor} is supported",
@@ -312,13 +333,55 @@ void MessageCompressorManager::serverNegotiate(
     if (_negotiated.empty()) {
         LOGV2_DEBUG(22939, 3, "Could not agree on compressor to use");
     } else {
-        BSONArrayBuilder sub(result->subarrayStart("compression"));
-        for (const auto& algo : _negotiated) {
-            sub << algo->getName();
+        {
+            BSONArrayBuilder sub(result->subarrayStart("compression"));
+            for (const auto& algo : _negotiated) {
+                sub << algo->getName();
+            }
+        }
+        for (const auto& sessionCompressor : _sessionCompressors) {
+            sessionCompressor->appendNegotiationReply(result);
         }
     }
 }
 
+StatusWith<MessageCompressorBase*> MessageCompressorManager::_getCompressor(
+    MessageCompressorId id) const {
+    for (const auto& sessionCompressor : _sessionCompressors) {
+        if (sessionCompressor->getId() == id) {
+            return sessionCompressor.get();
+        }
+    }
+
+    auto compressor = _registry->getCompressor(id);
+    if (!compressor) {
+        return {ErrorCodes::InternalError,
+                "Compression algorithm specified in message is not available"};
+    }
+    if (compressor->isStateful()) {
+        return {ErrorCodes::BadValue,
+                str::stream() << "Compression algorithm " << compressor->getName()
+                              << " was not negotiated on this connection"};
+    }
+    return compressor;
+}
+
+MessageCompressorBase* MessageCompressorManager::_getOrMakeSessionCompressor(
+    MessageCompressorBase* prototype) {
+    invariant(prototype->isStateful());
+
+    for (const auto& sessionCompressor : _sessionCompressors) {
+        if (sessionCompressor->getId() == prototype->getId()) {
+            return sessionCompressor.get();
+        }
+    }
+
+    auto sessionCompressor = prototype->makeSessionCompressor();
+    invariant(sessionCompressor && sessionCompressor->getId() == prototype->getId());
+    _sessionCompressors.push_back(std::move(sessionCompressor));
+    return _sessionCompressors.back().get();
+}
+
 MessageCompressorManager& MessageCompressorManager::forSession(
     const transport::SessionHandle& session) {
     return getForSession(session.get());
@@ -33,6 +33,7 @@
 #include "mongo/transport/message_compressor_base.h"
 #include "mongo/transport/session.h"
 
+#include <memory>
 #include <vector>
 
 namespace mongo {
@@ -124,7 +125,19 @@ public:
     static MessageCompressorManager& forSession(const transport::SessionHandle& session);
 
 private:
+    /*
+     * Returns the compressor to use on this session for 'id': this session's instance of a
+     * stateful compressor, or the process-wide compressor otherwise.
+     */
+    StatusWith<MessageCompressorBase*> _getCompressor(MessageCompressorId id) const;
+
+    /*
+     * Returns this session's instance of the stateful compressor 'prototype', making it if needed.
+     */
+    MessageCompressorBase* _getOrMakeSessionCompressor(MessageCompressorBase* prototype);
+
     std::vector<MessageCompressorBase*> _negotiated;
+    std::vector<std::unique_ptr<MessageCompressorBase>> _sessionCompressors;
     MessageCompressorRegistry* _registry;
 };
 
@@ -43,7 +43,10 @@
 #include "mongo/transport/message_compressor_snappy.h"
 #include "mongo/transport/message_compressor_zlib.h"
 #include "mongo/transport/message_compressor_zstd.h"
+#include "mongo/transport/message_compressor_zstd_dict.h"
+#include "mongo/transport/message_compressor_zstd_dict_gen.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -261,6 +264,145 @@ TEST(ZstdMessageCompressor, Fidelity) {
     checkFidelity(testMessage, std::make_unique<ZstdMessageCompressor>());
 }
 
+TEST(ZstdDictMessageCompressor, Fidelity) {
+    auto testMessage = buildMessage();
+    checkFidelity(testMessage, std::make_unique<ZstdDictMessageCompressor>());
+}
+
+TEST(ZstdDictMessageCompressor, StreamsMessagesWithShippedDictionary) {
+    const auto command = BSON("find"
+                              << "orders"
+                              << "filter" << BSON("status"
+                                                  << "shipped")
+                              << "$db"
+                              << "shop");
+    auto buildCommandMessage = [&] {
+        const auto bufferSize = MsgData::MsgDataHeaderSize + command.objsize();
+        auto buf = SharedBuffer::allocate(bufferSize);
+        MsgData::View view(buf.get());
+        view.setId(123456);
+        view.setResponseToMsgId(0);
+        view.setOperation(dbMsg);
+        view.setLen(bufferSize);
+        memcpy(view.data(), command.objdata(), command.objsize());
+        return Message{buf};
+    };
+
+    // Any bytes make a valid raw content dictionary.
+    auto compressor = std::make_unique<ZstdDictMessageCompressor>();
+    compressor->setDictionary(std::string(command.objdata(), command.objsize()));
+
+    MessageCompressorRegistry registry;
+    registry.setSupportedCompressors({compressor->getName()});
+    registry.registerImplementation(std::move(compressor));
+    registry.finalizeSupportedCompressors().transitional_ignore();
+
+    MessageCompressorManager clientManager(&registry);
+    MessageCompressorManager serverManager(&registry);
+
+    BSONObjBuilder clientOutput;
+    clientManager.clientBegin(&clientOutput);
+    auto clientObj = clientOutput.done();
+    checkNegotiationResult(clientObj, {"zstdDict"});
+
+    BSONObjBuilder serverOutput;
+    serverManager.serverNegotiate(parseBSON(clientObj), &serverOutput);
+    auto serverObj = serverOutput.done();
+    checkNegotiationResult(serverObj, {"zstdDict"});
+    ASSERT_EQ(serverObj[ZstdDictMessageCompressor::kDictionaryField].type(), BinData);
+
+    clientManager.clientFinish(serverObj);
+
+    std::vector<int> compressedSizes;
+    for (int i = 0; i < 3; ++i) {
+        const auto original = buildCommandMessage();
+
+        auto request = assertOk(clientManager.compressMessage(original));
+        ASSERT_EQ(request.operation(), dbCompressed);
+        MessageCompressorId compressorId;
+        auto received = assertOk(serverManager.decompressMessage(request, &compressorId));
+        ASSERT_EQ(received.size(), original.size());
+        ASSERT_EQ(memcmp(received.buf(), original.buf(), original.size()), 0);
+        compressedSizes.push_back(request.size());
+
+        auto reply = assertOk(serverManager.compressMessage(original, &compressorId));
+        auto replyReceived = assertOk(clientManager.decompressMessage(reply));
+        ASSERT_EQ(memcmp(replyReceived.buf(), original.buf(), original.size()), 0);
+    }
+
+    // Later messages refer back to earlier ones on the same connection's stream.
+    ASSERT_LT(compressedSizes[1], compressedSizes[0]);
+    ASSERT_EQ(compressedSizes[2], compressedSizes[1]);
+
+    // A connection which did not negotiate the compressor has no stream to decompress with.
+    MessageCompressorManager otherManager(&registry);
+    auto request = assertOk(clientManager.compressMessage(buildCommandMessage()));
+    ASSERT_NOT_OK(otherManager.decompressMessage(request).getStatus());
+}
+
+TEST(ZstdDictMessageCompressor, FailsEveryMessageAfterTheStreamBreaks) {
+    ZstdDictMessageCompressor compressor;
+    auto sender = compressor.makeSessionCompressor();
+    auto receiver = compressor.makeSessionCompressor();
+    ASSERT_OK(sender->finishNegotiation(BSONObj()));
+    ASSERT_OK(receiver->finishNegotiation(BSONObj()));
+
+    const std::string input(1024, 'x');
+    std::vector<char> compressed(sender->getMaxCompressedSize(input.size()));
+    std::vector<char> decompressed(input.size());
+
+    // Garbage breaks the receiving stream, so a well formed message after it is refused as well.
+    const std::string garbage(64, '\xff');
+    ASSERT_NOT_OK(receiver
+                      ->decompressData(ConstDataRange(garbage.data(), garbage.size()),
+                                       DataRange(decompressed.data(), decompressed.size()))
+                      .getStatus());
+    auto compressedSize = assertOk(
+        sender->compressData(ConstDataRange(input.data(), input.size()),
+                             DataRange(compressed.data(), compressed.size())));
+    ASSERT_NOT_OK(receiver
+                      ->decompressData(ConstDataRange(compressed.data(), compressedSize),
+                                       DataRange(decompressed.data(), decompressed.size()))
+                      .getStatus());
+
+    // A message which cannot be flushed whole leaves part of it in the sending stream, so nothing
+    // more can be sent on it.
+    ASSERT_NOT_OK(sender->compressData(ConstDataRange(input.data(), input.size()),
+                                       DataRange(compressed.data(), 1))
+                      .getStatus());
+    ASSERT_NOT_OK(sender->compressData(ConstDataRange(input.data(), input.size()),
+                                       DataRange(compressed.data(), compressed.size()))
+                      .getStatus());
+}
+
+TEST(ZstdDictMessageCompressor, FailsStreamSetupWithAnInvalidWindowLog) {
+    ZstdDictMessageCompressor compressor;
+    auto sender = compressor.makeSessionCompressor();
+    auto receiver = compressor.makeSessionCompressor();
+    ASSERT_OK(sender->finishNegotiation(BSONObj()));
+    ASSERT_OK(receiver->finishNegotiation(BSONObj()));
+
+    const auto windowLog = gZstdDictCompressorWindowLog;
+    ON_BLOCK_EXIT([&] { gZstdDictCompressorWindowLog = windowLog; });
+    gZstdDictCompressorWindowLog = 5;
+
+    const std::string input(1024, 'x');
+    std::vector<char> output(sender->getMaxCompressedSize(input.size()));
+    ASSERT_NOT_OK(sender->compressData(ConstDataRange(input.data(), input.size()),
+                                       DataRange(output.data(), output.size()))
+                      .getStatus());
+    ASSERT_NOT_OK(receiver
+                      ->decompressData(ConstDataRange(input.data(), input.size()),
+                                       DataRange(output.data(), output.size()))
+                      .getStatus());
+
+    // The streams stay failed, even once the window log would be valid again.
+    gZstdDictCompressorWindowLog = windowLog;
+    ASSERT_NOT_OK(sender->compressData(ConstDataRange(input.data(), input.size()),
+                                       DataRange(output.data(), output.size()))
+                      .getStatus());
+}
+
 TEST(SnappyMessageCompressor, Overflow) {
     checkOverflow(std::make_unique<SnappyMessageCompressor>());
 }
@@ -0,0 +1,353 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/message_compressor_zstd_dict.h"
+
+#include <fstream>
+#include <sstream>
+#include <zstd.h>
+
+#include "mongo/base/init.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/transport/message_compressor_registry.h"
+#include "mongo/transport/message_compressor_zstd_dict_gen.h"
+
+namespace mongo {
+namespace {
+// Flushing part of a continuous stream may add block headers beyond ZSTD_compressBound().
+constexpr size_t kStreamFlushOverheadBytes = 64;
+
+struct CCtxDeleter {
+    void operator()(ZSTD_CCtx* cctx) const {
+        ZSTD_freeCCtx(cctx);
+    }
+};
+
+struct DCtxDeleter {
+    void operator()(ZSTD_DCtx* dctx) const {
+        ZSTD_freeDCtx(dctx);
+    }
+};
+
+struct CDictDeleter {
+    void operator()(ZSTD_CDict* cdict) const {
+        ZSTD_freeCDict(cdict);
+    }
+};
+
+struct DDictDeleter {
+    void operator()(ZSTD_DDict* ddict) const {
+        ZSTD_freeDDict(ddict);
+    }
+};
+
+Status makeZstdError(StringData context, size_t ret) {
+    return {ErrorCodes::BadValue, str::stream() << context << ": " << ZSTD_getErrorName(ret)};
+}
+
+std::string readDictionaryFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    uassert(ErrorCodes::FileOpenFailed,
+            str::stream() << "Could not open zstd compression dictionary " << path,
+            file.is_open());
+
+    std::stringstream contents;
+    contents << file.rdbuf();
+    uassert(ErrorCodes::FileStreamFailed,
+            str::stream() << "Could not read zstd compression dictionary " << path,
+            !file.bad());
+    return contents.str();
+}
+}  // namespace
+
+/**
+ * A dictionary digested once for compression and decompression and shared by all the connections
+ * that use it.
+ */
+class ZstdDictMessageCompressor::Dictionary {
+public:
+    explicit Dictionary(std::string bytes)
+        : _bytes(std::move(bytes)),
+          _cdict(ZSTD_createCDict(_bytes.data(), _bytes.size(), ZSTD_CLEVEL_DEFAULT)),
+          _ddict(ZSTD_createDDict(_bytes.data(), _bytes.size())) {
+        uassert(ErrorCodes::BadValue, "Invalid zstd compression dictionary", _cdict && _ddict);
+    }
+
+    StringData bytes() const {
+        return _bytes;
+    }
+
+    const ZSTD_CDict* cdict() const {
+        return _cdict.get();
+    }
+
+    const ZSTD_DDict* ddict() const {
+        return _ddict.get();
+    }
+
+private:
+    const std::string _bytes;
+    const std::unique_ptr<ZSTD_CDict, CDictDeleter> _cdict;
+    const std::unique_ptr<ZSTD_DDict, DDictDeleter> _ddict;
+};
+
+/**
+ * The compressor for one connection. Messages are compressed as one continuous zstd frame, each
+ * flushed whole so the peer can decompress it as soon as it arrives, and decompressed by a
+ * matching stream, which relies on messages being decompressed in the order they were sent.
+ *
+ * Once either stream fails part way through a message, it no longer matches the peer's, so every
+ * later message on the connection fails too, and the session is ended by the caller.
+ */
+class ZstdDictMessageCompressor::SessionCompressor final : public MessageCompressorBase {
+public:
+    SessionCompressor(ZstdDictMessageCompressor* prototype,
+                      std::shared_ptr<const Dictionary> dictionary)
+        : MessageCompressorBase(MessageCompressor::kZstdDict),
+          _prototype(prototype),
+          _dictionary(std::move(dictionary)) {}
+
+    void appendNegotiationReply(BSONObjBuilder* reply) override {
+        if (_dictionary) {
+            const auto bytes = _dictionary->bytes();
+            reply->appendBinData(kDictionaryField, bytes.size(), BinDataGeneral, bytes.rawData());
+        }
+    }
+
+    Status finishNegotiation(const BSONObj& reply) override {
+        invariant(!_cctx && !_dctx);
+
+        auto elem = reply[kDictionaryField];
+        if (elem.eoo()) {
+            _dictionary.reset();
+            return Status::OK();
+        }
+        if (elem.type() != BinData) {
+            return {ErrorCodes::TypeMismatch,
+                    str::stream() << "'" << kDictionaryField << "' must be BinData"};
+        }
+
+        int length;
+        const char* data = elem.binData(length);
+        try {
+            _dictionary = _prototype->_getPeerDictionary(StringData(data, length));
+        } catch (const DBException& ex) {
+            return ex.toStatus();
+        }
+        return Status::OK();
+    }
+
+    std::size_t getMaxCompressedSize(size_t inputSize) override {
+        return ZSTD_compressBound(inputSize) + kStreamFlushOverheadBytes;
+    }
+
+    StatusWith<std::size_t> compressData(ConstDataRange input, DataRange output) override {
+        if (_failed) {
+            return _failedStatus();
+        }
+        if (!_cctx) {
+            auto status = _makeCompressionStream();
+            if (!status.isOK()) {
+                _failed = true;
+                return status;
+            }
+        }
+
+        ZSTD_inBuffer in{input.data(), input.length(), 0};
+        ZSTD_outBuffer out{const_cast<char*>(output.data()), output.length(), 0};
+        size_t ret = ZSTD_compressStream2(_cctx.get(), &out, &in, ZSTD_e_flush);
+        if (ZSTD_isError(ret)) {
+            _failed = true;
+            return makeZstdError("Could not compress input", ret);
+        }
+        if (ret != 0) {
+            _failed = true;
+            return Status{ErrorCodes::BadValue, "Compressed message does not fit its buffer"};
+        }
+
+        _prototype->counterHitCompress(input.length(), out.pos);
+        return {out.pos};
+    }
+
+    StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) override {
+        if (_failed) {
+            return _failedStatus();
+        }
+        if (!_dctx) {
+            auto status = _makeDecompressionStream();
+            if (!status.isOK()) {
+                _failed = true;
+                return status;
+            }
+        }
+
+        ZSTD_inBuffer in{input.data(), input.length(), 0};
+        ZSTD_outBuffer out{const_cast<char*>(output.data()), output.length(), 0};
+        while (in.pos < in.size) {
+            const auto consumed = in.pos;
+            size_t ret = ZSTD_decompressStream(_dctx.get(), &out, &in);
+            if (ZSTD_isError(ret)) {
+                _failed = true;
+                return makeZstdError("Could not decompress message", ret);
+            }
+            if (in.pos == consumed && out.pos == out.size) {
+                _failed = true;
+                return Status{ErrorCodes::BadValue,
+                              "Decompressed message is larger than its declared size"};
+            }
+        }
+
+        _prototype->counterHitDecompress(input.length(), out.pos);
+        return {out.pos};
+    }
+
+private:
+    Status _makeCompressionStream() {
+        _cctx.reset(ZSTD_createCCtx());
+        if (!_cctx) {
+            return {ErrorCodes::ExceededMemoryLimit, "Could not allocate zstd compression stream"};
+        }
+
+        size_t ret =
+            ZSTD_CCtx_setParameter(_cctx.get(), ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+        if (!ZSTD_isError(ret)) {
+            ret = ZSTD_CCtx_setParameter(
+                _cctx.get(), ZSTD_c_windowLog, gZstdDictCompressorWindowLog);
+        }
+        if (!ZSTD_isError(ret) && _dictionary) {
+            ret = ZSTD_CCtx_refCDict(_cctx.get(), _dictionary->cdict());
+        }
+        if (ZSTD_isError(ret)) {
+            return makeZstdError("Could not set up compression stream", ret);
+        }
+        return Status::OK();
+    }
+
+    Status _makeDecompressionStream() {
+        _dctx.reset(ZSTD_createDCtx());
+        if (!_dctx) {
+            return {ErrorCodes::ExceededMemoryLimit,
+                    "Could not allocate zstd decompression stream"};
+        }
+
+        // Refuse frames whose window would take more memory than our own stream's.
+        size_t ret =
+            ZSTD_DCtx_setParameter(_dctx.get(), ZSTD_d_windowLogMax, gZstdDictCompressorWindowLog);
+        if (!ZSTD_isError(ret) && _dictionary) {
+            ret = ZSTD_DCtx_refDDict(_dctx.get(), _dictionary->ddict());
+        }
+        if (ZSTD_isError(ret)) {
+            return makeZstdError("Could not set up decompression stream", ret);
+        }
+        return Status::OK();
+    }
+
+    static Status _failedStatus() {
+        return {ErrorCodes::BadValue,
+                "zstdDict stream of this connection failed on an earlier message"};
+    }
+
+    ZstdDictMessageCompressor* const _prototype;
+
+    // Declared before the contexts which reference it.
+    std::shared_ptr<const Dictionary> _dictionary;
+
+    // Made on first use, since many connections only ever compress in one direction.
+    std::unique_ptr<ZSTD_CCtx, CCtxDeleter> _cctx;
+    std::unique_ptr<ZSTD_DCtx, DCtxDeleter> _dctx;
+
+    bool _failed = false;
+};
+
+ZstdDictMessageCompressor::ZstdDictMessageCompressor()
+    : MessageCompressorBase(MessageCompressor::kZstdDict) {}
+
+void ZstdDictMessageCompressor::setDictionary(std::string dictionary) {
+    auto digested = std::make_shared<const Dictionary>(std::move(dictionary));
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    _dictionary = std::move(digested);
+}
+
+std::unique_ptr<MessageCompressorBase> ZstdDictMessageCompressor::makeSessionCompressor() {
+    return std::make_unique<SessionCompressor>(this, _getDictionary());
+}
+
+std::size_t ZstdDictMessageCompressor::getMaxCompressedSize(size_t inputSize) {
+    return ZSTD_compressBound(inputSize) + kStreamFlushOverheadBytes;
+}
+
+StatusWith<std::size_t> ZstdDictMessageCompressor::compressData(ConstDataRange input,
+                                                                DataRange output) {
+    return Status{ErrorCodes::BadValue, "zstdDict compression requires a negotiated connection"};
+}
+
+StatusWith<std::size_t> ZstdDictMessageCompressor::decompressData(ConstDataRange input,
+                                                                  DataRange output) {
+    return Status{ErrorCodes::BadValue, "zstdDict compression requires a negotiated connection"};
+}
+
+std::shared_ptr<const ZstdDictMessageCompressor::Dictionary>
+ZstdDictMessageCompressor::_getDictionary() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _dictionary;
+}
+
+std::shared_ptr<const ZstdDictMessageCompressor::Dictionary>
+ZstdDictMessageCompressor::_getPeerDictionary(StringData dictionary) {
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (_lastPeerDictionary && _lastPeerDictionary->bytes() == dictionary) {
+            return _lastPeerDictionary;
+        }
+    }
+
+    auto digested = std::make_shared<const Dictionary>(dictionary.toString());
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    _lastPeerDictionary = digested;
+    return digested;
+}
+
+MONGO_INITIALIZER_GENERAL(ZstdDictMessageCompressorInit,
+                          ("EndStartupOptionHandling"),
+                          ("AllCompressorsRegistered"))
+(InitializerContext* context) {
+    auto compressor = std::make_unique<ZstdDictMessageCompressor>();
+    if (!gZstdDictCompressorDictionaryFile.empty()) {
+        compressor->setDictionary(readDictionaryFile(gZstdDictCompressorDictionaryFile));
+    }
+
+    auto& compressorRegistry = MessageCompressorRegistry::get();
+    compressorRegistry.registerImplementation(std::move(compressor));
+}
+}  // namespace mongo
@@ -0,0 +1,87 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "mongo/platform/mutex.h"
+#include "mongo/transport/message_compressor_base.h"
+
+namespace mongo {
+
+/**
+ * A zstd compressor for connections which send many small messages. Each connection compresses
+ * its messages as one continuous stream, so later messages can refer back to earlier ones, and
+ * the stream is primed with a dictionary which the server ships to the client in the hello
+ * handshake. The dictionary is only ever loaded at startup from 'zstdDictCompressorDictionaryFile':
+ * since it is shipped before authentication, it must not be derived from any connection's traffic.
+ */
+class ZstdDictMessageCompressor final : public MessageCompressorBase {
+public:
+    class Dictionary;
+
+    static constexpr auto kDictionaryField = "compressionDictionary"_sd;
+
+    ZstdDictMessageCompressor();
+
+    /**
+     * Sets the dictionary shipped to the clients of connections negotiated from now on.
+     */
+    void setDictionary(std::string dictionary);
+
+    bool isStateful() const override {
+        return true;
+    }
+
+    std::unique_ptr<MessageCompressorBase> makeSessionCompressor() override;
+
+    std::size_t getMaxCompressedSize(size_t inputSize) override;
+
+    StatusWith<std::size_t> compressData(ConstDataRange input, DataRange output) override;
+
+    StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) override;
+
+private:
+    class SessionCompressor;
+
+    std::shared_ptr<const Dictionary> _getDictionary() const;
+
+    /**
+     * Returns the dictionary a server shipped, sharing it with other connections to that server.
+     */
+    std::shared_ptr<const Dictionary> _getPeerDictionary(StringData dictionary);
+
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("ZstdDictMessageCompressor::_mutex");
+    std::shared_ptr<const Dictionary> _dictionary;
+    std::shared_ptr<const Dictionary> _lastPeerDictionary;
+};
+
+}  // namespace mongo
@@ -0,0 +1,101 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/network_latency_metrics.h"
+
+#include <algorithm>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/service_context.h"
+#include "mongo/platform/bits.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+const auto getNetworkLatencyMetrics = ServiceContext::declareDecoration<NetworkLatencyMetrics>();
+
+}  // namespace
+
+int NetworkLatencyHistogram::getBucket(Microseconds latency) {
+    auto micros = durationCount<Microseconds>(latency);
+    if (micros < 2) {
+        return 0;
+    }
+    return std::min(63 - countLeadingZeros64(static_cast<unsigned long long>(micros)),
+                    kNumBuckets - 1);
+}
+
+void NetworkLatencyHistogram::increment(Microseconds latency) {
+    // Relaxed increments keep the cost on the request path to three atomic adds. The counters are
+    // only read by serverStatus, which tolerates the buckets and totals being slightly skewed.
+    _buckets[getBucket(latency)].fetchAndAddRelaxed(1);
+    _ops.fetchAndAddRelaxed(1);
+    _totalMicros.fetchAndAddRelaxed(durationCount<Microseconds>(latency));
+}
+
+void NetworkLatencyHistogram::append(StringData name, BSONObjBuilder* builder) const {
+    BSONObjBuilder histogramBuilder(builder->subobjStart(name));
+    {
+        BSONArrayBuilder arrayBuilder(histogramBuilder.subarrayStart("histogram"));
+        for (int i = 0; i < kNumBuckets; ++i) {
+            auto count = _buckets[i].loadRelaxed();
+            if (count == 0) {
+                continue;
+            }
+
+            BSONObjBuilder entryBuilder(arrayBuilder.subobjStart());
+            entryBuilder.append("micros", i == 0 ? 0LL : 1LL << i);
+            entryBuilder.append("count", count);
+        }
+    }
+    histogramBuilder.append("latency", _totalMicros.loadRelaxed());
+    histogramBuilder.append("ops", _ops.loadRelaxed());
+}
+
+NetworkLatencyMetrics& NetworkLatencyMetrics::get(ServiceContext* svcCtx) {
+    return getNetworkLatencyMetrics(svcCtx);
+}
+
+void NetworkLatencyMetrics::append(BSONObjBuilder* builder) const {
+    sourceMessage.append("sourceMessage", builder);
+    scheduling.append("scheduling", builder);
+    handleRequest.append("handleRequest", builder);
+    sinkMessage.append("sinkMessage", builder);
+}
+
+void appendNetworkLatencyStats(ServiceContext* svcCtx, BSONObjBuilder* builder) {
+    BSONObjBuilder latencySection(builder->subobjStart("latency"));
+    NetworkLatencyMetrics::get(svcCtx).append(&latencySection);
+}
+
+}  // namespace transport
+}  // namespace mongo
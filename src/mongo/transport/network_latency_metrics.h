@@ -0,0 +1,110 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <array>
+
+#include "mongo/base/string_data.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/duration.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+class ServiceContext;
+
+namespace transport {
+
+/**
+ * A thread-safe histogram of latencies with power-of-two microsecond buckets. Bucket 0 counts
+ * latencies below 2 micros, bucket i (i > 0) counts latencies in [2^i, 2^(i+1)) micros, and the
+ * last bucket also absorbs everything above its lower bound.
+ */
+class NetworkLatencyHistogram {
+public:
+    static constexpr int kNumBuckets = 32;
+
+    void increment(Microseconds latency);
+
+    /**
+     * Appends a subobject named 'name' with the operation count, the total latency, and the
+     * non-empty buckets of the histogram in the same format as the 'opLatencies' histograms.
+     */
+    void append(StringData name, BSONObjBuilder* builder) const;
+
+    static int getBucket(Microseconds latency);
+
+private:
+    std::array<AtomicWord<long long>, kNumBuckets> _buckets{};
+    AtomicWord<long long> _ops;
+    AtomicWord<long long> _totalMicros;
+};
+
+/**
+ * Breaks the time a ServiceStateMachine spends on each request down into the phases of its loop.
+ * Only phases whose duration can be attributed to the server are recorded; see the comments in
+ * service_state_machine.cpp for which transport modes contribute to each phase.
+ */
+class NetworkLatencyMetrics {
+public:
+    static NetworkLatencyMetrics& get(ServiceContext* svcCtx);
+
+    /**
+     * Reading a message off the socket once the session has data available.
+     */
+    NetworkLatencyHistogram sourceMessage;
+
+    /**
+     * Time between handing the next iteration of the loop to the ServiceExecutor and it starting
+     * to run.
+     */
+    NetworkLatencyHistogram scheduling;
+
+    /**
+     * Time spent in ServiceEntryPoint::handleRequest(), which covers ticket acquisition and
+     * execution of the command.
+     */
+    NetworkLatencyHistogram handleRequest;
+
+    /**
+     * Writing the response to the socket.
+     */
+    NetworkLatencyHistogram sinkMessage;
+
+    void append(BSONObjBuilder* builder) const;
+};
+
+/**
+ * Appends the "latency" subsection of the "network" serverStatus section.
+ */
+void appendNetworkLatencyStats(ServiceContext* svcCtx, BSONObjBuilder* builder);
+
+}  // namespace transport
+}  // namespace mongo
@@ -0,0 +1,75 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/transport/network_latency_metrics.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+TEST(NetworkLatencyHistogram, Buckets) {
+    ASSERT_EQ(NetworkLatencyHistogram::getBucket(Microseconds{0}), 0);
+    ASSERT_EQ(NetworkLatencyHistogram::getBucket(Microseconds{1}), 0);
+    ASSERT_EQ(NetworkLatencyHistogram::getBucket(Microseconds{2}), 1);
+    ASSERT_EQ(NetworkLatencyHistogram::getBucket(Microseconds{3}), 1);
+    ASSERT_EQ(NetworkLatencyHistogram::getBucket(Microseconds{1024}), 10);
+    ASSERT_EQ(NetworkLatencyHistogram::getBucket(Microseconds{2047}), 10);
+    ASSERT_EQ(NetworkLatencyHistogram::getBucket(Seconds{1}), 19);
+    ASSERT_EQ(NetworkLatencyHistogram::getBucket(Hours{24}),
+              NetworkLatencyHistogram::kNumBuckets - 1);
+}
+
+TEST(NetworkLatencyHistogram, AppendsNonEmptyBuckets) {
+    NetworkLatencyHistogram histogram;
+    histogram.increment(Microseconds{1});
+    histogram.increment(Microseconds{5});
+    histogram.increment(Microseconds{6});
+    histogram.increment(Microseconds{100});
+
+    BSONObjBuilder builder;
+    histogram.append("sourceMessage", &builder);
+    ASSERT_BSONOBJ_EQ(builder.obj(),
+                      BSON("sourceMessage" << BSON("histogram"
+                                                   << BSON_ARRAY(BSON("micros" << 0LL << "count"
+                                                                               << 1LL)
+                                                                 << BSON("micros" << 4LL << "count"
+                                                                                  << 2LL)
+                                                                 << BSON("micros" << 64LL
+                                                                                  << "count"
+                                                                                  << 1LL))
+                                                   << "latency" << 112LL << "ops" << 4LL)));
+}
+
+}  // namespace
+}  // namespace transport
+}  // namespace mongo
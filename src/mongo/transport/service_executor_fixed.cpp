@@ -37,7 +37,11 @@
 #include "mongo/transport/session.h"
 #include "mongo/transport/transport_layer.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/work_stealing_thread_pool.h"
 #include "mongo/util/fail_point.h"
+#include "mongo/util/numa_placement.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/testing_proctor.h"
 #include "mongo/util/thread_safety_context.h"
 
@@ -67,6 +71,9 @@ struct Handle {
 };
 const auto getHandle = ServiceContext::declareDecoration<Handle>();
 
+// Keeps a pool thread counted against its NUMA node for as long as it lives.
+thread_local NumaPlacement::ThreadBinding numaBinding;
+
 const auto serviceExecutorFixedRegisterer = ServiceContext::ConstructorActionRegisterer{
     "ServiceExecutorFixed", [](ServiceContext* ctx) {
         auto limits = ThreadPool::Limits{};
@@ -135,9 +142,21 @@ ServiceExecutorFixed::ServiceExecutorFixed(ServiceContext* ctx, ThreadPool::Limi
     _options.poolName = "ServiceExecutorFixed";
     _options.onCreateThread = [this](const auto&) {
         _executorContext = std::make_unique<ExecutorThreadContext>(this);
+        if (serviceExecutorNumaPlacement && !fixedServiceExecutorUseThreadPerCore) {
+            numaBinding = NumaPlacement::get().bindCurrentThread();
+        }
     };
 
-    _threadPool = std::make_shared<ThreadPool>(_options);
+    if (fixedServiceExecutorUseThreadPerCore) {
+        WorkStealingThreadPool::Options workStealingOptions;
+        workStealingOptions.poolName = _options.poolName;
+        workStealingOptions.numWorkers = ProcessInfo::getNumAvailableCores();
+        workStealingOptions.pinWorkersToCores = true;
+        workStealingOptions.onCreateThread = _options.onCreateThread;
+        _threadPool = std::make_shared<WorkStealingThreadPool>(std::move(workStealingOptions));
+    } else {
+        _threadPool = std::make_shared<ThreadPool>(_options);
+    }
 }
 
 ServiceExecutorFixed::~ServiceExecutorFixed() {
@@ -160,6 +179,11 @@ void ServiceExecutorFixed::join() noexcept {
         }
     }
 
+    // The reactor has been stopped by the time we reach kStopped.
+    if (_reactorThread.joinable()) {
+        _reactorThread.join();
+    }
+
     // We only can join when we have joined all of our tasks and canceled all of our sessions.  This
     // thread pool doesn't get to refuse work over its lifetime. It's possible that tasks are stiil
     // blocking. If so, we block until they finish here.
@@ -213,7 +237,7 @@ Status ServiceExecutorFixed::start() {
 
     auto reactor = tl->getReactor(TransportLayer::WhichReactor::kIngress);
     invariant(reactor);
-    _threadPool->schedule([this, reactor](Status) {
+    auto runReactor = [this, reactor] {
         {
             // Check to make sure we haven't been shutdown already. Note that there is still a brief
             // race that immediately follows this check. ASIOReactor::stop() is not permanent, thus
@@ -226,7 +250,16 @@ Status ServiceExecutorFixed::start() {
 
         // Start running on the reactor immediately.
         reactor->run();
-    });
+    };
+
+    if (fixedServiceExecutorUseThreadPerCore) {
+        _reactorThread = stdx::thread([this, runReactor = std::move(runReactor)] {
+            setThreadName(_options.poolName + "-reactor");
+            runReactor();
+        });
+    } else {
+        _threadPool->schedule([runReactor = std::move(runReactor)](Status) { runReactor(); });
+    }
 
     return Status::OK();
 }
@@ -157,7 +157,11 @@ private:
     bool _isJoined = false;
 
     ThreadPool::Options _options;
-    std::shared_ptr<ThreadPool> _threadPool;
+    std::shared_ptr<ThreadPoolInterface> _threadPool;
+
+    // Runs the ingress reactor when the tasks run on a WorkStealingThreadPool, whose fixed set of
+    // workers should not lose one of its members to the reactor for the executor's lifetime.
+    stdx::thread _reactorThread;
 
     struct Waiter {
         SessionHandle session;
@@ -37,6 +37,7 @@
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/service_context_test_fixture.h"
+#include "mongo/idl/server_parameter_test_util.h"
 #include "mongo/logv2/log.h"
 #include "mongo/transport/mock_session.h"
 #include "mongo/transport/service_executor_fixed.h"
@@ -249,6 +250,30 @@ TEST_F(ServiceExecutorFixedFixture, BasicTaskRuns) {
     barrier->countDownAndWait();
 }
 
+TEST_F(ServiceExecutorFixedFixture, ThreadPerCoreRunsScheduledTaskChains) {
+    RAIIServerParameterControllerForTest threadPerCore{"fixedServiceExecutorUseThreadPerCore",
+                                                       true};
+    auto executorHandle = ServiceExecutorHandle();
+    executorHandle.start();
+
+    auto barrier = std::make_shared<unittest::Barrier>(2);
+    AtomicWord<int> tasksToSchedule{100};
+
+    // Each task schedules the next one from its executor thread, which keeps the chain on that
+    // thread's run queue.
+    std::function<void()> chainedTask;
+    chainedTask = [&, barrier, executor = *executorHandle] {
+        if (tasksToSchedule.fetchAndSubtract(1) > 0) {
+            ASSERT_OK(executor->scheduleTask(chainedTask, ServiceExecutor::kEmptyFlags));
+        } else {
+            barrier->countDownAndWait();
+        }
+    };
+
+    ASSERT_OK(executorHandle->scheduleTask(chainedTask, ServiceExecutor::kEmptyFlags));
+    barrier->countDownAndWait();
+}
+
 TEST_F(ServiceExecutorFixedFixture, RecursiveTask) {
     auto executorHandle = ServiceExecutorHandle();
     executorHandle.start();
@@ -40,8 +40,10 @@
 #include "mongo/logv2/log.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/transport/service_executor.h"
+#include "mongo/transport/service_executor_gen.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/debug_util.h"
+#include "mongo/util/numa_placement.h"
 #include "mongo/util/scopeguard.h"
 #include "mongo/util/thread_safety_context.h"
 
@@ -70,6 +72,13 @@ void* runFunc(void* ctx) {
 Status launchServiceWorkerThread(unique_function<void()> task) noexcept {
 
     try {
+        if (transport::serviceExecutorNumaPlacement) {
+            task = [f = std::move(task)]() mutable {
+                auto numaBinding = NumaPlacement::get().bindCurrentThread();
+                f();
+            };
+        }
+
 #if defined(_WIN32)
         stdx::thread([task = std::move(task)]() mutable { task(); }).detach();
 #else
@@ -39,6 +39,7 @@
 #include "mongo/config.h"
 #include "mongo/db/client.h"
 #include "mongo/db/client_strand.h"
+#include "mongo/db/curop.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/query/kill_cursors_gen.h"
 #include "mongo/db/stats/counters.h"
@@ -51,6 +52,7 @@
 #include "mongo/stdx/thread.h"
 #include "mongo/transport/message_compressor_base.h"
 #include "mongo/transport/message_compressor_manager.h"
+#include "mongo/transport/network_latency_metrics.h"
 #include "mongo/transport/service_entry_point.h"
 #include "mongo/transport/service_executor_synchronous.h"
 #include "mongo/transport/session.h"
@@ -209,6 +211,8 @@ public:
         : _state{State::Created},
           _serviceContext{client->getServiceContext()},
           _sep{_serviceContext->getServiceEntryPoint()},
+          _tickSource{_serviceContext->getTickSource()},
+          _latencyMetrics{NetworkLatencyMetrics::get(_serviceContext)},
           _clientStrand{ClientStrand::make(std::move(client))} {}
 
     ~Impl() {
@@ -275,6 +279,12 @@ public:
      */
     void cleanupExhaustResources() noexcept;
 
+    /*
+     * Hands the next iteration of the loop to the executor, either once the session has data
+     * available or, for exhaust, right away.
+     */
+    void scheduleNewLoop();
+
     /*
      * Gets the current state of connection for testing/diagnostic purposes.
      */
@@ -301,6 +311,8 @@ private:
 
     ServiceContext* const _serviceContext;
     ServiceEntryPoint* const _sep;
+    TickSource* const _tickSource;
+    NetworkLatencyMetrics& _latencyMetrics;
 
     ClientStrandPtr _clientStrand;
     std::function<void()> _cleanupHook;
@@ -310,6 +322,13 @@ private:
     Message _inMessage;
     Message _outMessage;
 
+    // Latency breakdown of the current iteration of the loop. '_scheduledAt' is zero when the
+    // time until startNewLoop() runs includes waiting on the client, and so isn't attributable to
+    // the executor.
+    TickSource::Tick _scheduledAt = 0;
+    Microseconds _sourceMessageTime{0};
+    Microseconds _schedulingDelay{0};
+
     ServiceContext::UniqueOperationContext _opCtx;
 };
 
@@ -324,6 +343,9 @@ Future<void> ServiceStateMachine::Impl::sourceMessage() {
     // for compressing the sink message.
     _compressorId = boost::none;
 
+    // A synchronous read blocks until the client sends its next request, so only asynchronous
+    // sessions, which start sourcing once data is available, have a meaningful read time.
+    TickSource::Tick sourceStart = 0;
     auto sourceMsgImpl = [&] {
         const auto& transportMode = executor()->transportMode();
         if (transportMode == transport::Mode::kSynchronous) {
@@ -331,18 +353,27 @@ Future<void> ServiceStateMachine::Impl::sourceMessage() {
             return Future<Message>::makeReady(session()->sourceMessage());
         } else {
             invariant(transportMode == transport::Mode::kAsynchronous);
+            sourceStart = _tickSource->getTicks();
             return session()->asyncSourceMessage();
         }
     };
 
-    return sourceMsgImpl().onCompletion([this](StatusWith<Message> msg) -> Future<void> {
-        if (msg.isOK()) {
-            _inMessage = std::move(msg.getValue());
-            invariant(!_inMessage.empty());
-        }
-        sourceCallback(msg.getStatus());
-        return Status::OK();
-    });
+    auto sourced = sourceMsgImpl();
+    return std::move(sourced).onCompletion(
+        [this, sourceStart](StatusWith<Message> msg) -> Future<void> {
+            if (msg.isOK()) {
+                _inMessage = std::move(msg.getValue());
+                invariant(!_inMessage.empty());
+
+                if (sourceStart) {
+                    _sourceMessageTime =
+                        _tickSource->ticksTo<Microseconds>(_tickSource->getTicks() - sourceStart);
+                    _latencyMetrics.sourceMessage.increment(_sourceMessageTime);
+                }
+            }
+            sourceCallback(msg.getStatus());
+            return Status::OK();
+        });
 }
 
 Future<void> ServiceStateMachine::Impl::sinkMessage() {
@@ -350,6 +381,7 @@ Future<void> ServiceStateMachine::Impl::sinkMessage() {
     invariant(_state.load() == State::Process);
     _state.store(State::SinkWait);
     auto toSink = std::exchange(_outMessage, {});
+    auto sinkStart = _tickSource->getTicks();
 
     auto sinkMsgImpl = [&] {
         const auto& transportMode = executor()->transportMode();
@@ -364,7 +396,11 @@ Future<void> ServiceStateMachine::Impl::sinkMessage() {
         }
     };
 
-    return sinkMsgImpl().onCompletion([this](Status status) {
+    return sinkMsgImpl().onCompletion([this, sinkStart](Status status) {
+        if (status.isOK()) {
+            _latencyMetrics.sinkMessage.increment(
+                _tickSource->ticksTo<Microseconds>(_tickSource->getTicks() - sinkStart));
+        }
         sinkCallback(std::move(status));
         return Status::OK();
     });
@@ -461,10 +497,23 @@ Future<void> ServiceStateMachine::Impl::processMessage() {
         _opCtx->markKillOnClientDisconnect();
     }
 
+    // Both phases precede the operation, so they can be reported alongside it in the slow query
+    // log. The time taken to sink the response is only available in serverStatus.
+    {
+        auto& opDebug = CurOp::get(_opCtx.get())->debug();
+        opDebug.sourceMessageTime = std::exchange(_sourceMessageTime, Microseconds{0});
+        opDebug.schedulingDelay = std::exchange(_schedulingDelay, Microseconds{0});
+    }
+
     // The handleRequest is implemented in a subclass for mongod/mongos and actually all the
     // database work for this request.
+    auto handleStart = _tickSource->getTicks();
     return _sep->handleRequest(_opCtx.get(), _inMessage)
-        .then([this, &compressorMgr = compressorMgr](DbResponse dbresponse) mutable -> void {
+        .then([this, &compressorMgr = compressorMgr, handleStart](
+                  DbResponse dbresponse) mutable -> void {
+            _latencyMetrics.handleRequest.increment(
+                _tickSource->ticksTo<Microseconds>(_tickSource->getTicks() - handleStart));
+
             // opCtx must be killed and delisted here so that the operation cannot show up in
             // currentOp results after the response reaches the client. Destruction of the already
             // killed opCtx is postponed for later (i.e., after completion of the future-chain) to
@@ -537,10 +586,26 @@ void ServiceStateMachine::Impl::start(ServiceExecutorContext seCtx) {
 
     invariant(_state.swap(State::Source) == State::Created);
 
+    scheduleNewLoop();
+}
+
+void ServiceStateMachine::Impl::scheduleNewLoop() {
     auto cb = [this, anchor = shared_from_this()](Status execStatus) {
         _clientStrand->run([&] { startNewLoop(execStatus); });
     };
-    executor()->runOnDataAvailable(session(), std::move(cb));
+
+    // The synchronous executor runs the callback without waiting for data, so on that path (and
+    // for exhaust) the time until the loop starts is purely the executor's scheduling delay.
+    if (_inExhaust) {
+        // If we're in exhaust, we're not expecting more data.
+        _scheduledAt = _tickSource->getTicks();
+        executor()->schedule(std::move(cb));
+    } else {
+        _scheduledAt = executor()->transportMode() == transport::Mode::kSynchronous
+            ? _tickSource->getTicks()
+            : 0;
+        executor()->runOnDataAvailable(session(), std::move(cb));
+    }
 }
 
 void ServiceStateMachine::Impl::startNewLoop(const Status& execStatus) {
@@ -549,6 +614,12 @@ void ServiceStateMachine::Impl::startNewLoop(const Status& execStatus) {
         return;
     }
 
+    if (auto scheduledAt = std::exchange(_scheduledAt, 0)) {
+        _schedulingDelay =
+            _tickSource->ticksTo<Microseconds>(_tickSource->getTicks() - scheduledAt);
+        _latencyMetrics.scheduling.increment(_schedulingDelay);
+    }
+
     makeReadyFutureWith([&]() -> Future<void> {
         if (_inExhaust) {
             return Status::OK();
@@ -584,17 +655,8 @@ void ServiceStateMachine::Impl::startNewLoop(const Status& execStatus) {
                 return;
             }
 
-            auto cb = [this, anchor = shared_from_this()](Status execStatus) {
-                _clientStrand->run([&] { startNewLoop(execStatus); });
-            };
-
             // Start our loop again with a new stack.
-            if (_inExhaust) {
-                // If we're in exhaust, we're not expecting more data.
-                executor()->schedule(std::move(cb));
-            } else {
-                executor()->runOnDataAvailable(session(), std::move(cb));
-            }
+            scheduleNewLoop();
         });
 }
 
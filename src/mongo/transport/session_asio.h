@@ -38,6 +38,7 @@
 #include "mongo/transport/baton.h"
 #include "mongo/transport/ssl_connection_context.h"
 #include "mongo/transport/transport_layer_asio.h"
+#include "mongo/transport/transport_options_gen.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/net/socket_utils.h"
 #ifdef MONGO_CONFIG_SSL
@@ -79,6 +80,8 @@ class TransportLayerASIO::ASIOSession final : public Session {
     ASIOSession(const ASIOSession&) = delete;
     ASIOSession& operator=(const ASIOSession&) = delete;
 
+    static constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
+
 public:
     using Endpoint = asio::generic::stream_protocol::endpoint;
 
@@ -92,6 +95,11 @@ public:
         : _socket(std::move(socket)),
           _tl(tl),
           _isIngressSession(isIngressSession) {
+        if (auto readAheadSize = gIngressReadAheadBufferSizeBytes.load();
+            _isIngressSession && readAheadSize > 0) {
+            _readAheadBuffer.resize(std::max(size_t(readAheadSize), kHeaderSize));
+        }
+
         auto family = endpointToSockAddr(_socket.local_endpoint()).getType();
         if (family == AF_INET || family == AF_INET6) {
             setSocketOption(_socket, asio::ip::tcp::no_delay(true), "session no delay");
@@ -203,7 +211,7 @@ public:
     Status sinkMessage(Message message) noexcept override try {
         ensureSync();
 
-        return write(asio::buffer(message.buf(), message.size()))
+        return writeMessage(message)
             .then([this, &message] {
                 if (_isIngressSession) {
                     networkCounter.hitPhysicalOut(message.size());
@@ -217,7 +225,7 @@ public:
     Future<void> asyncSinkMessage(Message message,
                                   const BatonHandle& baton = nullptr) noexcept override try {
         ensureAsync();
-        return write(asio::buffer(message.buf(), message.size()), baton)
+        return writeMessage(message, baton)
             .then([this, message /*keep the buffer alive*/]() {
                 if (_isIngressSession) {
                     networkCounter.hitPhysicalOut(message.size());
@@ -444,7 +452,9 @@ private:
     }
 
     Future<Message> sourceMessageImpl(const BatonHandle& baton = nullptr) {
-        static constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
+        if (canReadAhead()) {
+            return sourceMessageWithReadAhead(baton);
+        }
 
         auto headerBuffer = SharedBuffer::allocate(kHeaderSize);
         auto ptr = headerBuffer.get();
@@ -455,19 +465,8 @@ private:
                 }
 
                 const auto msgLen = size_t(MSGHEADER::View(headerBuffer.get()).getMessageLength());
-                if (msgLen < kHeaderSize || msgLen > MaxMessageSizeBytes) {
-                    StringBuilder sb;
-                    sb << "recv(): message msgLen " << msgLen << " is invalid. "
-                       << "Min " << kHeaderSize << " Max: " << MaxMessageSizeBytes;
-                    const auto str = sb.str();
-                    LOGV2(4615638,
-                          "recv(): message msgLen {msgLen} is invalid. Min: {min} Max: {max}",
-                          "recv(): message mstLen is invalid.",
-                          "msgLen"_attr = msgLen,
-                          "min"_attr = kHeaderSize,
-                          "max"_attr = MaxMessageSizeBytes);
-
-                    return Future<Message>::makeReady(Status(ErrorCodes::ProtocolError, str));
+                if (auto status = checkMessageLength(msgLen); !status.isOK()) {
+                    return Future<Message>::makeReady(std::move(status));
                 }
 
                 if (msgLen == kHeaderSize) {
@@ -492,6 +491,147 @@ private:
             });
     }
 
+    Status checkMessageLength(size_t msgLen) {
+        if (msgLen < kHeaderSize || msgLen > MaxMessageSizeBytes) {
+            StringBuilder sb;
+            sb << "recv(): message msgLen " << msgLen << " is invalid. "
+               << "Min " << kHeaderSize << " Max: " << MaxMessageSizeBytes;
+            const auto str = sb.str();
+            LOGV2(4615638,
+                  "recv(): message msgLen {msgLen} is invalid. Min: {min} Max: {max}",
+                  "recv(): message mstLen is invalid.",
+                  "msgLen"_attr = msgLen,
+                  "min"_attr = kHeaderSize,
+                  "max"_attr = MaxMessageSizeBytes);
+
+            return Status(ErrorCodes::ProtocolError, str);
+        }
+        return Status::OK();
+    }
+
+    /**
+     * Read-ahead is only used for plaintext sessions once the first message has decided that no
+     * TLS handshake is coming, since the TLS stream does its own buffering.
+     */
+    bool canReadAhead() const {
+        if (_readAheadBuffer.empty()) {
+            return false;
+        }
+#ifdef MONGO_CONFIG_SSL
+        return !_sslSocket && _ranHandshake;
+#else
+        return true;
+#endif
+    }
+
+    size_t readAheadBuffered() const {
+        return _readAheadEnd - _readAheadBegin;
+    }
+
+    /**
+     * Sources a message through the session's read-ahead buffer. Every read asks the socket for as
+     * much as the buffer can hold, so that a small message usually arrives with its header in one
+     * syscall and pipelined messages behind it are served without touching the socket at all.
+     * Whatever part of a larger message did not arrive with its header is read straight into the
+     * message buffer.
+     */
+    Future<Message> sourceMessageWithReadAhead(const BatonHandle& baton) {
+        return fillReadAhead(kHeaderSize, baton).then([this, baton]() -> Future<Message> {
+            const char* header = _readAheadBuffer.data() + _readAheadBegin;
+            if (checkForHTTPRequest(asio::buffer(header, kHeaderSize))) {
+                return sendHTTPResponse(baton);
+            }
+
+            const auto msgLen = size_t(MSGHEADER::ConstView(header).getMessageLength());
+            if (auto status = checkMessageLength(msgLen); !status.isOK()) {
+                return Future<Message>::makeReady(std::move(status));
+            }
+
+            auto buffer = SharedBuffer::allocate(msgLen);
+            const auto fromReadAhead = std::min(msgLen, readAheadBuffered());
+            memcpy(buffer.get(), header, fromReadAhead);
+            _readAheadBegin += fromReadAhead;
+            if (_readAheadBegin == _readAheadEnd) {
+                _readAheadBegin = _readAheadEnd = 0;
+            }
+
+            auto readRemainder = Future<void>::makeReady();
+            if (fromReadAhead < msgLen) {
+                auto remainder =
+                    asio::buffer(buffer.get() + fromReadAhead, msgLen - fromReadAhead);
+                readRemainder = opportunisticRead(_socket, remainder, baton);
+            }
+
+            return std::move(readRemainder)
+                .then([this, buffer = std::move(buffer), msgLen]() mutable {
+                    if (_isIngressSession) {
+                        networkCounter.hitPhysicalIn(msgLen);
+                    }
+                    return Message(std::move(buffer));
+                });
+        });
+    }
+
+    /**
+     * Reads from the socket until the read-ahead buffer holds at least 'minBytes', taking whatever
+     * else is already available up to the buffer's capacity.
+     */
+    Future<void> fillReadAhead(size_t minBytes, const BatonHandle& baton) {
+        invariant(minBytes <= _readAheadBuffer.size());
+        if (readAheadBuffered() >= minBytes) {
+            return Future<void>::makeReady();
+        }
+
+        if (_readAheadBegin > 0) {
+            memmove(_readAheadBuffer.data(),
+                    _readAheadBuffer.data() + _readAheadBegin,
+                    readAheadBuffered());
+            _readAheadEnd -= _readAheadBegin;
+            _readAheadBegin = 0;
+        }
+
+        auto freeSpace = [this] {
+            return asio::buffer(_readAheadBuffer.data() + _readAheadEnd,
+                                _readAheadBuffer.size() - _readAheadEnd);
+        };
+
+        std::error_code ec;
+        do {
+            _readAheadEnd += asio::read(
+                _socket, freeSpace(), asio::transfer_at_least(minBytes - readAheadBuffered()), ec);
+        } while (ec == asio::error::interrupted &&
+                 readAheadBuffered() < minBytes);  // retry syscall EINTR
+
+        if (readAheadBuffered() >= minBytes) {
+            return Future<void>::makeReady();
+        }
+
+        if (((ec == asio::error::would_block) || (ec == asio::error::try_again)) &&
+            (_blockingMode == Async)) {
+            if (auto networkingBaton = baton ? baton->networking() : nullptr;
+                networkingBaton && networkingBaton->canWait()) {
+                return networkingBaton->addSession(*this, NetworkingBaton::Type::In)
+                    .onError([](Status error) {
+                        if (ErrorCodes::isShutdownError(error)) {
+                            // See opportunisticRead().
+                            return Status::OK();
+                        }
+
+                        return error;
+                    })
+                    .then([this, minBytes, baton] { return fillReadAhead(minBytes, baton); });
+            }
+
+            return asio::async_read(_socket,
+                                    freeSpace(),
+                                    asio::transfer_at_least(minBytes - readAheadBuffered()),
+                                    UseFuture{})
+                .then([this](size_t size) { _readAheadEnd += size; });
+        }
+
+        return futurize(ec);
+    }
+
     template <typename MutableBufferSequence>
     Future<void> read(const MutableBufferSequence& buffers, const BatonHandle& baton = nullptr) {
         // TODO SERVER-47229 Guard active ops for cancellation here.
@@ -518,6 +658,23 @@ private:
         return opportunisticRead(_socket, buffers, baton);
     }
 
+    /**
+     * Writes a message made of several segments (see Message::setSegments()) with a single gather
+     * write, rather than coalescing it into one buffer first.
+     */
+    Future<void> writeMessage(const Message& message, const BatonHandle& baton = nullptr) {
+        if (!message.hasSegments()) {
+            return write(asio::buffer(message.buf(), message.size()), baton);
+        }
+
+        std::vector<asio::const_buffer> buffers;
+        buffers.reserve(message.segments().size());
+        for (const auto& segment : message.segments()) {
+            buffers.emplace_back(segment.data(), segment.length());
+        }
+        return write(buffers, baton);
+    }
+
     template <typename ConstBufferSequence>
     Future<void> write(const ConstBufferSequence& buffers, const BatonHandle& baton = nullptr) {
         // TODO SERVER-47229 Guard active ops for cancellation here.
@@ -640,6 +797,22 @@ private:
     }
 #endif
 
+    template <typename Buffer>
+    static void consumeBuffers(Buffer* buffer, std::size_t size) {
+        *buffer += size;
+    }
+
+    static void consumeBuffers(std::vector<asio::const_buffer>* buffers, std::size_t size) {
+        auto it = buffers->begin();
+        for (; it != buffers->end() && size >= it->size(); ++it) {
+            size -= it->size();
+        }
+        if (it != buffers->end()) {
+            *it += size;
+        }
+        buffers->erase(buffers->begin(), it);
+    }
+
     template <typename Stream, typename ConstBufferSequence>
     Future<void> opportunisticWrite(Stream& stream,
                                     const ConstBufferSequence& buffers,
@@ -649,16 +822,16 @@ private:
 
         if (MONGO_unlikely(transportLayerASIOshortOpportunisticReadWrite.shouldFail()) &&
             _blockingMode == Async) {
-            asio::const_buffer localBuffer = buffers;
+            asio::const_buffer localBuffer = *asio::buffer_sequence_begin(buffers);
 
-            if (buffers.size()) {
-                localBuffer = asio::const_buffer(buffers.data(), 1);
+            if (localBuffer.size()) {
+                localBuffer = asio::const_buffer(localBuffer.data(), 1);
             }
 
             do {
                 size = asio::write(stream, localBuffer, ec);
             } while (ec == asio::error::interrupted);  // retry syscall EINTR
-            if (!ec && buffers.size() > 1) {
+            if (!ec && asio::buffer_size(buffers) > 1) {
                 ec = asio::error::would_block;
             }
         } else {
@@ -675,7 +848,7 @@ private:
             // size is > 0.
             ConstBufferSequence asyncBuffers(buffers);
             if (size > 0) {
-                asyncBuffers += size;
+                consumeBuffers(&asyncBuffers, size);
             }
 
             if (auto more = moreToSend(stream, asyncBuffers, baton)) {
@@ -860,6 +1033,12 @@ private:
 
     TransportLayerASIO* const _tl;
     bool _isIngressSession;
+
+    // Bytes read from the socket ahead of the message currently being sourced live in
+    // [_readAheadBegin, _readAheadEnd). Empty if read-ahead is disabled for this session.
+    std::vector<char> _readAheadBuffer;
+    size_t _readAheadBegin = 0;
+    size_t _readAheadEnd = 0;
 };
 
 }  // namespace transport
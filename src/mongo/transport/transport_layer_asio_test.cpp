@@ -33,6 +33,7 @@
 #include "mongo/transport/transport_layer_asio.h"
 
 #include "mongo/db/server_options.h"
+#include "mongo/idl/server_parameter_test_util.h"
 #include "mongo/logv2/log.h"
 #include "mongo/rpc/op_msg.h"
 #include "mongo/transport/service_entry_point.h"
@@ -273,15 +274,26 @@ public:
     }
 
     void sendMessage() {
-        OpMsgBuilder builder;
-        builder.setBody(BSON("ping" << 1));
-        Message msg = builder.finish();
-        msg.header().setResponseToMsgId(0);
-        msg.header().setId(0);
-        OpMsg::appendChecksum(&msg);
+        sendMessages({BSON("ping" << 1)});
+    }
+
+    /**
+     * Sends one message per body, all in a single write, so that the server sees them pipelined.
+     */
+    void sendMessages(const std::vector<BSONObj>& bodies) {
+        std::string wire;
+        for (auto&& body : bodies) {
+            OpMsgBuilder builder;
+            builder.setBody(body);
+            Message msg = builder.finish();
+            msg.header().setResponseToMsgId(0);
+            msg.header().setId(0);
+            OpMsg::appendChecksum(&msg);
+            wire.append(msg.buf(), msg.size());
+        }
 
         std::error_code ec;
-        asio::write(_sock, asio::buffer(msg.buf(), msg.size()), ec);
+        asio::write(_sock, asio::buffer(wire.data(), wire.size()), ec);
         ASSERT_FALSE(ec);
     }
 
@@ -382,5 +394,58 @@ TEST(TransportLayerASIO, SwitchTimeoutModes) {
     tla->shutdown();
 }
 
+/* check that read-ahead splits pipelined and oversized messages at the right boundaries */
+class ReadAheadSEP : public TimeoutSEP {
+public:
+    explicit ReadAheadSEP(size_t numMessages) : _numMessages(numMessages) {}
+
+    void startSession(transport::SessionHandle session) override {
+        LOGV2(5933000, "Accepted connection", "remote"_attr = session->remote());
+        startWorkerThread([this, session = std::move(session)]() mutable {
+            for (size_t i = 0; i < _numMessages; ++i) {
+                auto swMessage = session->sourceMessage();
+                ASSERT_OK(swMessage.getStatus());
+                received.push_back(OpMsg::parse(swMessage.getValue()).body.getOwned());
+            }
+
+            session.reset();
+            notifyComplete();
+        });
+    }
+
+    // Only safe to read once waitForTimeout() has returned true.
+    std::vector<BSONObj> received;
+
+private:
+    const size_t _numMessages;
+};
+
+TEST(TransportLayerASIO, ReadAheadSourcesPipelinedMessages) {
+    // Smaller than some of the messages below, so that they have to be completed past the buffer.
+    RAIIServerParameterControllerForTest readAheadSize{"ingressReadAheadBufferSizeBytes", 64};
+
+    const std::vector<BSONObj> first{BSON("ping" << 1)};
+    const std::vector<BSONObj> pipelined{BSON("ping" << 2),
+                                         BSON("ping" << 3 << "payload" << std::string(1000, 'x')),
+                                         BSON("ping" << 4),
+                                         BSON("ping" << 5)};
+
+    ReadAheadSEP sep(first.size() + pipelined.size());
+    auto tla = makeAndStartTL(&sep);
+
+    TimeoutConnector connector(tla->listenerPort(), false);
+    connector.sendMessages(first);
+    connector.sendMessages(pipelined);
+
+    ASSERT_TRUE(sep.waitForTimeout(Milliseconds{10000}));
+    ASSERT_EQ(sep.received.size(), first.size() + pipelined.size());
+    ASSERT_BSONOBJ_EQ(sep.received[0], first[0]);
+    for (size_t i = 0; i < pipelined.size(); ++i) {
+        ASSERT_BSONOBJ_EQ(sep.received[i + 1], pipelined[i]);
+    }
+
+    tla->shutdown();
+}
+
 }  // namespace
 }  // namespace mongo
@@ -0,0 +1,324 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kExecutor
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/work_stealing_thread_pool.h"
+
+#include <fmt/format.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "mongo/base/status.h"
+#include "mongo/logv2/log.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/idle_thread_block.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/errno_util.h"
+
+namespace mongo {
+
+namespace {
+
+using namespace fmt::literals;
+
+// Identifies the pool and run queue owned by the current thread, if it is a pool worker.
+thread_local const WorkStealingThreadPool* currentPool = nullptr;
+thread_local size_t currentWorkerIndex = 0;
+
+}  // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(Options options) : _options(std::move(options)) {
+    invariant(_options.numWorkers > 0);
+    _workers.reserve(_options.numWorkers);
+    for (size_t i = 0; i < _options.numWorkers; ++i) {
+        _workers.emplace_back(std::make_unique<Worker>());
+    }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+    shutdown();
+
+    bool needsJoin = [&] {
+        stdx::lock_guard<Latch> lk(_mutex);
+        return _state == joinRequired;
+    }();
+    if (needsJoin) {
+        join();
+    }
+
+    invariant(_numPendingTasks.load() == 0);
+}
+
+void WorkStealingThreadPool::startup() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (_state != preStart) {
+        LOGV2_FATAL(5933001,
+                    "Attempted to start pool {poolName}, but it has already started",
+                    "Attempted to start pool that has already started",
+                    "poolName"_attr = _options.poolName);
+    }
+    _state = running;
+    _started = true;
+    _stateChange.notify_all();
+
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        _workers[i]->thread = stdx::thread([this, i] { _workerThreadBody(i); });
+    }
+}
+
+void WorkStealingThreadPool::shutdown() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (_state != preStart && _state != running) {
+        return;
+    }
+
+    _state = joinRequired;
+    _shutdownRequested.store(true);
+    _stateChange.notify_all();
+    _workAvailable.notify_all();
+}
+
+void WorkStealingThreadPool::join() {
+    stdx::unique_lock<Latch> lk(_mutex);
+    _stateChange.wait(lk, [this] { return _state != preStart && _state != running; });
+    if (_state != joinRequired) {
+        LOGV2_FATAL(5933002,
+                    "Attempted to join pool {poolName} more than once",
+                    "Attempted to join pool more than once",
+                    "poolName"_attr = _options.poolName);
+    }
+    _state = joining;
+    const bool started = _started;
+    lk.unlock();
+
+    if (started) {
+        // The workers drain every queue before exiting.
+        for (auto& worker : _workers) {
+            worker->thread.join();
+        }
+    } else {
+        // Tasks cannot be run inline because they can create OperationContexts and the join()
+        // caller may already have one associated with the thread.
+        stdx::thread drainThread([this] {
+            const auto threadName = "{}-drain"_format(_options.poolName);
+            setThreadName(threadName);
+            if (_options.onCreateThread) {
+                _options.onCreateThread(threadName);
+            }
+            while (auto task = _takeTask(0)) {
+                _runTask(std::move(task));
+            }
+        });
+        drainThread.join();
+    }
+
+    lk.lock();
+    invariant(_state == joining);
+    _state = shutdownComplete;
+    _stateChange.notify_all();
+}
+
+void WorkStealingThreadPool::schedule(Task task) {
+    if (_shutdownRequested.load()) {
+        task(Status(ErrorCodes::ShutdownInProgress,
+                    "Shutdown of thread pool {} in progress"_format(_options.poolName)));
+        return;
+    }
+
+    if (auto index = _currentWorkerIndex()) {
+        // Keep the task with the worker that scheduled it. This worker will pick it up as soon as
+        // its current task returns, unless an idle worker gets to it first. It also drains its own
+        // queue before exiting, so the task cannot be stranded by a concurrent shutdown().
+        auto& worker = *_workers[*index];
+        stdx::lock_guard<Latch> lk(worker.mutex);
+        worker.queue.emplace_back(std::move(task));
+        _numPendingTasks.fetchAndAdd(1);
+    } else {
+        // Hold '_mutex' so that shutdown() cannot let the workers exit between the check below and
+        // the task becoming visible in a queue.
+        stdx::unique_lock<Latch> lk(_mutex);
+        if (_state != preStart && _state != running) {
+            lk.unlock();
+            task(Status(ErrorCodes::ShutdownInProgress,
+                        "Shutdown of thread pool {} in progress"_format(_options.poolName)));
+            return;
+        }
+
+        auto& worker = *_workers[_nextQueue.fetchAndAdd(1) % _workers.size()];
+        stdx::lock_guard<Latch> workerLk(worker.mutex);
+        worker.queue.emplace_back(std::move(task));
+        _numPendingTasks.fetchAndAdd(1);
+    }
+
+    // Pairs with the increment of '_numSleepingWorkers' in _workerThreadBody(): either we see the
+    // sleeper, or it sees the task we just queued and does not go to sleep.
+    if (_numSleepingWorkers.load() > 0) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _workAvailable.notify_one();
+    }
+}
+
+WorkStealingThreadPool::Stats WorkStealingThreadPool::getStats() const {
+    Stats stats;
+    stats.numWorkers = _workers.size();
+    stats.numPendingTasks = _numPendingTasks.load();
+    stats.numLocalTasks = _numLocalTasks.load();
+    stats.numStolenTasks = _numStolenTasks.load();
+    return stats;
+}
+
+boost::optional<size_t> WorkStealingThreadPool::_currentWorkerIndex() const {
+    if (currentPool != this) {
+        return boost::none;
+    }
+    return currentWorkerIndex;
+}
+
+void WorkStealingThreadPool::_workerThreadBody(size_t index) noexcept {
+    const auto threadName = "{}-{}"_format(_options.poolName, index);
+    setThreadName(threadName);
+    currentPool = this;
+    currentWorkerIndex = index;
+    if (_options.pinWorkersToCores) {
+        _pinToCore(index);
+    }
+    if (_options.onCreateThread) {
+        _options.onCreateThread(threadName);
+    }
+    LOGV2_DEBUG(5933003,
+                1,
+                "Starting worker thread",
+                "threadName"_attr = threadName,
+                "poolName"_attr = _options.poolName);
+
+    while (true) {
+        if (auto task = _takeTask(index)) {
+            _runTask(std::move(task));
+            continue;
+        }
+
+        stdx::unique_lock<Latch> lk(_mutex);
+        if (_state != running && _numPendingTasks.load() == 0) {
+            break;
+        }
+
+        _numSleepingWorkers.fetchAndAdd(1);
+        {
+            MONGO_IDLE_THREAD_BLOCK;
+            _workAvailable.wait(
+                lk, [&] { return _numPendingTasks.load() > 0 || _state != running; });
+        }
+        _numSleepingWorkers.fetchAndSubtract(1);
+    }
+
+    currentPool = nullptr;
+    LOGV2_DEBUG(5933004,
+                1,
+                "Shutting down worker thread",
+                "threadName"_attr = threadName,
+                "poolName"_attr = _options.poolName);
+}
+
+WorkStealingThreadPool::Task WorkStealingThreadPool::_takeTask(size_t index) {
+    {
+        auto& own = *_workers[index];
+        stdx::lock_guard<Latch> lk(own.mutex);
+        if (!own.queue.empty()) {
+            auto task = std::move(own.queue.front());
+            own.queue.pop_front();
+            _numPendingTasks.fetchAndSubtract(1);
+            _numLocalTasks.fetchAndAdd(1);
+            return task;
+        }
+    }
+
+    // Steal the most recently queued task of a neighbour, leaving it the older ones, which are
+    // the likeliest to still have their state in its cache.
+    for (size_t i = 1; i < _workers.size(); ++i) {
+        auto& victim = *_workers[(index + i) % _workers.size()];
+        stdx::lock_guard<Latch> lk(victim.mutex);
+        if (!victim.queue.empty()) {
+            auto task = std::move(victim.queue.back());
+            victim.queue.pop_back();
+            _numPendingTasks.fetchAndSubtract(1);
+            _numStolenTasks.fetchAndAdd(1);
+            return task;
+        }
+    }
+
+    return {};
+}
+
+void WorkStealingThreadPool::_runTask(Task task) noexcept {
+    // If the task throws, its destructor runs before the exception hits the noexcept boundary.
+    task(Status::OK());
+}
+
+void WorkStealingThreadPool::_pinToCore(size_t index) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        LOGV2_WARNING(5933005,
+                      "Failed to read CPU affinity for pool worker",
+                      "poolName"_attr = _options.poolName,
+                      "error"_attr = errnoWithDescription());
+        return;
+    }
+
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            cpus.push_back(cpu);
+        }
+    }
+    if (cpus.empty()) {
+        return;
+    }
+
+    cpu_set_t target;
+    CPU_ZERO(&target);
+    CPU_SET(cpus[index % cpus.size()], &target);
+    if (int err = pthread_setaffinity_np(pthread_self(), sizeof(target), &target)) {
+        LOGV2_WARNING(5933006,
+                      "Failed to pin pool worker to a core",
+                      "poolName"_attr = _options.poolName,
+                      "cpu"_attr = cpus[index % cpus.size()],
+                      "error"_attr = errnoWithDescription(err));
+    }
+#endif
+}
+
+}  // namespace mongo
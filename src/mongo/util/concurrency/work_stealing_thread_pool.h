@@ -0,0 +1,158 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/util/concurrency/thread_pool_interface.h"
+
+namespace mongo {
+
+/**
+ * A thread pool with a fixed number of workers, each of which owns a run queue.
+ *
+ * Tasks scheduled from one of the pool's own workers go onto that worker's queue, so that a chain
+ * of continuations keeps running on the same thread (and, if the workers are pinned, the same
+ * core) with its state still warm in the cache. Tasks scheduled from outside the pool are spread
+ * over the queues round-robin. A worker whose queue is empty steals from the back of the other
+ * workers' queues before going to sleep.
+ *
+ * Since the number of workers never grows, a task that blocks for a long time takes its worker out
+ * of rotation; callers whose tasks may block on each other should use ThreadPool instead.
+ */
+class WorkStealingThreadPool final : public ThreadPoolInterface {
+public:
+    struct Options {
+        // Name of the pool, also used as the prefix for the names of its worker threads.
+        std::string poolName = "WorkStealingThreadPool";
+
+        // Number of worker threads, which are all started by startup(). Must be at least one.
+        size_t numWorkers = 1;
+
+        // If true, worker i is bound to the i-th CPU this process is allowed to run on, wrapping
+        // around if there are more workers than CPUs. Only supported on Linux; ignored elsewhere.
+        bool pinWorkersToCores = false;
+
+        // If callable, called on each worker thread before it begins consuming tasks.
+        std::function<void(const std::string&)> onCreateThread;
+    };
+
+    struct Stats {
+        size_t numWorkers = 0;
+
+        // The number of tasks waiting to be executed across all run queues.
+        size_t numPendingTasks = 0;
+
+        // The number of tasks that were run by the worker whose queue they were scheduled onto.
+        size_t numLocalTasks = 0;
+
+        // The number of tasks that were run by a worker stealing them from another worker's queue.
+        size_t numStolenTasks = 0;
+    };
+
+    explicit WorkStealingThreadPool(Options options);
+
+    WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+    WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+    ~WorkStealingThreadPool() override;
+
+    // from OutOfLineExecutor (base of ThreadPoolInterface)
+    void schedule(Task task) override;
+
+    // from ThreadPoolInterface
+    void startup() override;
+    void shutdown() override;
+    void join() override;
+
+    Stats getStats() const;
+
+private:
+    enum LifecycleState { preStart, running, joinRequired, joining, shutdownComplete };
+
+    struct Worker {
+        mutable Mutex mutex = MONGO_MAKE_LATCH("WorkStealingThreadPool::Worker::mutex");
+        std::deque<Task> queue;
+        stdx::thread thread;
+    };
+
+    /**
+     * Returns the index of the calling thread's worker if it belongs to this pool.
+     */
+    boost::optional<size_t> _currentWorkerIndex() const;
+
+    void _workerThreadBody(size_t index) noexcept;
+
+    /**
+     * Takes a task from the front of worker 'index''s own queue or, failing that, from the back of
+     * another worker's queue. Returns an empty task if every queue is empty.
+     */
+    Task _takeTask(size_t index);
+
+    void _runTask(Task task) noexcept;
+
+    void _pinToCore(size_t index);
+
+    const Options _options;
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    // Total number of queued tasks. Only modified under the mutex of the queue being pushed to or
+    // popped from.
+    AtomicWord<size_t> _numPendingTasks{0};
+
+    // Number of workers asleep on '_workAvailable', so that schedule() only takes '_mutex' to wake
+    // one of them when there is someone to wake.
+    AtomicWord<size_t> _numSleepingWorkers{0};
+    AtomicWord<size_t> _nextQueue{0};
+    AtomicWord<size_t> _numLocalTasks{0};
+    AtomicWord<size_t> _numStolenTasks{0};
+
+    // Guards the lifecycle state and is the mutex idle workers sleep on.
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("WorkStealingThreadPool::_mutex");
+    stdx::condition_variable _workAvailable;
+    stdx::condition_variable _stateChange;
+    LifecycleState _state = preStart;
+    bool _started = false;
+
+    // Set by shutdown(). Lets schedule() reject work without taking '_mutex'.
+    AtomicWord<bool> _shutdownRequested{false};
+};
+
+}  // namespace mongo
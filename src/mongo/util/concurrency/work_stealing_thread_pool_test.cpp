@@ -0,0 +1,136 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/work_stealing_thread_pool.h"
+
+#include "mongo/base/init.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/unittest/barrier.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/notification.h"
+#include "mongo/util/concurrency/thread_pool_test_common.h"
+
+namespace mongo {
+namespace {
+
+MONGO_INITIALIZER(WorkStealingThreadPoolCommonTests)(InitializerContext*) {
+    addTestsForThreadPool("WorkStealingThreadPoolCommon", [] {
+        WorkStealingThreadPool::Options options;
+        options.numWorkers = 2;
+        return std::make_unique<WorkStealingThreadPool>(std::move(options));
+    });
+}
+
+WorkStealingThreadPool::Options makeOptions(size_t numWorkers) {
+    WorkStealingThreadPool::Options options;
+    options.poolName = "WorkStealingThreadPoolTest";
+    options.numWorkers = numWorkers;
+    return options;
+}
+
+TEST(WorkStealingThreadPoolTest, AllWorkersRunTasksConcurrently) {
+    constexpr size_t kNumWorkers = 4;
+    WorkStealingThreadPool pool(makeOptions(kNumWorkers));
+
+    // Every task blocks until all of them are running, which requires one worker per task.
+    unittest::Barrier barrier(kNumWorkers);
+    for (size_t i = 0; i < kNumWorkers; ++i) {
+        pool.schedule([&](Status status) {
+            ASSERT_OK(status);
+            barrier.countDownAndWait();
+        });
+    }
+
+    pool.startup();
+    pool.shutdown();
+    pool.join();
+
+    ASSERT_EQ(pool.getStats().numPendingTasks, 0UL);
+}
+
+TEST(WorkStealingThreadPoolTest, IdleWorkerStealsFromBlockedWorker) {
+    WorkStealingThreadPool pool(makeOptions(2));
+    pool.startup();
+
+    // The continuation lands on the queue of the worker running the first task, which then blocks
+    // until the continuation has run. Only the other worker can get to it.
+    Notification<void> continuationRan;
+    Notification<void> firstTaskDone;
+    pool.schedule([&](Status status) {
+        ASSERT_OK(status);
+        pool.schedule([&](Status status) {
+            ASSERT_OK(status);
+            continuationRan.set();
+        });
+        continuationRan.get();
+        firstTaskDone.set();
+    });
+
+    firstTaskDone.get();
+    pool.shutdown();
+    pool.join();
+
+    // The first task may or may not have been stolen too, depending on which worker woke for it.
+    auto stats = pool.getStats();
+    ASSERT_GTE(stats.numStolenTasks, 1UL);
+    ASSERT_EQ(stats.numLocalTasks + stats.numStolenTasks, 2UL);
+}
+
+TEST(WorkStealingThreadPoolTest, TasksScheduledFromWorkerStayOnItsQueue) {
+    WorkStealingThreadPool pool(makeOptions(1));
+    pool.startup();
+
+    // With a single worker there is nobody to steal, so every task must have been run off the
+    // queue it was scheduled onto.
+    constexpr size_t kChainLength = 100;
+    AtomicWord<size_t> remaining{kChainLength};
+    Notification<void> done;
+    std::function<void(Status)> step = [&](Status status) {
+        ASSERT_OK(status);
+        if (remaining.subtractAndFetch(1) == 0) {
+            done.set();
+            return;
+        }
+        pool.schedule(step);
+    };
+    pool.schedule(step);
+
+    done.get();
+    pool.shutdown();
+    pool.join();
+
+    auto stats = pool.getStats();
+    ASSERT_EQ(stats.numLocalTasks, kChainLength);
+    ASSERT_EQ(stats.numStolenTasks, 0UL);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,223 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kControl
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/numa_placement.h"
+
+#include <algorithm>
+#include <fstream>
+
+#ifdef __linux__
+#include <boost/filesystem.hpp>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "mongo/base/parse_number.h"
+#include "mongo/logv2/log.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/static_immortal.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace {
+
+#ifdef __linux__
+const char kNodeDirectory[] = "/sys/devices/system/node";
+
+std::vector<NumaPlacement::Node> discoverNodes() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        LOGV2_WARNING(5933202,
+                      "Failed to read CPU affinity, not placing threads on NUMA nodes",
+                      "error"_attr = errnoWithDescription());
+        return {};
+    }
+
+    std::vector<NumaPlacement::Node> nodes;
+    boost::system::error_code ec;
+    for (boost::filesystem::directory_iterator it(kNodeDirectory, ec), end; !ec && it != end;
+         it.increment(ec)) {
+        auto name = it->path().filename().string();
+        int id;
+        if (!StringData(name).startsWith("node") ||
+            !NumberParser{}(StringData(name).substr(4), &id).isOK()) {
+            continue;
+        }
+
+        std::ifstream file((it->path() / "cpulist").string());
+        std::string cpuList;
+        if (!std::getline(file, cpuList)) {
+            continue;
+        }
+
+        NumaPlacement::Node node{id, {}};
+        for (int cpu : NumaPlacement::parseCpuList(cpuList)) {
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+                node.cpus.push_back(cpu);
+            }
+        }
+        if (!node.cpus.empty()) {
+            nodes.push_back(std::move(node));
+        }
+    }
+
+    std::sort(nodes.begin(), nodes.end(), [](const auto& a, const auto& b) { return a.id < b.id; });
+    return nodes;
+}
+#else
+std::vector<NumaPlacement::Node> discoverNodes() {
+    return {};
+}
+#endif
+
+}  // namespace
+
+NumaPlacement::ThreadBinding::ThreadBinding(NumaPlacement* placement, size_t nodeIndex)
+    : _placement(placement), _nodeIndex(nodeIndex) {
+    auto& stats = _placement->_stats[_nodeIndex];
+    stats.boundThreads.fetchAndAdd(1);
+    stats.totalBoundThreads.fetchAndAdd(1);
+}
+
+NumaPlacement::ThreadBinding::ThreadBinding(ThreadBinding&& other)
+    : _placement(std::exchange(other._placement, nullptr)), _nodeIndex(other._nodeIndex) {}
+
+NumaPlacement::ThreadBinding& NumaPlacement::ThreadBinding::operator=(ThreadBinding&& other) {
+    // Our previous binding, if any, is released along with 'released'.
+    ThreadBinding released(std::move(other));
+    std::swap(_placement, released._placement);
+    std::swap(_nodeIndex, released._nodeIndex);
+    return *this;
+}
+
+NumaPlacement::ThreadBinding::~ThreadBinding() {
+    if (_placement) {
+        _placement->_stats[_nodeIndex].boundThreads.fetchAndSubtract(1);
+        _placement = nullptr;
+    }
+}
+
+NumaPlacement::NumaPlacement(std::vector<Node> nodes)
+    : _nodes(std::move(nodes)), _stats(std::make_unique<NodeStats[]>(_nodes.size())) {}
+
+NumaPlacement& NumaPlacement::get() {
+    static StaticImmortal<NumaPlacement> placement(discoverNodes());
+    return *placement;
+}
+
+std::vector<int> NumaPlacement::parseCpuList(StringData cpuList) {
+    std::vector<int> cpus;
+    while (!cpuList.empty()) {
+        auto comma = cpuList.find(',');
+        auto range = cpuList.substr(0, comma);
+        cpuList = comma == std::string::npos ? StringData() : cpuList.substr(comma + 1);
+
+        auto dash = range.find('-');
+        int first;
+        int last;
+        if (!NumberParser{}(range.substr(0, dash), &first).isOK()) {
+            continue;
+        }
+        if (dash == std::string::npos) {
+            last = first;
+        } else if (!NumberParser{}(range.substr(dash + 1), &last).isOK()) {
+            continue;
+        }
+
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+NumaPlacement::ThreadBinding NumaPlacement::bindCurrentThread() {
+    if (_nodes.size() < 2) {
+        return {};
+    }
+
+    auto nodeIndex = _pickNode();
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : _nodes[nodeIndex].cpus) {
+        CPU_SET(cpu, &cpus);
+    }
+    if (int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) {
+        LOGV2_WARNING(5933203,
+                      "Failed to bind thread to NUMA node",
+                      "node"_attr = _nodes[nodeIndex].id,
+                      "error"_attr = errnoWithDescription(err));
+        return {};
+    }
+    return ThreadBinding(this, nodeIndex);
+#else
+    return {};
+#endif
+}
+
+size_t NumaPlacement::_pickNode() const {
+    size_t best = 0;
+    for (size_t i = 1; i < _nodes.size(); ++i) {
+        if (_stats[i].boundThreads.load() < _stats[best].boundThreads.load()) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+void NumaPlacement::appendStats(BSONObjBuilder* builder) const {
+    BSONArrayBuilder nodesBuilder(builder->subarrayStart("nodes"));
+    for (size_t i = 0; i < _nodes.size(); ++i) {
+        const auto& node = _nodes[i];
+        BSONObjBuilder nodeBuilder(nodesBuilder.subobjStart());
+        nodeBuilder.append("id", node.id);
+        nodeBuilder.append("cpus", static_cast<int>(node.cpus.size()));
+        nodeBuilder.append("boundThreads", _stats[i].boundThreads.load());
+        nodeBuilder.append("totalBoundThreads", _stats[i].totalBoundThreads.load());
+
+#ifdef __linux__
+        // The pages the kernel allocated on this node for the whole host, and how many of them
+        // were wanted elsewhere or came from elsewhere.
+        std::ifstream file(str::stream() << kNodeDirectory << "/node" << node.id << "/numastat");
+        std::string name;
+        long long pages;
+        while (file >> name >> pages) {
+            nodeBuilder.append(name, pages);
+        }
+#endif
+    }
+}
+
+}  // namespace mongo
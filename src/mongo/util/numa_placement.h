@@ -0,0 +1,115 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+/**
+ * Places threads on the NUMA nodes of the host. A thread bound to a node only runs on that node's
+ * CPUs, so under the kernel's default local allocation policy the memory it first touches,
+ * including the spans tcmalloc carves its thread cache from, comes from that node too.
+ *
+ * The nodes are read from sysfs on Linux, limited to the CPUs this process may run on. Elsewhere,
+ * or on a host with a single node, binding does nothing.
+ */
+class NumaPlacement {
+public:
+    struct Node {
+        int id;
+        std::vector<int> cpus;
+    };
+
+    /**
+     * Counts the thread that created it against its node until destroyed.
+     */
+    class ThreadBinding {
+    public:
+        ThreadBinding() = default;
+        ThreadBinding(NumaPlacement* placement, size_t nodeIndex);
+        ThreadBinding(ThreadBinding&& other);
+        ThreadBinding& operator=(ThreadBinding&& other);
+        ~ThreadBinding();
+
+        bool isBound() const {
+            return _placement;
+        }
+
+    private:
+        NumaPlacement* _placement = nullptr;
+        size_t _nodeIndex = 0;
+    };
+
+    explicit NumaPlacement(std::vector<Node> nodes);
+
+    /**
+     * Returns the placement for the nodes of this host.
+     */
+    static NumaPlacement& get();
+
+    /**
+     * Parses a sysfs CPU list such as "0-3,8,10-11".
+     */
+    static std::vector<int> parseCpuList(StringData cpuList);
+
+    const std::vector<Node>& nodes() const {
+        return _nodes;
+    }
+
+    /**
+     * Binds the calling thread to the node with the fewest bound threads. Returns an unbound
+     * ThreadBinding if there is only one node or the thread could not be bound.
+     */
+    ThreadBinding bindCurrentThread();
+
+    /**
+     * Appends, for each node, its bound threads and the kernel's allocation counters for it.
+     */
+    void appendStats(BSONObjBuilder* builder) const;
+
+private:
+    struct NodeStats {
+        AtomicWord<long long> boundThreads;
+        AtomicWord<long long> totalBoundThreads;
+    };
+
+    size_t _pickNode() const;
+
+    const std::vector<Node> _nodes;
+    std::unique_ptr<NodeStats[]> _stats;
+};
+
+}  // namespace mongo
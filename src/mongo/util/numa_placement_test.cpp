@@ -0,0 +1,80 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/numa_placement.h"
+
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+TEST(NumaPlacementTest, ParseCpuList) {
+    ASSERT(NumaPlacement::parseCpuList("").empty());
+    ASSERT(NumaPlacement::parseCpuList("0") == std::vector<int>({0}));
+    ASSERT(NumaPlacement::parseCpuList("0-3,8,10-11") == std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+}
+
+TEST(NumaPlacementTest, ParseCpuListSkipsMalformedRanges) {
+    ASSERT(NumaPlacement::parseCpuList("x,2,3-y,5-6") == std::vector<int>({2, 5, 6}));
+}
+
+TEST(NumaPlacementTest, BindingsAreCountedUntilReleased) {
+    NumaPlacement placement({{0, {0, 1}}, {1, {2, 3}}});
+
+    auto boundThreads = [&](size_t nodeIndex) {
+        BSONObjBuilder builder;
+        placement.appendStats(&builder);
+        auto nodes = builder.obj()["nodes"].Array();
+        return nodes[nodeIndex]["boundThreads"].numberLong();
+    };
+
+    {
+        NumaPlacement::ThreadBinding first(&placement, 1);
+        ASSERT(first.isBound());
+        ASSERT_EQ(boundThreads(0), 0);
+        ASSERT_EQ(boundThreads(1), 1);
+
+        NumaPlacement::ThreadBinding second;
+        ASSERT_FALSE(second.isBound());
+        second = std::move(first);
+        ASSERT_FALSE(first.isBound());
+        ASSERT_EQ(boundThreads(1), 1);
+    }
+    ASSERT_EQ(boundThreads(1), 0);
+}
+
+TEST(NumaPlacementTest, SingleNodeDoesNotBind) {
+    NumaPlacement placement({{0, {0, 1, 2, 3}}});
+    ASSERT_FALSE(placement.bindCurrentThread().isBound());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -42,6 +42,7 @@
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/service_context.h"
 #include "mongo/transport/service_entry_point.h"
+#include "mongo/util/numa_placement.h"
 #include "mongo/util/tcmalloc_parameters_gen.h"
 
 namespace mongo {
@@ -169,6 +170,11 @@ public:
             builder.append("formattedString", buffer);
         }
 
+        if (auto& placement = NumaPlacement::get(); placement.nodes().size() > 1) {
+            BSONObjBuilder sub(builder.subobjStart("numa"));
+            placement.appendStats(&sub);
+        }
+
         return builder.obj();
     }
 